@@ -85,31 +85,15 @@ foreach (var glyph_element in glyph_elements)
 }
 
 //////////////////////////////////////////////////////////////////////
-// make a lookup table for the graphics
+// glyphs sorted by code point, font.cpp binary searches them (no hash table, see tools/asset_compiler for that)
 
-var lookup = new int[256];
-var advance = new int[256];
-
-for (int i = 0; i < lookup.Length; i++)
-{
-    lookup[i] = -1;
-    advance[i] = 0;
-}
-
-foreach (var glyph in glyphs)
-{
-    if (glyph.image_count != 0)
-    {
-        lookup[glyph.c] = glyph.graphic_base;
-    }
-    advance[glyph.c] = glyph.advance;
-}
+glyphs.Sort((a, b) => a.c.CompareTo(b.c));
 
 //////////////////////////////////////////////////////////////////////
 
 StreamWriter output_c_file = new(output_c_filename);
 
-output_c_file.WriteLine($"// FONT: {font_name} has {graphics.Count} graphics");
+output_c_file.WriteLine($"// FONT: {font_name} has {graphics.Count} graphics, {glyphs.Count} glyphs");
 output_c_file.WriteLine();
 output_c_file.WriteLine("// struct font_graphic {");
 output_c_file.WriteLine("//     int8_t offset_x;");
@@ -120,58 +104,35 @@ output_c_file.WriteLine("//     uint8_t width;");
 output_c_file.WriteLine("//     uint8_t height;");
 output_c_file.WriteLine("// };");
 output_c_file.WriteLine();
-output_c_file.WriteLine("// struct font_data {");
-output_c_file.WriteLine("//     font_graphic *graphics;");
-output_c_file.WriteLine("//     int16_t *lookup;");
-output_c_file.WriteLine("//     uint8_t *advance;");
-output_c_file.WriteLine("//     int height;");
-output_c_file.WriteLine("//     int num_graphics;");
-output_c_file.WriteLine("//     int num_lookups;");
-output_c_file.WriteLine("//     int num_advances;");
+output_c_file.WriteLine("// struct font_glyph {");
+output_c_file.WriteLine("//     uint32_t codepoint;");
+output_c_file.WriteLine("//     int16_t graphic;");
+output_c_file.WriteLine("//     uint8_t advance;");
+output_c_file.WriteLine("//     uint8_t reserved;");
 output_c_file.WriteLine("// };");
 output_c_file.WriteLine();
 
-int columns = 16;
-
-output_c_file.WriteLine($"font_graphic {font_name}_graphics[{graphics.Count}] = {{");
+output_c_file.WriteLine($"font_graphic const {font_name}_graphics[{graphics.Count}] = {{");
 foreach (var g in graphics)
 {
     output_c_file.WriteLine($"    {{ {g.offset_x}, {g.offset_y}, {g.x}, {g.y}, {g.width}, {g.height} }},");
 }
 output_c_file.WriteLine("};");
 output_c_file.WriteLine();
-output_c_file.Write($"int16_t {font_name}_lookup[{lookup.Length}] = {{");
-for (int index = 0; index < lookup.Length; index++)
-{
-    var sep = "";
-    if ((index % columns) == 0)
-    {
-        sep = "\n    ";
-    }
-    output_c_file.Write($"{sep}{lookup[index],3},");
-}
-output_c_file.WriteLine("\n};");
-output_c_file.WriteLine();
-output_c_file.Write($"uint8_t {font_name}_advance[{lookup.Length}] = {{");
-for (int index = 0; index < lookup.Length; index++)
+output_c_file.WriteLine($"font_glyph const {font_name}_glyphs[{glyphs.Count}] = {{");
+foreach (var glyph in glyphs)
 {
-    var sep = "";
-    if ((index % columns) == 0)
-    {
-        sep = "\n    ";
-    }
-    output_c_file.Write($"{sep}{advance[index],3},");
+    int graphic = glyph.image_count != 0 ? glyph.graphic_base : -1;
+    output_c_file.WriteLine($"    {{ {glyph.c}, {graphic}, {glyph.advance}, 0 }},");
 }
-output_c_file.WriteLine("\n};");
+output_c_file.WriteLine("};");
 output_c_file.WriteLine();
 output_c_file.WriteLine($"font_data {font_name} = {{");
-output_c_file.WriteLine($"    {font_name}_graphics,");
-output_c_file.WriteLine($"    {font_name}_lookup,");
-output_c_file.WriteLine($"    {font_name}_advance,");
-output_c_file.WriteLine($"    {height}, // height");
-output_c_file.WriteLine($"    {graphics.Count}, // num_graphics");
-output_c_file.WriteLine($"    {lookup.Length}, // num_lookups");
-output_c_file.WriteLine($"    {advance.Length} // num_advances");
+output_c_file.WriteLine($"    .graphics = {font_name}_graphics,");
+output_c_file.WriteLine($"    .glyphs = {font_name}_glyphs,");
+output_c_file.WriteLine($"    .height = {height},");
+output_c_file.WriteLine($"    .num_graphics = {graphics.Count},");
+output_c_file.WriteLine($"    .num_glyphs = {glyphs.Count},");
 output_c_file.WriteLine("};");
 output_c_file.WriteLine();
 output_c_file.WriteLine($"extern const uint8_t {filename}_png_start[] asm(\"_binary_{filename}0_png_start\");");
@@ -184,11 +145,10 @@ output_c_file.Close();
 
 StreamWriter output_h_file = new(output_h_filename);
 
-output_h_file.WriteLine($"// FONT: {font_name} has {graphics.Count} graphics");
+output_h_file.WriteLine($"// FONT: {font_name} has {graphics.Count} graphics, {glyphs.Count} glyphs");
 output_h_file.WriteLine();
-output_h_file.WriteLine($"extern font_graphic {font_name}_graphics[{graphics.Count}];");
-output_h_file.WriteLine($"extern int16_t {font_name}_lookup[{lookup.Length}];");
-output_h_file.WriteLine($"extern uint8_t {font_name}_advance[{lookup.Length}];");
+output_h_file.WriteLine($"extern font_graphic const {font_name}_graphics[{graphics.Count}];");
+output_h_file.WriteLine($"extern font_glyph const {font_name}_glyphs[{glyphs.Count}];");
 output_h_file.WriteLine($"extern font_data {font_name};");
 output_h_file.WriteLine();
 output_h_file.WriteLine($"extern const uint8_t {font_name}_png_start[];");
@@ -1,85 +0,0 @@
-// FONT: Digits_font has 11 graphics
-
-// struct font_graphic {
-//     int8_t offset_x;
-//     int8_t offset_y;
-//     uint8_t x;
-//     uint8_t y;
-//     uint8_t width;
-//     uint8_t height;
-// };
-
-// struct font_data {
-//     font_graphic *graphics;
-//     int16_t *lookup;
-//     uint8_t *advance;
-//     int height;
-//     int num_graphics;
-//     int num_lookups;
-//     int num_advances;
-// };
-
-font_graphic Digits_font_graphics[11] = {
-    { 4, 8, 0, 0, 35, 62 },
-    { 28, 8, 236, 0, 11, 61 },
-    { 4, 8, 35, 0, 35, 62 },
-    { 6, 8, 105, 0, 33, 62 },
-    { 5, 8, 0, 62, 33, 61 },
-    { 5, 8, 204, 0, 32, 62 },
-    { 4, 8, 138, 0, 33, 62 },
-    { 10, 8, 33, 62, 29, 61 },
-    { 4, 8, 70, 0, 35, 62 },
-    { 5, 8, 171, 0, 33, 62 },
-    { 4, 21, 236, 61, 10, 35 },
-};
-
-int16_t Digits_font_lookup[256] = {
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-      0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
-
-uint8_t Digits_font_advance[256] = {
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-     38, 38, 38, 38, 38, 38, 38, 38, 38, 38, 14,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-};
-
-font_data Digits_font = {
-    Digits_font_graphics,
-    Digits_font_lookup,
-    Digits_font_advance,
-    82, // height
-    11, // num_graphics
-    256, // num_lookups
-    256 // num_advances
-};
-
-extern const uint8_t Digits_png_start[] asm("_binary_Digits0_png_start");
-extern const uint8_t Digits_png_end[] asm("_binary_Digits0_png_end");
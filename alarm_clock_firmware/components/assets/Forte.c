@@ -1,142 +0,0 @@
-// FONT: Forte_font has 68 graphics
-
-// struct font_graphic {
-//     int8_t offset_x;
-//     int8_t offset_y;
-//     uint8_t x;
-//     uint8_t y;
-//     uint8_t width;
-//     uint8_t height;
-// };
-
-// struct font_data {
-//     font_graphic *graphics;
-//     int16_t *lookup;
-//     uint8_t *advance;
-//     int height;
-//     int num_graphics;
-//     int num_lookups;
-//     int num_advances;
-// };
-
-font_graphic Forte_font_graphics[68] = {
-    { 0, 0, 95, 170, 17, 32 },
-    { 4, -1, 57, 227, 16, 13 },
-    { 0, 21, 45, 227, 12, 14 },
-    { 0, 15, 84, 227, 13, 9 },
-    { 0, 20, 73, 227, 11, 11 },
-    { 0, 0, 0, 140, 25, 32 },
-    { 0, 0, 37, 172, 19, 31 },
-    { 0, 0, 0, 172, 21, 32 },
-    { 0, 0, 26, 107, 25, 33 },
-    { 0, 0, 50, 140, 23, 32 },
-    { 0, 0, 113, 169, 23, 32 },
-    { 0, 0, 25, 140, 25, 32 },
-    { 0, 0, 73, 170, 22, 32 },
-    { 0, 0, 136, 169, 23, 32 },
-    { 0, 0, 193, 167, 24, 32 },
-    { 0, -1, 74, 137, 20, 33 },
-    { 0, -1, 75, 41, 35, 33 },
-    { 0, -1, 175, 0, 31, 38 },
-    { 0, -1, 60, 74, 29, 33 },
-    { 0, -1, 110, 71, 32, 33 },
-    { 0, -1, 226, 68, 28, 33 },
-    { 0, -1, 51, 107, 23, 33 },
-    { 0, -1, 32, 0, 29, 41 },
-    { 0, -1, 191, 68, 35, 33 },
-    { 0, -1, 89, 104, 27, 33 },
-    { 0, -1, 61, 0, 25, 41 },
-    { 0, -1, 206, 0, 33, 34 },
-    { 0, -1, 94, 137, 19, 33 },
-    { 0, -1, 141, 38, 50, 33 },
-    { 0, -1, 38, 41, 37, 33 },
-    { 0, -1, 0, 74, 30, 33 },
-    { 0, -1, 202, 101, 28, 33 },
-    { 0, -1, 142, 71, 31, 33 },
-    { 0, 0, 113, 137, 29, 32 },
-    { 0, -1, 206, 34, 24, 34 },
-    { 0, -1, 192, 134, 22, 33 },
-    { 0, -1, 30, 74, 30, 33 },
-    { 0, -1, 143, 104, 26, 33 },
-    { 0, -1, 0, 41, 38, 33 },
-    { 0, -1, 141, 0, 34, 38 },
-    { 0, -1, 0, 0, 32, 41 },
-    { 0, -1, 173, 101, 29, 33 },
-    { 0, 7, 112, 201, 27, 25 },
-    { 0, -1, 169, 134, 23, 33 },
-    { 0, 7, 139, 201, 19, 25 },
-    { 0, -1, 116, 104, 27, 33 },
-    { 0, 7, 216, 226, 21, 24 },
-    { 0, -1, 109, 0, 17, 41 },
-    { 0, 7, 0, 107, 26, 33 },
-    { 0, -1, 230, 101, 24, 33 },
-    { 0, -1, 236, 134, 13, 33 },
-    { 0, -1, 126, 0, 15, 40 },
-    { 0, -1, 86, 0, 23, 41 },
-    { 0, -1, 214, 134, 22, 33 },
-    { 0, 7, 159, 199, 36, 28 },
-    { 0, 7, 81, 202, 24, 25 },
-    { 0, 6, 56, 202, 25, 25 },
-    { 0, 7, 142, 137, 26, 32 },
-    { 0, 7, 168, 167, 25, 32 },
-    { 0, 7, 237, 226, 16, 24 },
-    { 0, 7, 195, 199, 21, 28 },
-    { 0, 0, 21, 172, 16, 32 },
-    { 0, 7, 125, 226, 25, 24 },
-    { 0, 6, 105, 226, 20, 25 },
-    { 0, 7, 216, 199, 32, 27 },
-    { 0, 7, 0, 204, 24, 25 },
-    { 0, 7, 217, 167, 24, 32 },
-    { 0, 7, 24, 204, 21, 25 },
-};
-
-int16_t Forte_font_lookup[256] = {
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1,  0,  1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  3,  4, -1,
-      5,  6,  7,  8,  9, 10, 11, 12, 13, 14, -1, -1, -1, -1, -1, 15,
-     -1, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
-     31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, -1, -1, -1, -1, -1,
-     -1, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56,
-     57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
-
-uint8_t Forte_font_advance[256] = {
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-     12, 16, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0, 10, 11,  9,  0,
-     23, 17, 20, 23, 22, 22, 22, 21, 22, 22,  0,  0,  0,  0,  0, 18,
-      0, 32, 29, 27, 30, 27, 22, 28, 33, 26, 23, 30, 17, 48, 35, 28,
-     26, 30, 28, 22, 21, 28, 24, 36, 32, 30, 28,  0,  0,  0,  0,  0,
-      0, 24, 21, 17, 25, 19, 16, 24, 22, 11, 13, 22, 20, 34, 22, 24,
-     24, 24, 14, 20, 15, 23, 19, 30, 22, 22, 19,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-};
-
-font_data Forte_font = {
-    Forte_font_graphics,
-    Forte_font_lookup,
-    Forte_font_advance,
-    44, // height
-    68, // num_graphics
-    256, // num_lookups
-    256 // num_advances
-};
-
-extern const uint8_t Forte_png_start[] asm("_binary_Forte0_png_start");
-extern const uint8_t Forte_png_end[] asm("_binary_Forte0_png_end");
@@ -1,169 +0,0 @@
-// FONT: Segoe_font has 95 graphics
-
-// struct font_graphic {
-//     int8_t offset_x;
-//     int8_t offset_y;
-//     uint8_t x;
-//     uint8_t y;
-//     uint8_t width;
-//     uint8_t height;
-// };
-
-// struct font_data {
-//     font_graphic *graphics;
-//     int16_t *lookup;
-//     uint8_t *advance;
-//     int height;
-//     int num_graphics;
-//     int num_lookups;
-//     int num_advances;
-// };
-
-font_graphic Segoe_font_graphics[95] = {
-    { 2, 12, 27, 67, 7, 20 },
-    { 2, 12, 87, 103, 12, 5 },
-    { 1, 12, 144, 83, 16, 18 },
-    { 2, 9, 24, 0, 13, 26 },
-    { 1, 12, 37, 25, 24, 20 },
-    { 1, 12, 61, 25, 21, 20 },
-    { 2, 12, 108, 103, 5, 5 },
-    { 3, 12, 47, 0, 9, 25 },
-    { 0, 12, 37, 0, 10, 25 },
-    { 1, 12, 15, 102, 12, 11 },
-    { 3, 17, 144, 101, 14, 14 },
-    { 1, 28, 158, 101, 7, 7 },
-    { 2, 22, 113, 103, 8, 4 },
-    { 1, 26, 133, 102, 7, 6 },
-    { 0, 12, 90, 0, 15, 24 },
-    { 1, 12, 118, 63, 16, 20 },
-    { 2, 12, 63, 65, 10, 20 },
-    { 1, 12, 35, 65, 14, 20 },
-    { 2, 12, 14, 67, 13, 20 },
-    { 1, 12, 134, 63, 16, 20 },
-    { 1, 12, 49, 65, 14, 20 },
-    { 1, 12, 150, 63, 16, 20 },
-    { 1, 12, 198, 63, 15, 20 },
-    { 1, 12, 213, 63, 15, 20 },
-    { 1, 12, 74, 64, 15, 20 },
-    { 1, 17, 80, 100, 7, 15 },
-    { 0, 17, 160, 83, 8, 18 },
-    { 3, 17, 183, 98, 14, 15 },
-    { 3, 19, 225, 102, 14, 10 },
-    { 3, 16, 168, 98, 15, 15 },
-    { 0, 12, 228, 82, 13, 20 },
-    { 1, 12, 120, 0, 25, 23 },
-    { 0, 12, 15, 27, 21, 20 },
-    { 2, 12, 18, 47, 17, 20 },
-    { 1, 12, 166, 63, 16, 20 },
-    { 2, 12, 175, 43, 19, 20 },
-    { 2, 12, 241, 82, 13, 20 },
-    { 2, 12, 89, 83, 13, 20 },
-    { 1, 12, 194, 43, 19, 20 },
-    { 2, 12, 82, 44, 19, 20 },
-    { 2, 12, 127, 83, 6, 20 },
-    { 1, 12, 115, 83, 12, 20 },
-    { 2, 12, 36, 45, 19, 20 },
-    { 2, 12, 102, 83, 13, 20 },
-    { 2, 12, 90, 24, 25, 20 },
-    { 2, 12, 232, 42, 20, 20 },
-    { 1, 12, 115, 43, 20, 20 },
-    { 2, 12, 182, 63, 16, 20 },
-    { 1, 12, 145, 0, 22, 23 },
-    { 2, 12, 231, 62, 17, 20 },
-    { 1, 12, 0, 67, 14, 20 },
-    { 0, 12, 213, 43, 18, 20 },
-    { 2, 12, 0, 47, 18, 20 },
-    { 0, 12, 135, 43, 20, 20 },
-    { 0, 12, 120, 23, 30, 20 },
-    { 0, 12, 155, 43, 20, 20 },
-    { 0, 12, 55, 45, 19, 20 },
-    { 1, 12, 101, 63, 17, 20 },
-    { 3, 12, 74, 0, 8, 25 },
-    { 0, 12, 105, 0, 15, 24 },
-    { 1, 12, 82, 0, 8, 25 },
-    { 3, 11, 0, 102, 15, 12 },
-    { 0, 35, 113, 107, 12, 3 },
-    { 0, 10, 99, 103, 9, 5 },
-    { 1, 17, 32, 100, 13, 15 },
-    { 1, 11, 167, 22, 17, 21 },
-    { 1, 17, 45, 100, 12, 15 },
-    { 1, 11, 184, 22, 16, 21 },
-    { 1, 17, 197, 98, 14, 15 },
-    { 1, 11, 241, 0, 12, 21 },
-    { 1, 17, 201, 0, 16, 22 },
-    { 1, 11, 200, 22, 16, 21 },
-    { 0, 10, 233, 0, 8, 22 },
-    { -1, 10, 0, 0, 10, 29 },
-    { 1, 11, 216, 22, 16, 21 },
-    { 1, 11, 241, 21, 6, 21 },
-    { 1, 17, 168, 83, 25, 15 },
-    { 1, 17, 69, 85, 16, 15 },
-    { 1, 17, 0, 87, 16, 15 },
-    { 1, 17, 167, 0, 17, 22 },
-    { 1, 17, 217, 0, 16, 22 },
-    { 1, 17, 69, 100, 11, 15 },
-    { 1, 17, 57, 100, 12, 15 },
-    { 1, 13, 133, 83, 11, 19 },
-    { 1, 17, 16, 87, 16, 15 },
-    { 0, 17, 52, 85, 17, 15 },
-    { 0, 17, 193, 83, 24, 15 },
-    { 0, 17, 34, 85, 18, 15 },
-    { 0, 17, 184, 0, 17, 22 },
-    { 0, 17, 211, 98, 14, 15 },
-    { 2, 12, 56, 0, 9, 25 },
-    { 3, 10, 10, 0, 5, 29 },
-    { 2, 12, 65, 0, 9, 25 },
-    { 3, 20, 239, 102, 15, 7 },
-    { 2, 6, 15, 0, 9, 27 },
-};
-
-int16_t Segoe_font_lookup[256] = {
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-     15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
-     31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46,
-     47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62,
-     63, 64, 65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76, 77, 78,
-     79, 80, 81, 82, 83, 84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
-
-uint8_t Segoe_font_advance[256] = {
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      8, 11, 17, 17, 17, 26, 21, 10, 12, 12, 14, 21,  9, 12,  9, 14,
-     17, 14, 17, 17, 18, 17, 17, 17, 17, 17,  9,  9, 21, 21, 21, 12,
-     28, 22, 20, 18, 22, 16, 16, 21, 23, 10, 15, 20, 16, 29, 24, 22,
-     19, 22, 20, 17, 18, 21, 20, 31, 20, 19, 19, 12, 14, 12, 21, 12,
-     10, 16, 19, 14, 19, 16, 13, 19, 18,  9,  9, 17,  9, 28, 18, 18,
-     19, 19, 13, 14, 12, 18, 17, 25, 18, 17, 15, 12, 12, 12, 21, 19,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-      0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-};
-
-font_data Segoe_font = {
-    Segoe_font_graphics,
-    Segoe_font_lookup,
-    Segoe_font_advance,
-    40, // height
-    95, // num_graphics
-    256, // num_lookups
-    256 // num_advances
-};
-
-extern const uint8_t Segoe_png_start[] asm("_binary_Segoe0_png_start");
-extern const uint8_t Segoe_png_end[] asm("_binary_Segoe0_png_end");
@@ -0,0 +1,318 @@
+//////////////////////////////////////////////////////////////////////
+// RLE and LZ4 block codecs for asset packs
+// Built into the firmware (which only needs the decompressors) and into
+// tools/asset_compiler, so no ESP-IDF dependencies in here.
+
+#include <string.h>
+
+#include "asset_pack_format.h"
+
+//////////////////////////////////////////////////////////////////////
+// RLE: control byte c
+//   c & 0x80: (c & 0x7f) + 1 copies of the pixel which follows
+//   else:     c + 1 literal pixels follow
+
+#define RLE_MAX_COUNT 128
+
+int asset_rle_compress(uint32_t const *src, size_t num_pixels, uint8_t *dst, size_t dst_capacity)
+{
+    size_t out = 0;
+    size_t i = 0;
+
+    while(i < num_pixels) {
+
+        size_t run = 1;
+        while(i + run < num_pixels && run < RLE_MAX_COUNT && src[i + run] == src[i]) {
+            run += 1;
+        }
+
+        if(run >= 2) {
+            if(out + 1 + sizeof(uint32_t) > dst_capacity) {
+                return -1;
+            }
+            dst[out++] = (uint8_t)(0x80 | (run - 1));
+            memcpy(dst + out, src + i, sizeof(uint32_t));
+            out += sizeof(uint32_t);
+            i += run;
+            continue;
+        }
+
+        // literals until the next run of 2 or more starts
+
+        size_t count = 1;
+        while(i + count < num_pixels && count < RLE_MAX_COUNT) {
+            if(i + count + 1 < num_pixels && src[i + count] == src[i + count + 1]) {
+                break;
+            }
+            count += 1;
+        }
+
+        size_t bytes = count * sizeof(uint32_t);
+        if(out + 1 + bytes > dst_capacity) {
+            return -1;
+        }
+        dst[out++] = (uint8_t)(count - 1);
+        memcpy(dst + out, src + i, bytes);
+        out += bytes;
+        i += count;
+    }
+    return (int)out;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int asset_rle_decompress(uint8_t const *src, size_t src_size, uint32_t *dst, size_t num_pixels)
+{
+    uint8_t const *end = src + src_size;
+    size_t out = 0;
+
+    while(src < end) {
+
+        uint8_t c = *src++;
+        size_t count = (c & 0x7f) + 1;
+
+        if(out + count > num_pixels) {
+            return -1;
+        }
+
+        if(c & 0x80) {
+            if(end - src < (ptrdiff_t)sizeof(uint32_t)) {
+                return -1;
+            }
+            uint32_t pixel;
+            memcpy(&pixel, src, sizeof(uint32_t));
+            src += sizeof(uint32_t);
+            for(size_t n = 0; n < count; ++n) {
+                dst[out++] = pixel;
+            }
+        } else {
+            size_t bytes = count * sizeof(uint32_t);
+            if((size_t)(end - src) < bytes) {
+                return -1;
+            }
+            memcpy(dst + out, src, bytes);
+            src += bytes;
+            out += count;
+        }
+    }
+    return (int)(out * sizeof(uint32_t));
+}
+
+//////////////////////////////////////////////////////////////////////
+// LZ4 block format, greedy single probe hash compressor
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5     // last 5 bytes are always literals
+#define LZ4_MATCH_LIMIT 12      // no match can start in the last 12 bytes
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 12
+
+static inline uint32_t lz4_read32(uint8_t const *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static inline uint32_t lz4_hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+//////////////////////////////////////////////////////////////////////
+// 15 in the token then 255s and a remainder
+
+static int lz4_write_length(uint8_t *dst, size_t *out, size_t dst_capacity, size_t length)
+{
+    while(length >= 255) {
+        if(*out >= dst_capacity) {
+            return -1;
+        }
+        dst[(*out)++] = 255;
+        length -= 255;
+    }
+    if(*out >= dst_capacity) {
+        return -1;
+    }
+    dst[(*out)++] = (uint8_t)length;
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// match_length == 0 for the final literals only sequence
+
+static int lz4_write_sequence(uint8_t *dst, size_t *out, size_t dst_capacity, uint8_t const *literals, size_t literal_length, size_t offset, size_t match_length)
+{
+    if(*out >= dst_capacity) {
+        return -1;
+    }
+
+    size_t token_out = (*out)++;
+    uint8_t token = 0;
+
+    if(literal_length >= 15) {
+        token = 15 << 4;
+        if(lz4_write_length(dst, out, dst_capacity, literal_length - 15) != 0) {
+            return -1;
+        }
+    } else {
+        token = (uint8_t)(literal_length << 4);
+    }
+
+    if(*out + literal_length > dst_capacity) {
+        return -1;
+    }
+    memcpy(dst + *out, literals, literal_length);
+    *out += literal_length;
+
+    if(match_length != 0) {
+
+        if(*out + 2 > dst_capacity) {
+            return -1;
+        }
+        dst[(*out)++] = (uint8_t)(offset & 0xff);
+        dst[(*out)++] = (uint8_t)(offset >> 8);
+
+        size_t m = match_length - LZ4_MIN_MATCH;
+        if(m >= 15) {
+            token |= 15;
+            if(lz4_write_length(dst, out, dst_capacity, m - 15) != 0) {
+                return -1;
+            }
+        } else {
+            token |= (uint8_t)m;
+        }
+    }
+    dst[token_out] = token;
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int asset_lz4_compress(uint8_t const *src, size_t src_size, uint8_t *dst, size_t dst_capacity)
+{
+    int32_t table[1 << LZ4_HASH_BITS];
+    for(size_t i = 0; i < (1 << LZ4_HASH_BITS); ++i) {
+        table[i] = -1;
+    }
+
+    size_t out = 0;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    if(src_size > LZ4_MATCH_LIMIT) {
+
+        size_t match_start_limit = src_size - LZ4_MATCH_LIMIT;
+        size_t match_end_limit = src_size - LZ4_LAST_LITERALS;
+
+        while(ip < match_start_limit) {
+
+            uint32_t sequence = lz4_read32(src + ip);
+            uint32_t h = lz4_hash(sequence);
+            int32_t ref = table[h];
+            table[h] = (int32_t)ip;
+
+            if(ref < 0 || ip - ref > LZ4_MAX_OFFSET || lz4_read32(src + ref) != sequence) {
+                ip += 1;
+                continue;
+            }
+
+            size_t length = LZ4_MIN_MATCH;
+            while(ip + length < match_end_limit && src[ref + length] == src[ip + length]) {
+                length += 1;
+            }
+
+            if(lz4_write_sequence(dst, &out, dst_capacity, src + anchor, ip - anchor, ip - ref, length) != 0) {
+                return -1;
+            }
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    if(lz4_write_sequence(dst, &out, dst_capacity, src + anchor, src_size - anchor, 0, 0) != 0) {
+        return -1;
+    }
+    return (int)out;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int asset_lz4_decompress(uint8_t const *src, size_t src_size, uint8_t *dst, size_t dst_size)
+{
+    uint8_t const *ip = src;
+    uint8_t const *src_end = src + src_size;
+    uint8_t *op = dst;
+    uint8_t *dst_end = dst + dst_size;
+
+    while(ip < src_end) {
+
+        uint8_t token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if(literal_length == 15) {
+            uint8_t b;
+            do {
+                if(ip >= src_end) {
+                    return -1;
+                }
+                b = *ip++;
+                literal_length += b;
+            } while(b == 255);
+        }
+
+        if((size_t)(src_end - ip) < literal_length || (size_t)(dst_end - op) < literal_length) {
+            return -1;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // the last sequence has no match
+        if(ip == src_end) {
+            break;
+        }
+
+        if(src_end - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if(offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+
+        size_t match_length = token & 15;
+        if(match_length == 15) {
+            uint8_t b;
+            do {
+                if(ip >= src_end) {
+                    return -1;
+                }
+                b = *ip++;
+                match_length += b;
+            } while(b == 255);
+        }
+        match_length += LZ4_MIN_MATCH;
+
+        if((size_t)(dst_end - op) < match_length) {
+            return -1;
+        }
+
+        uint8_t const *match = op - offset;
+
+        if(offset >= match_length) {
+            memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            // overlapping, repeats the last 'offset' bytes
+            for(size_t n = 0; n < match_length; ++n) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return (int)(op - dst);
+}
@@ -0,0 +1,238 @@
+//////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+
+#include <esp_log.h>
+
+#include "util.h"
+#include "asset_loader.h"
+
+LOG_CONTEXT("asset_loader");
+
+#define ASSET_JOB_BIT_COMPLETE 1
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    int constexpr MAX_JOBS = 64;
+
+    int constexpr LOADER_TASK_STACK_SIZE = 4096;
+    int constexpr LOADER_TASK_PRIORITY = 4;
+
+    enum job_state : uint32_t
+    {
+        job_state_pending = 0,
+        job_state_running = 1,
+        job_state_complete = 2
+    };
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+struct asset_load_job
+{
+    asset_load_function_t function;
+    void *context;
+    esp_err_t result;
+    std::atomic<uint32_t> state;
+    bool finished;    // these two are protected by jobs_mutex, whichever
+    bool released;    // of them happens second gives the slot back
+    EventGroupHandle_t event_group;
+    StaticEventGroup_t event_group_buffer;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    asset_load_job jobs[MAX_JOBS];
+
+    // slots which are free to submit into, given back by asset_loader_release
+
+    asset_load_job *free_jobs[MAX_JOBS];
+    int num_free_jobs = 0;
+
+    SemaphoreHandle_t jobs_mutex;
+
+    // one queue per priority, jobs_pending counts the total queued across both
+
+    QueueHandle_t job_queues[2];
+    SemaphoreHandle_t jobs_pending;
+
+    //////////////////////////////////////////////////////////////////////
+    // run the job if nobody else has started it yet
+
+    bool run_job(asset_load_job *job)
+    {
+        uint32_t expected = job_state_pending;
+
+        if(!job->state.compare_exchange_strong(expected, job_state_running)) {
+            return false;
+        }
+
+        job->result = job->function(job->context);
+        job->state.store(job_state_complete);
+        xEventGroupSetBits(job->event_group, ASSET_JOB_BIT_COMPLETE);
+
+        // it might have been released while it was queued or running
+
+        xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+        job->finished = true;
+        if(job->released) {
+            free_jobs[num_free_jobs++] = job;
+        }
+        xSemaphoreGive(jobs_mutex);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void asset_loader_task(void *)
+    {
+        while(true) {
+
+            xSemaphoreTake(jobs_pending, portMAX_DELAY);
+
+            asset_load_job *job;
+
+            for(QueueHandle_t q : job_queues) {
+                if(xQueueReceive(q, &job, 0) == pdTRUE) {
+                    run_job(job);
+                    break;
+                }
+            }
+        }
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_loader_init()
+{
+    LOG_I("init");
+
+    jobs_mutex = xSemaphoreCreateMutex();
+    ESP_RETURN_IF_NULL(jobs_mutex);
+
+    for(asset_load_job &job : jobs) {
+        job.event_group = xEventGroupCreateStatic(&job.event_group_buffer);
+        free_jobs[num_free_jobs++] = &job;
+    }
+
+    jobs_pending = xSemaphoreCreateCounting(MAX_JOBS, 0);
+    ESP_RETURN_IF_NULL(jobs_pending);
+
+    for(QueueHandle_t &q : job_queues) {
+        q = xQueueCreate(MAX_JOBS, sizeof(asset_load_job *));
+        ESP_RETURN_IF_NULL(q);
+    }
+
+    // one worker per core
+
+    for(int core = 0; core < portNUM_PROCESSORS; ++core) {
+        BaseType_t r = xTaskCreatePinnedToCore(asset_loader_task, "asset_loader", LOADER_TASK_STACK_SIZE, nullptr, LOADER_TASK_PRIORITY, nullptr, core);
+        if(r != pdPASS) {
+            LOG_E("xTaskCreate failed: returned %d", r);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_loader_submit(asset_load_function_t function, void *context, asset_load_priority_t priority, asset_load_handle_t *handle)
+{
+    if(function == nullptr || handle == nullptr || priority < asset_load_priority_high || priority > asset_load_priority_low) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+
+    if(num_free_jobs == 0) {
+        xSemaphoreGive(jobs_mutex);
+        LOG_E("Too many jobs");
+        return ESP_ERR_NO_MEM;
+    }
+
+    asset_load_job *job = free_jobs[--num_free_jobs];
+
+    job->finished = false;
+    job->released = false;
+
+    xSemaphoreGive(jobs_mutex);
+
+    job->function = function;
+    job->context = context;
+    job->result = ESP_OK;
+    job->state.store(job_state_pending);
+    xEventGroupClearBits(job->event_group, ASSET_JOB_BIT_COMPLETE);
+
+    *handle = job;
+
+    xQueueSend(job_queues[priority], &job, portMAX_DELAY);
+    xSemaphoreGive(jobs_pending);
+
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_loader_wait(asset_load_handle_t handle, TickType_t ticks_to_wait)
+{
+    if(handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // if it's still queued, don't wait for a worker to get to it
+
+    if(!run_job(handle)) {
+
+        EventBits_t bits = xEventGroupWaitBits(handle->event_group, ASSET_JOB_BIT_COMPLETE, pdFALSE, pdTRUE, ticks_to_wait);
+
+        if((bits & ASSET_JOB_BIT_COMPLETE) == 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return handle->result;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool asset_loader_is_complete(asset_load_handle_t handle)
+{
+    return handle != nullptr && handle->state.load() == job_state_complete;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_loader_release(asset_load_handle_t handle)
+{
+    if(handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(jobs_mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+
+    if(handle->released) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        handle->released = true;
+        if(handle->finished) {
+            free_jobs[num_free_jobs++] = handle;
+        }
+    }
+    xSemaphoreGive(jobs_mutex);
+    return ret;
+}
@@ -0,0 +1,372 @@
+//////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+
+#include <esp_log.h>
+
+#include "util.h"
+#include "image.h"
+#include "font.h"
+#include "asset_pack.h"
+
+LOG_CONTEXT("asset_pack");
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    bool in_pack(asset_pack_t const *pack, uint32_t offset, uint32_t size)
+    {
+        return offset <= pack->size && size <= pack->size - offset;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t find_entry(asset_pack_t const *pack, char const *name, asset_pack_type_t type, asset_pack_entry_t const **out_entry)
+    {
+        asset_pack_entry_t const *entry;
+        ESP_RETURN_IF_FAILED(asset_pack_find(pack, name, &entry));
+
+        if(entry->type != type) {
+            LOG_E("%s is the wrong type (%d)", name, entry->type);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        if(entry->pixel_format > asset_pack_pixel_format_argb8565) {
+            LOG_E("%s has unsupported pixel format %d", name, entry->pixel_format);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        *out_entry = entry;
+        return ESP_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    struct unpack_context
+    {
+        asset_pack_t const *pack;
+        asset_pack_entry_t const *entry;
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    image_format_t image_format(asset_pack_entry_t const *entry)
+    {
+        switch(entry->pixel_format) {
+        case asset_pack_pixel_format_a8:
+            return image_format_a8;
+        case asset_pack_pixel_format_a4:
+            return image_format_a4;
+        default:
+            return image_format_argb32;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // bytes per pixel in the pack for the 565 formats, 0 for the ones which are stored as they're drawn
+
+    size_t packed_pixel_size(asset_pack_entry_t const *entry)
+    {
+        switch(entry->pixel_format) {
+        case asset_pack_pixel_format_rgb565:
+            return 2;
+        case asset_pack_pixel_format_argb8565:
+            return 3;
+        default:
+            return 0;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the packed pixels are at the end of the buffer, each ARGB32 pixel written
+    // is never past the next packed one to be read so it can go front to back in place
+
+    void expand_rgb565(uint8_t *pixels, size_t num_pixels, size_t pixel_size)
+    {
+        uint8_t const *src = pixels + num_pixels * (sizeof(uint32_t) - pixel_size);
+        uint32_t *dst = reinterpret_cast<uint32_t *>(pixels);
+
+        for(size_t i = num_pixels; i != 0; --i) {
+            uint32_t c = src[0] | (src[1] << 8);
+            uint32_t a = pixel_size == 3 ? src[2] : 0xff;
+            src += pixel_size;
+            uint32_t r = (c >> 11) & 0x1f;
+            uint32_t g = (c >> 5) & 0x3f;
+            uint32_t b = c & 0x1f;
+            *dst++ = (a << 24) | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // image_fill_function_t
+
+    esp_err_t unpack_pixels(void *context, void *pixels, int width, int height)
+    {
+        unpack_context const *ctx = reinterpret_cast<unpack_context const *>(context);
+
+        uint8_t const *src = ctx->pack->data + ctx->entry->data_offset;
+        size_t src_size = ctx->entry->data_size;
+        size_t num_pixels = width * height;
+        size_t raw_size = image_format_stride(image_format(ctx->entry), width) * height;
+
+        // 565 pixels get unpacked into the end of the buffer and expanded from there
+
+        size_t pixel_size = packed_pixel_size(ctx->entry);
+        uint8_t *dst = reinterpret_cast<uint8_t *>(pixels);
+
+        if(pixel_size != 0) {
+            dst += raw_size - num_pixels * pixel_size;
+            raw_size = num_pixels * pixel_size;
+        }
+
+        int got = -1;
+
+        switch(ctx->entry->compression) {
+
+        case asset_pack_compression_none:
+            if(src_size == raw_size) {
+                memcpy(dst, src, raw_size);
+                got = raw_size;
+            }
+            break;
+
+        case asset_pack_compression_rle:
+            // RLE works on 32 bit pixels
+            if(ctx->entry->pixel_format == asset_pack_pixel_format_argb32) {
+                got = asset_rle_decompress(src, src_size, reinterpret_cast<uint32_t *>(pixels), num_pixels);
+            }
+            break;
+
+        case asset_pack_compression_lz4:
+            got = asset_lz4_decompress(src, src_size, dst, raw_size);
+            break;
+
+        default:
+            LOG_E("%s has unknown compression %d", ctx->entry->name, ctx->entry->compression);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+
+        if(got != (int)raw_size) {
+            LOG_E("%s is corrupt", ctx->entry->name);
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        if(pixel_size != 0) {
+            expand_rgb565(reinterpret_cast<uint8_t *>(pixels), num_pixels, pixel_size);
+        }
+        return ESP_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t load_pixels(asset_pack_t const *pack, asset_pack_entry_t const *entry, int *out_image_id)
+    {
+        unpack_context context = { pack, entry };
+
+        // entry->name lives in the pack so it's fine for the image to keep it
+        return image_create(entry->name, image_format(entry), entry->width, entry->height, unpack_pixels, &context, out_image_id);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the cache unpacks it again after each eviction so the context lives as long as the image
+
+    esp_err_t register_pixels(asset_pack_t const *pack, asset_pack_entry_t const *entry, int *out_image_id)
+    {
+        unpack_context *context = (unpack_context *)malloc(sizeof(unpack_context));
+
+        if(context == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        context->pack = pack;
+        context->entry = entry;
+
+        esp_err_t ret = image_register_fill(entry->name, image_format(entry), entry->width, entry->height, unpack_pixels, context, out_image_id);
+
+        if(ret != ESP_OK) {
+            free(context);
+        }
+        return ret;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_pack_open(asset_pack_t *pack, uint8_t const *data, size_t size)
+{
+    if(pack == nullptr || data == nullptr || size < sizeof(asset_pack_header_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_pack_header_t const *header = reinterpret_cast<asset_pack_header_t const *>(data);
+
+    if(header->magic != ASSET_PACK_MAGIC) {
+        LOG_E("Not an asset pack");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(header->version != ASSET_PACK_VERSION) {
+        LOG_E("Asset pack version is %d, expected %d", header->version, ASSET_PACK_VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    pack->data = data;
+    pack->size = size;
+
+    uint16_t hash_table_size = header->hash_table_size;
+
+    if(header->total_size > size || hash_table_size == 0 || (hash_table_size & (hash_table_size - 1)) != 0 ||
+       !in_pack(pack, header->entries_offset, header->num_assets * sizeof(asset_pack_entry_t)) ||
+       !in_pack(pack, header->hash_table_offset, hash_table_size * sizeof(uint16_t))) {
+        LOG_E("Asset pack header is corrupt");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    pack->header = header;
+    pack->entries = reinterpret_cast<asset_pack_entry_t const *>(data + header->entries_offset);
+    pack->hash_table = reinterpret_cast<uint16_t const *>(data + header->hash_table_offset);
+
+    for(int i = 0; i < header->num_assets; ++i) {
+        asset_pack_entry_t const &e = pack->entries[i];
+        if(e.name[ASSET_PACK_NAME_LEN - 1] != 0 || !in_pack(pack, e.data_offset, e.data_size) || !in_pack(pack, e.font_offset, e.font_size)) {
+            LOG_E("Asset pack entry %d is corrupt", i);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    LOG_I("%d assets, %d bytes", header->num_assets, header->total_size);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_pack_find(asset_pack_t const *pack, char const *name, asset_pack_entry_t const **out_entry)
+{
+    if(pack == nullptr || pack->header == nullptr || name == nullptr || out_entry == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t hash = asset_pack_hash(name);
+    uint32_t mask = pack->header->hash_table_size - 1;
+
+    // linear probing, the table is at least twice the number of assets so this is short
+
+    for(uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+
+        uint16_t index = pack->hash_table[slot];
+
+        if(index == ASSET_PACK_HASH_EMPTY || index >= pack->header->num_assets) {
+            break;
+        }
+
+        asset_pack_entry_t const *entry = pack->entries + index;
+
+        if(entry->name_hash == hash && strcmp(entry->name, name) == 0) {
+            *out_entry = entry;
+            return ESP_OK;
+        }
+    }
+    LOG_E("Can't find asset %s", name);
+    return ESP_ERR_NOT_FOUND;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_pack_load_image(asset_pack_t const *pack, char const *name, int *out_image_id)
+{
+    if(out_image_id == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_pack_entry_t const *entry;
+    ESP_RETURN_IF_FAILED(find_entry(pack, name, asset_pack_type_image, &entry));
+
+    return load_pixels(pack, entry, out_image_id);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_pack_register_image(asset_pack_t const *pack, char const *name, int *out_image_id)
+{
+    if(out_image_id == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_pack_entry_t const *entry;
+    ESP_RETURN_IF_FAILED(find_entry(pack, name, asset_pack_type_image, &entry));
+
+    return register_pixels(pack, entry, out_image_id);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_pack_load_font(asset_pack_t const *pack, char const *name, font_handle_t *handle)
+{
+    if(handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_pack_entry_t const *entry;
+    ESP_RETURN_IF_FAILED(find_entry(pack, name, asset_pack_type_font, &entry));
+
+    asset_pack_font_t const *src = reinterpret_cast<asset_pack_font_t const *>(pack->data + entry->font_offset);
+
+    if(entry->font_size < sizeof(asset_pack_font_t)) {
+        LOG_E("%s font data is corrupt", name);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    asset_pack_font_layout_t layout;
+    asset_pack_get_font_layout(src, &layout);
+
+    // hash tables need at least one empty slot or lookups of missing glyphs never finish
+
+    bool hash_ok = src->glyph_hash_size > src->num_glyphs && (src->glyph_hash_size & (src->glyph_hash_size - 1)) == 0;
+    bool kerning_ok = src->num_kerning == 0 || (src->kerning_hash_size > src->num_kerning && (src->kerning_hash_size & (src->kerning_hash_size - 1)) == 0);
+
+    if(entry->font_size < layout.size || !hash_ok || !kerning_ok) {
+        LOG_E("%s font data is corrupt", name);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // the tables are used in place, font_data just points at them
+
+    font_data *fnt = (font_data *)calloc(1, sizeof(font_data));
+
+    if(fnt == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t const *base = reinterpret_cast<uint8_t const *>(src);
+
+    fnt->graphics = reinterpret_cast<font_graphic const *>(base + layout.graphics);
+    fnt->glyphs = reinterpret_cast<font_glyph const *>(base + layout.glyphs);
+    fnt->glyph_hash = reinterpret_cast<uint16_t const *>(base + layout.glyph_hash);
+    fnt->height = src->height;
+    fnt->num_graphics = src->num_graphics;
+    fnt->num_glyphs = src->num_glyphs;
+    fnt->glyph_hash_size = src->glyph_hash_size;
+    fnt->sdf_spread = entry->pixel_format == asset_pack_pixel_format_a8 ? src->sdf_spread : 0;
+
+    if(src->num_kerning != 0) {
+        fnt->kerning = reinterpret_cast<font_kerning const *>(base + layout.kerning);
+        fnt->kerning_hash = reinterpret_cast<uint16_t const *>(base + layout.kerning_hash);
+        fnt->num_kerning = src->num_kerning;
+        fnt->kerning_hash_size = src->kerning_hash_size;
+    }
+
+    int image_id;
+    esp_err_t ret = load_pixels(pack, entry, &image_id);
+
+    if(ret == ESP_OK) {
+        ret = font_create(fnt, entry->name, image_id, handle);
+    }
+
+    if(ret != ESP_OK) {
+        free(fnt);
+    }
+    return ret;
+}
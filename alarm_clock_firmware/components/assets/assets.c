@@ -1,17 +1,39 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <esp_log.h>
+#include "util.h"
 #include "assets.h"
-
-#include "Cascadia.c"
-#include "Segoe.c"
-#include "Digits.c"
-#include "Big.c"
-#include "Forte.c"
+#include "asset_pack.h"
 
 LOG_CONTEXT("assets");
 
-#define LOAD_IMG(x) ESP_ERROR_CHECK(image_decode_png(#x, &image_id_##x, x##_png_start, x##_png_size))
+// fonts and images all come out of pack/assets.pack, see tools/asset_compiler
+
+static asset_pack_t assets_pack;
+
+#define FONT_LOADER(x, handle)                                 \
+    static esp_err_t load_##x(void *context)                   \
+    {                                                          \
+        return asset_pack_load_font(&assets_pack, #x, handle); \
+    }
+
+// images go in the image cache, they're unpacked when something acquires them
+
+#define IMAGE_LOADER(x)                                                    \
+    static esp_err_t load_##x(void *context)                               \
+    {                                                                      \
+        return asset_pack_register_image(&assets_pack, #x, &image_id_##x); \
+    }
+
+// and these get unpacked in the background too, so they're sitting in the cache ready for the first frame
+
+#define IMAGE_PRELOADER(x)                                                                \
+    static esp_err_t load_##x(void *context)                                              \
+    {                                                                                     \
+        ESP_RETURN_IF_FAILED(asset_pack_register_image(&assets_pack, #x, &image_id_##x)); \
+        ESP_RETURN_IF_FAILED(image_acquire(image_id_##x, NULL));                          \
+        return image_release(image_id_##x);                                               \
+    }
 
 //////////////////////////////////////////////////////////////////////
 
@@ -20,6 +42,7 @@ font_handle_t cascadia_font;
 font_handle_t digits_font;
 font_handle_t big_font;
 font_handle_t forte_font;
+font_handle_t digits_sdf_font;
 
 int image_id_blip;
 int image_id_small_blip;
@@ -29,23 +52,109 @@ int image_id_world;
 
 //////////////////////////////////////////////////////////////////////
 
+FONT_LOADER(Cascadia, &cascadia_font)
+FONT_LOADER(Segoe, &segoe_font)
+FONT_LOADER(Digits, &digits_font)
+FONT_LOADER(Big, &big_font)
+FONT_LOADER(Forte, &forte_font)
+FONT_LOADER(Digits_sdf, &digits_sdf_font)
+
+IMAGE_LOADER(blip)
+IMAGE_LOADER(small_blip)
+IMAGE_LOADER(face)
+IMAGE_LOADER(test)
+IMAGE_PRELOADER(world)
+
+//////////////////////////////////////////////////////////////////////
+// first frame needs the clock digits and the background (the globe)
+
+typedef struct asset_def
+{
+    asset_load_function_t load;
+    asset_load_priority_t priority;
+} asset_def_t;
+
+static asset_def_t const asset_defs[asset_num_ids] = {
+
+    [asset_id_cascadia_font] = { load_Cascadia, asset_load_priority_low },
+    [asset_id_segoe_font] = { load_Segoe, asset_load_priority_low },
+    [asset_id_digits_font] = { load_Digits, asset_load_priority_high },
+    [asset_id_big_font] = { load_Big, asset_load_priority_low },
+    [asset_id_forte_font] = { load_Forte, asset_load_priority_low },
+    [asset_id_digits_sdf_font] = { load_Digits_sdf, asset_load_priority_high },
+
+    [asset_id_blip] = { load_blip, asset_load_priority_low },
+    [asset_id_small_blip] = { load_small_blip, asset_load_priority_low },
+    [asset_id_face] = { load_face, asset_load_priority_low },
+    [asset_id_test] = { load_test, asset_load_priority_low },
+    [asset_id_world] = { load_world, asset_load_priority_high },
+};
+
+static asset_load_handle_t asset_handles[asset_num_ids];
+
+//////////////////////////////////////////////////////////////////////
+
 esp_err_t assets_init()
 {
     LOG_I("begin");
 
-    ESP_ERROR_CHECK(FONT_INIT(Cascadia, &cascadia_font));
-    ESP_ERROR_CHECK(FONT_INIT(Segoe, &segoe_font));
-    ESP_ERROR_CHECK(FONT_INIT(Digits, &digits_font));
-    ESP_ERROR_CHECK(FONT_INIT(Big, &big_font));
-    ESP_ERROR_CHECK(FONT_INIT(Forte, &forte_font));
+    ESP_RETURN_IF_FAILED(asset_pack_open(&assets_pack, assets_pack_start, assets_pack_size));
+
+    ESP_RETURN_IF_FAILED(asset_loader_init());
+
+    // submit the high priority ones first so they're at the front of the queue
 
-    LOAD_IMG(blip);
-    LOAD_IMG(small_blip);
-    LOAD_IMG(face);
-    LOAD_IMG(test);
-    LOAD_IMG(world);
+    for(int p = asset_load_priority_high; p <= asset_load_priority_low; ++p) {
+        for(int i = 0; i < asset_num_ids; ++i) {
+            if(asset_defs[i].priority == p) {
+                ESP_RETURN_IF_FAILED(asset_loader_submit(asset_defs[i].load, NULL, asset_defs[i].priority, &asset_handles[i]));
+            }
+        }
+    }
 
     LOG_I("end");
 
     return ESP_OK;
 }
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t assets_wait(asset_id_t id, TickType_t ticks_to_wait)
+{
+    if(id < 0 || id >= asset_num_ids) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return asset_loader_wait(asset_handles[id], ticks_to_wait);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t assets_wait_for_first_frame(TickType_t ticks_to_wait)
+{
+    for(int i = 0; i < asset_num_ids; ++i) {
+        if(asset_defs[i].priority == asset_load_priority_high) {
+            ESP_RETURN_IF_FAILED(asset_loader_wait(asset_handles[i], ticks_to_wait));
+        }
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool assets_is_loaded(asset_id_t id)
+{
+    if(id < 0 || id >= asset_num_ids) {
+        return false;
+    }
+    return asset_loader_is_complete(asset_handles[id]);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+asset_load_handle_t assets_get_handle(asset_id_t id)
+{
+    if(id < 0 || id >= asset_num_ids) {
+        return NULL;
+    }
+    return asset_handles[id];
+}
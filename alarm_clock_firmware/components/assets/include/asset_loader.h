@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////
+// Background asset loader
+// Jobs are decoded by one worker task per core, high priority jobs first.
+// Waiting on a job which hasn't been started yet runs it on the calling task.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#include <freertos/FreeRTOS.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+typedef enum asset_load_priority
+{
+    asset_load_priority_high = 0,    // needed for the first frame
+    asset_load_priority_low = 1,     // loaded in the background
+
+} asset_load_priority_t;
+
+typedef esp_err_t (*asset_load_function_t)(void *context);
+
+typedef struct asset_load_job *asset_load_handle_t;
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t asset_loader_init();
+
+esp_err_t asset_loader_submit(asset_load_function_t function, void *context, asset_load_priority_t priority, asset_load_handle_t *handle);
+
+// wait for a job to complete, returns the result of the load function or ESP_ERR_TIMEOUT
+esp_err_t asset_loader_wait(asset_load_handle_t handle, TickType_t ticks_to_wait);
+
+bool asset_loader_is_complete(asset_load_handle_t handle);
+
+// done with the handle, its slot is reused once the job has run (it still runs if it hasn't yet).
+// There are a fixed number of slots so anything which submits jobs over and over has to release them
+esp_err_t asset_loader_release(asset_load_handle_t handle);
+
+//////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////
+// Asset packs made by tools/asset_compiler
+// The pack stays where it is (embedded or a mapped partition), entries are
+// found by name with one hash probe and decompressed straight into PSRAM.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#include "asset_pack_format.h"
+#include "font.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct asset_pack
+{
+    uint8_t const *data;
+    size_t size;
+    asset_pack_header_t const *header;
+    asset_pack_entry_t const *entries;
+    uint16_t const *hash_table;
+
+} asset_pack_t;
+
+//////////////////////////////////////////////////////////////////////
+
+// checks the header and the index, data must stay valid for as long as the pack is used
+esp_err_t asset_pack_open(asset_pack_t *pack, uint8_t const *data, size_t size);
+
+esp_err_t asset_pack_find(asset_pack_t const *pack, char const *name, asset_pack_entry_t const **out_entry);
+
+// resident forever, like image_decode_png / font_init
+esp_err_t asset_pack_load_image(asset_pack_t const *pack, char const *name, int *out_image_id);
+esp_err_t asset_pack_load_font(asset_pack_t const *pack, char const *name, font_handle_t *handle);
+
+// unpacked by image_acquire and evictable once released, the pack must outlive the image
+esp_err_t asset_pack_register_image(asset_pack_t const *pack, char const *name, int *out_image_id);
+
+//////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+}
+#endif
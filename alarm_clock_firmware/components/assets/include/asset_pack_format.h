@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////
+// Asset pack file format, shared by tools/asset_compiler and the loader
+// in asset_pack.cpp so this must stay plain C with no ESP-IDF headers.
+//
+// header
+// entries[num_assets]
+// hash_table[hash_table_size]      entry index by name hash, 0xffff = empty
+// payloads, each 4 byte aligned
+//
+// Everything is little endian. Bump ASSET_PACK_VERSION when any of it changes.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "font_format.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+#define ASSET_PACK_MAGIC 0x4b504341    // 'ACPK'
+#define ASSET_PACK_VERSION 5
+
+#define ASSET_PACK_NAME_LEN 24
+#define ASSET_PACK_HASH_EMPTY 0xffff
+
+//////////////////////////////////////////////////////////////////////
+
+typedef enum asset_pack_type
+{
+    asset_pack_type_image = 0,
+    asset_pack_type_font = 1,
+
+} asset_pack_type_t;
+
+typedef enum asset_pack_pixel_format
+{
+    asset_pack_pixel_format_argb32 = 0,      // what the display blits from
+    asset_pack_pixel_format_a8 = 1,          // signed distance field font atlases
+    asset_pack_pixel_format_a4 = 2,          // coverage only font atlases, two pixels per byte, high nibble first
+    asset_pack_pixel_format_rgb565 = 3,      // opaque images, 16 bits per pixel, unpacked to ARGB32
+    asset_pack_pixel_format_argb8565 = 4,    // RGB565 then an alpha byte, 3 bytes per pixel, unpacked to ARGB32
+
+} asset_pack_pixel_format_t;
+
+typedef enum asset_pack_compression
+{
+    asset_pack_compression_none = 0,
+    asset_pack_compression_rle = 1,    // runs of 32 bit pixels (ARGB32 only), see asset_rle_decompress
+    asset_pack_compression_lz4 = 2,    // LZ4 block format
+
+} asset_pack_compression_t;
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct asset_pack_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t num_assets;
+    uint16_t hash_table_size;    // power of 2
+    uint16_t reserved;
+    uint32_t entries_offset;
+    uint32_t hash_table_offset;
+    uint32_t total_size;
+
+} asset_pack_header_t;
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct asset_pack_entry
+{
+    char name[ASSET_PACK_NAME_LEN];    // nul terminated
+    uint32_t name_hash;                // asset_pack_hash(name)
+    uint8_t type;                      // asset_pack_type_t
+    uint8_t pixel_format;              // asset_pack_pixel_format_t
+    uint8_t compression;               // asset_pack_compression_t
+    uint8_t reserved;
+    uint16_t width;
+    uint16_t height;
+    uint32_t data_offset;    // pixels
+    uint32_t data_size;      // compressed size
+    uint32_t font_offset;    // asset_pack_font, fonts only
+    uint32_t font_size;
+
+} asset_pack_entry_t;
+
+//////////////////////////////////////////////////////////////////////
+// font metrics, each table which follows the header is 4 byte aligned
+
+typedef struct asset_pack_font
+{
+    int16_t height;
+    uint16_t num_graphics;
+    uint16_t num_glyphs;
+    uint16_t num_kerning;
+    uint16_t glyph_hash_size;      // power of 2
+    uint16_t kerning_hash_size;    // power of 2, 0 if no kerning
+    uint16_t sdf_spread;           // for A8 distance field atlases, distance in atlas pixels at 0 and 255
+    uint16_t reserved;
+
+    // font_glyph glyphs[num_glyphs]
+    // font_kerning kerning[num_kerning]
+    // uint16_t glyph_hash[glyph_hash_size]
+    // uint16_t kerning_hash[kerning_hash_size]
+    // font_graphic graphics[num_graphics]
+
+} asset_pack_font_t;
+
+typedef struct asset_pack_font_layout
+{
+    uint32_t glyphs;
+    uint32_t kerning;
+    uint32_t glyph_hash;
+    uint32_t kerning_hash;
+    uint32_t graphics;
+    uint32_t size;
+
+} asset_pack_font_layout_t;
+
+#define ASSET_PACK_ALIGN4(x) (((x) + 3u) & ~3u)
+
+// offsets from the start of the asset_pack_font
+
+static inline void asset_pack_get_font_layout(asset_pack_font_t const *font, asset_pack_font_layout_t *layout)
+{
+    uint32_t offset = ASSET_PACK_ALIGN4(sizeof(asset_pack_font_t));
+    layout->glyphs = offset;
+    offset = ASSET_PACK_ALIGN4(offset + font->num_glyphs * sizeof(font_glyph));
+    layout->kerning = offset;
+    offset = ASSET_PACK_ALIGN4(offset + font->num_kerning * sizeof(font_kerning));
+    layout->glyph_hash = offset;
+    offset = ASSET_PACK_ALIGN4(offset + font->glyph_hash_size * sizeof(uint16_t));
+    layout->kerning_hash = offset;
+    offset = ASSET_PACK_ALIGN4(offset + font->kerning_hash_size * sizeof(uint16_t));
+    layout->graphics = offset;
+    layout->size = offset + font->num_graphics * sizeof(font_graphic);
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNV-1a
+
+static inline uint32_t asset_pack_hash(char const *name)
+{
+    uint32_t hash = 2166136261u;
+    while(*name != 0) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+//////////////////////////////////////////////////////////////////////
+// codecs, these return the number of bytes written or -1 if it didn't fit / the input is bad
+
+int asset_rle_compress(uint32_t const *src, size_t num_pixels, uint8_t *dst, size_t dst_capacity);
+int asset_rle_decompress(uint8_t const *src, size_t src_size, uint32_t *dst, size_t num_pixels);
+
+int asset_lz4_compress(uint8_t const *src, size_t src_size, uint8_t *dst, size_t dst_capacity);
+int asset_lz4_decompress(uint8_t const *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+//////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+}
+#endif
@@ -14,25 +14,9 @@ extern "C" {
 
 //////////////////////////////////////////////////////////////////////
 
-extern const uint8_t test_png_start[] asm("_binary_test_png_start");
-extern const uint8_t test_png_end[] asm("_binary_test_png_end");
-#define test_png_size ((size_t)(test_png_end - test_png_start))
-
-extern const uint8_t world_png_start[] asm("_binary_world_png_start");
-extern const uint8_t world_png_end[] asm("_binary_world_png_end");
-#define world_png_size ((size_t)(world_png_end - world_png_start))
-
-extern const uint8_t blip_png_start[] asm("_binary_blip_png_start");
-extern const uint8_t blip_png_end[] asm("_binary_blip_png_end");
-#define blip_png_size ((size_t)(blip_png_end - test_png_start))
-
-extern const uint8_t small_blip_png_start[] asm("_binary_small_blip_png_start");
-extern const uint8_t small_blip_png_end[] asm("_binary_small_blip_png_end");
-#define small_blip_png_size ((size_t)(small_blip_png_end - small_blip_png_start))
-
-extern const uint8_t face_png_start[] asm("_binary_face_png_start");
-extern const uint8_t face_png_end[] asm("_binary_face_png_end");
-#define face_png_size ((size_t)(face_png_end - face_png_start))
+extern const uint8_t assets_pack_start[] asm("_binary_assets_pack_start");
+extern const uint8_t assets_pack_end[] asm("_binary_assets_pack_end");
+#define assets_pack_size ((size_t)(assets_pack_end - assets_pack_start))
 
 extern const uint8_t example_mp3_start[] asm("_binary_example_mp3_start");
 extern const uint8_t example_mp3_end[] asm("_binary_example_mp3_end");
@@ -46,6 +30,7 @@ extern const uint8_t boing_mp3_end[] asm("_binary_boing_mp3_end");
 
 #include "image.h"
 #include "font.h"
+#include "asset_loader.h"
 
 //////////////////////////////////////////////////////////////////////
 
@@ -54,9 +39,12 @@ extern font_handle_t segoe_font;
 extern font_handle_t digits_font;
 extern font_handle_t big_font;
 extern font_handle_t forte_font;
+extern font_handle_t digits_sdf_font;
 
 //////////////////////////////////////////////////////////////////////
 
+// these are in the image cache, image_acquire them before drawing
+
 extern int image_id_blip;
 extern int image_id_small_blip;
 extern int image_id_face;
@@ -65,16 +53,34 @@ extern int image_id_world;
 
 //////////////////////////////////////////////////////////////////////
 
-#include "font/Cascadia.h"
-#include "font/Segoe.h"
-#include "font/Digits.h"
-#include "font/Big.h"
-#include "font/Forte.h"
+// assets are decoded in the background, the ones needed for the first frame are loaded first
 
-//////////////////////////////////////////////////////////////////////
+typedef enum asset_id
+{
+    asset_id_cascadia_font = 0,
+    asset_id_segoe_font,
+    asset_id_digits_font,
+    asset_id_big_font,
+    asset_id_forte_font,
+    asset_id_digits_sdf_font,
+
+    asset_id_blip,
+    asset_id_small_blip,
+    asset_id_face,
+    asset_id_test,
+    asset_id_world,
+
+    asset_num_ids
+
+} asset_id_t;
 
 esp_err_t assets_init();
 
+esp_err_t assets_wait(asset_id_t id, TickType_t ticks_to_wait);
+esp_err_t assets_wait_for_first_frame(TickType_t ticks_to_wait);
+bool assets_is_loaded(asset_id_t id);
+asset_load_handle_t assets_get_handle(asset_id_t id);
+
 //////////////////////////////////////////////////////////////////////
 
 #if defined(__cplusplus)
@@ -1,10 +0,0 @@
-// FONT: Segoe_font has 95 graphics
-
-extern font_graphic Segoe_font_graphics[95];
-extern int16_t Segoe_font_lookup[256];
-extern uint8_t Segoe_font_advance[256];
-extern font_data Segoe_font;
-
-extern const uint8_t Segoe_font_png_start[];
-extern const uint8_t Segoe_font_png_end[];
-#define Segoe_font_png_size ((size_t)(Segoe_font_png_end - Segoe_font_png_start))
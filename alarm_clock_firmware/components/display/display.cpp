@@ -1,11 +1,16 @@
 //////////////////////////////////////////////////////////////////////
-// there is one display list per screen section, each screen section is 16 lines high
+// there is one display list per screen section, sections are lcd_get_section_height() lines high
 // for a blit or fill, we add to all the display lists which the rectangle intersects with
 
 #include <memory.h>
 #include <math.h>
 #include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_async_memcpy.h>
+#include <esp_cache.h>
 #include <stdint.h>
 #include <stdio.h>
 #include "util.h"
@@ -32,13 +37,39 @@ namespace local
         uint8_t alpha : 8;
     };
 
+    // A4/A8 coverage blits, the colour comes from the per-frame tint palette
+
+    struct tint_blit_entry
+    {
+        uint32_t src_x : 9;
+        uint32_t src_y : 9;
+        uint32_t image_id : 6;
+        uint8_t tint : 8;
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    // for draw modes which need more than 4 bytes, the parameters live in display_params_buffer
+    // and are shared by all the sections the item touches
+
+    struct param_entry
+    {
+        uint16_t params;    // offset into display_params_buffer
+        uint16_t row;       // first row of the item which this entry draws
+    };
+
     //////////////////////////////////////////////////////////////////////
 
     typedef enum draw_mode
     {
         draw_mode_fill = 0,
         draw_mode_blit = 1,
-        draw_mode_world_blit = 2
+        draw_mode_world_blit = 2,
+        draw_mode_sdf_text = 3,
+        draw_mode_tint_blit = 4,
+        draw_mode_arc = 5,
+        draw_mode_line = 6,
+        draw_mode_gradient = 7
 
     } draw_mode_t;
 
@@ -46,8 +77,8 @@ namespace local
     {
         uint32_t next : 16;
         uint32_t blendmode : 2;    // see enum display_blendmode
-        uint32_t draw_mode : 2;    // see enum draw_mode_t
-        uint32_t pad : 12;
+        uint32_t draw_mode : 4;    // see enum draw_mode_t
+        uint32_t pad : 10;
     };
 
     static_assert(sizeof(display_list_node) == sizeof(uint32_t));
@@ -66,28 +97,240 @@ namespace local
     {
         display_list_node node;
 
-        vec2b pos;     // pos.y only needs 4 bits when LCD_SECTION_HEIGHT == 16
-        vec2b size;    // size.y only needs 4 bits when LCD_SECTION_HEIGHT == 16
+        vec2b pos;     // pos.y is within the section
+        vec2b size;
 
         union
         {
             blit_entry blit;
+            tint_blit_entry tint_blit;
             uint32_t color;
+            param_entry param;
         };
     };
 
     //////////////////////////////////////////////////////////////////////
 
+    struct sdf_style_params
+    {
+        uint32_t color;
+        uint32_t outline_color;
+        uint32_t glow_color;
+        int32_t outline;       // 8.8 screen pixels
+        int32_t glow;          // 8.8 screen pixels
+        int32_t glow_scale;    // 256 / glow in 16.16
+    };
+
+    struct sdf_glyph_params
+    {
+        uint16_t style;    // offset of the sdf_style_params
+        uint8_t image_id;
+        uint8_t pad;
+        int32_t src_x;             // 16.16 atlas position of the centre of the first pixel
+        int32_t src_y;
+        int32_t step;              // 16.16 atlas pixels per screen pixel
+        int32_t distance_scale;    // 8.8 screen pixels per step of the atlas value
+        uint16_t left;             // glyph rectangle in the atlas, samples are clamped to it
+        uint16_t top;
+        uint16_t right;
+        uint16_t bottom;
+    };
+
+    // positions are 28.4, squared distances 24.8. inner_out2 = 0 for no hole
+
+    struct arc_params
+    {
+        uint32_t color;
+        int32_t cx;
+        int32_t cy;
+        int32_t outer_r2;      // radius squared
+        int32_t outer_in2;     // (radius - 0.5) squared, fully covered inside this
+        int32_t outer_out2;    // (radius + 0.5) squared, not covered outside this
+        int32_t outer_d;       // 2 * radius in 8.8
+        int32_t inner_r2;
+        int32_t inner_in2;
+        int32_t inner_out2;
+        int32_t inner_d;
+        int16_t start_x;    // 8.8 normals of the start and end edges, pointing into the arc
+        int16_t start_y;
+        int16_t end_x;
+        int16_t end_y;
+        uint8_t angles;    // see enum arc_angles
+        uint8_t pad[3];
+    };
+
+    // signed distances are 16.16 screen pixels, across is from the middle of the line and
+    // along is from p0, both at the centre of pixel 0,0 and stepped per pixel
+
+    struct line_params
+    {
+        uint32_t color;
+        int32_t across;
+        int32_t across_x;
+        int32_t across_y;
+        int32_t along;
+        int32_t along_x;
+        int32_t along_y;
+        int32_t half_width;
+        int32_t length;
+    };
+
+    // t is how far from color0 (0) to color1 (0x10000) in 16.16, for radial it's the distance from
+    // the centre over the radius
+
+    struct gradient_params
+    {
+        uint32_t color0;
+        uint32_t color1;
+        uint8_t shape;    // see enum gradient_shape
+        uint8_t dither;
+        uint16_t pad;
+        int32_t t;      // linear, t at the centre of pixel 0,0
+        int32_t t_x;    // and per pixel
+        int32_t t_y;
+        float cx;    // radial, in screen pixels
+        float cy;
+        float radius;
+        float inv_r2;
+    };
+
+    enum gradient_shape
+    {
+        gradient_shape_linear = 0,
+        gradient_shape_radial = 1
+    };
+
+    enum arc_angles
+    {
+        arc_angles_all = 0,             // a whole ring or circle
+        arc_angles_inside_both = 1,     // up to half a turn, inside both edges
+        arc_angles_inside_either = 2    // more than half a turn, inside either edge
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+#if LCD_BITS_PER_PIXEL == 16
+    uint8_t DRAM_ATTR display_buffer[LCD_WIDTH * 3 * LCD_MAX_SECTION_HEIGHT];
+#endif
+
+    // sqrt(i / 256) in 0.16 for radial gradients, filled in by display_init
+    uint16_t gradient_sqrt[257];
+
+    // 4x4 ordered dither, scaled to one step of the panel's channels in 8.16
+
+    uint8_t const gradient_bayer[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+
 #if LCD_BITS_PER_PIXEL == 16
-    uint8_t DRAM_ATTR display_buffer[LCD_WIDTH * 3 * LCD_SECTION_HEIGHT];
+    int constexpr gradient_dither_shift_rb = 15;
+    int constexpr gradient_dither_shift_g = 14;
+#else
+    int constexpr gradient_dither_shift_rb = 14;
+    int constexpr gradient_dither_shift_g = 14;
 #endif
 
     uint8_t DRAM_ATTR display_list_buffer[32767];
 
     size_t display_list_used = 0;
 
+    uint8_t DRAM_ATTR display_params_buffer[8192];
+
+    size_t display_params_used = 0;
+
+    // tint colors used this frame, text tends to use a handful
+
+    uint32_t DRAM_ATTR display_tints[256];
+
+    int display_num_tints = 0;
+
+    // consecutive glyphs of a string share their style
+
+    display_sdf_style last_sdf_style;
+    uint16_t last_sdf_style_offset;
+    bool last_sdf_style_valid = false;
+
+    // pushed clip rectangles, clip is the top one intersected with those under it. x1 and y1 are exclusive
+
+#define DISPLAY_CLIP_DEPTH 8
+
+    struct clip_rect
+    {
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    clip_rect clip_stack[DISPLAY_CLIP_DEPTH];
+    int clip_depth = 0;
+    clip_rect clip = { 0, 0, LCD_WIDTH, LCD_HEIGHT };
+
     // dummy root node for each section
-    display_list_t DRAM_ATTR display_lists[LCD_NUM_SECTIONS];
+    display_list_t DRAM_ATTR display_lists[LCD_MAX_SECTIONS];
+
+    // during a transition the incoming scene goes in its own lists (sharing the entry buffer), each
+    // section of it is drawn into transition_buffer and combined with the outgoing one
+
+    display_list_t DRAM_ATTR incoming_lists[LCD_MAX_SECTIONS];
+
+    display_list_t *drawing_lists = display_lists;
+
+    uint8_t *transition_buffer = nullptr;    // one section in the draw format, allocated on first use
+
+    display_transition transition = display_transition_none;
+    int transition_amount = 0;    // 0..256 of the way to the incoming scene
+
+    // latched from the lcd in display_begin_frame
+    int section_height = LCD_DEFAULT_SECTION_HEIGHT;
+    int num_sections = LCD_HEIGHT / LCD_DEFAULT_SECTION_HEIGHT;
+
+    // the frame the lcd is drawing from the display lists
+    lcd_update_handle frame_in_flight = 0;
+
+    uint32_t display_frame = 0;
+
+    // sections which come out one color (nothing in them, or an opaque fill over all of it last)
+    // are sent from one of these. It's drawn when the color turns up and kept until another color
+    // needs it, but not in a frame it's being sent in
+
+#define DISPLAY_SOLID_BUFFERS 2
+
+    struct solid_buffer
+    {
+        uint8_t *pixels;    // LCD_MAX_SECTION_HEIGHT lines in the LCD pixel format
+        uint32_t color;     // 0 = not drawn yet
+        uint32_t frame;     // last used
+    };
+
+    solid_buffer solid_buffers[DISPLAY_SOLID_BUFFERS];
+
+    // retained background, the whole screen in the draw format (3 bytes per pixel) in PSRAM
+    // each section is copied from it by the async memcpy DMA before its entries are drawn
+
+    uint8_t *background = nullptr;
+    bool background_valid = false;
+
+    async_memcpy_handle_t background_memcpy = nullptr;
+    SemaphoreHandle_t background_copied;
+
+    // display_backend_framebuffer draws straight into this (same layout as the background) and
+    // only the sections something was drawn in get sent
+
+    display_backend backend = display_backend_lists;
+
+    uint8_t *framebuffer = nullptr;
+    bool framebuffer_resend = false;
+    bool section_dirty[LCD_MAX_SECTIONS];
+
+    // display_add_damage with the lists backend, only the sections it marked in section_dirty are sent.
+    // That needs the panel to be showing the frame before, which it isn't until one has been sent,
+    // after one which couldn't be sent or when the background or the scroll area change under it
+    bool partial_frame = false;
+    bool panel_current = false;
+    bool scroll_active = false;
+
+    // high water marks, for the section benchmark
+    size_t display_list_peak = 0;
+    size_t display_params_peak = 0;
 
     //////////////////////////////////////////////////////////////////////
 
@@ -123,6 +366,142 @@ namespace local
         return entry;
     }
 
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename T> T *alloc_params(uint16_t *offset)
+    {
+        size_t size = (sizeof(T) + 3) & ~3;
+
+        if(display_params_used + size > sizeof(display_params_buffer)) {
+            LOG_E("Out of display params");
+            return nullptr;
+        }
+
+        *offset = display_params_used;
+        T *params = reinterpret_cast<T *>(display_params_buffer + display_params_used);
+        display_params_used += size;
+        return params;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename T> T const &get_params(uint16_t offset)
+    {
+        return *reinterpret_cast<T const *>(display_params_buffer + offset);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // clip x0..x1, y0..y1 to the clip rectangle, false if there's nothing left to draw
+
+    bool clip_bounds(int *x0, int *y0, int *x1, int *y1)
+    {
+        *x0 = max(*x0, clip.x0);
+        *y0 = max(*y0, clip.y0);
+        *x1 = min(*x1, clip.x1);
+        *y1 = min(*y1, clip.y1);
+        return *x0 < *x1 && *y0 < *y1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // same for a rectangle, src (if there is one) moves with the top left
+
+    bool clip_rectangle(vec2i *dst, vec2i *size, vec2i *src)
+    {
+        int x0 = dst->x;
+        int y0 = dst->y;
+        int x1 = dst->x + size->x;
+        int y1 = dst->y + size->y;
+
+        if(!clip_bounds(&x0, &y0, &x1, &y1)) {
+            return false;
+        }
+
+        if(src != nullptr) {
+            src->x += x0 - dst->x;
+            src->y += y0 - dst->y;
+        }
+        *dst = { x0, y0 };
+        *size = { x1 - x0, y1 - y0 };
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the framebuffer backend draws each entry as soon as it's made so it doesn't keep them
+
+    void commit_entry(display_list_entry const *e, int section);
+
+    display_list_entry *new_entry(int section, display_list_entry *scratch)
+    {
+        if(backend == display_backend_framebuffer) {
+            return scratch;
+        }
+        return alloc_display_list_entry(drawing_lists + section);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // add an entry to each section which rows y..y+h (already clipped) touch
+    // init(e, row) fills in the rest, row is how far down the item this entry starts
+
+    template <typename F> void add_section_entries(int x, int y, int w, int h, F init)
+    {
+        int section = y / section_height;
+        int row = 0;
+
+        while(row < h) {
+
+            int section_y = y + row - section * section_height;
+            int height = min(h - row, section_height - section_y);
+
+            display_list_entry scratch;
+            display_list_entry *e = new_entry(section, &scratch);
+            if(e == nullptr) {
+                return;
+            }
+            e->pos = vec2b{ (uint8_t)x, (uint8_t)section_y };
+            e->size = vec2b{ (uint8_t)w, (uint8_t)height };
+            init(e, row);
+            commit_entry(e, section);
+
+            row += height;
+            section += 1;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // same but for items which aren't rectangles, span(y, h, &x0, &x1) gives the columns which
+    // rows y..y+h touch (already clipped) or false if none, so each entry is only as wide as it needs
+
+    template <typename S, typename F> void add_section_spans(int y, int h, S span, F init)
+    {
+        int section = y / section_height;
+        int row = 0;
+
+        while(row < h) {
+
+            int section_y = y + row - section * section_height;
+            int height = min(h - row, section_height - section_y);
+
+            int x0;
+            int x1;
+
+            if(span(y + row, height, &x0, &x1)) {
+
+                display_list_entry scratch;
+                display_list_entry *e = new_entry(section, &scratch);
+                if(e == nullptr) {
+                    return;
+                }
+                e->pos = vec2b{ (uint8_t)x0, (uint8_t)section_y };
+                e->size = vec2b{ (uint8_t)(x1 - x0), (uint8_t)height };
+                init(e, row);
+                commit_entry(e, section);
+            }
+
+            row += height;
+            section += 1;
+        }
+    }
+
 #if LCD_BITS_PER_PIXEL == 16
 
     //////////////////////////////////////////////////////////////////////
@@ -132,7 +511,7 @@ namespace local
     {
         uint8_t *src = display_buffer;
 
-        for(int y = 0; y < LCD_SECTION_HEIGHT; ++y) {
+        for(int y = 0; y < section_height; ++y) {
 
             uint8_t *src_row = src;
             uint16_t *dst_row = reinterpret_cast<uint16_t *>(dst);
@@ -225,6 +604,10 @@ namespace local
     {
         image_t const *source_image = image_get(e.blit.image_id);
 
+        if(source_image == nullptr || source_image->format != image_format_argb32) {
+            return;
+        }
+
         uint32_t stride = source_image->width;
 
         uint8_t *dst = buffer + (e.pos.x + e.pos.y * LCD_WIDTH) * 3;
@@ -266,13 +649,108 @@ namespace local
         }
     }
 
+    //////////////////////////////////////////////////////////////////////
+    // coverage is 0..256
+
+    inline void blend_coverage(uint8_t *dst, uint32_t color, uint32_t coverage)
+    {
+        int a = (get_a(color) * coverage) >> 8;
+        dst[0] += (((int)get_r(color) - dst[0]) * a) >> 8;
+        dst[1] += (((int)get_g(color) - dst[1]) * a) >> 8;
+        dst[2] += (((int)get_b(color) - dst[2]) * a) >> 8;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // glyph edges blend by coverage, opaque only writes the pixels they cover completely
+
+    template <typename T> struct tint_blend
+    {
+        static void blend(uint8_t *dst, uint32_t rgb, uint32_t coverage, uint8_t alpha)
+        {
+            T::blend(dst, (coverage << 24) | rgb, alpha);
+        }
+    };
+
+    template <> struct tint_blend<do_blend_opaque>
+    {
+        static void blend(uint8_t *dst, uint32_t rgb, uint32_t coverage, uint8_t)
+        {
+            if(coverage == 255) {
+                do_blend_opaque::blend(dst, rgb, 0xff);
+            } else {
+                blend_coverage(dst, rgb | 0xff000000, coverage + 1);
+            }
+        }
+    };
+
+    //////////////////////////////////////////////////////////////////////
+    // A8/A4 coverage tinted with a color, coverage ends up in the alpha of the source pixel
+
+    template <typename T, image_format_t F> void do_tint_blit(display_list_entry const &e, uint8_t const *src, uint32_t stride, uint8_t *buffer)
+    {
+        uint8_t *dst = buffer + (e.pos.x + e.pos.y * LCD_WIDTH) * 3;
+
+        uint32_t tint = display_tints[e.tint_blit.tint];
+        uint32_t rgb = tint & 0xffffff;
+        uint8_t alpha = get_a(tint);
+
+        for(int y = 0; y < e.size.y; ++y) {
+
+            uint8_t *dst_row = dst;
+
+            for(int x = 0; x < e.size.x; ++x) {
+
+                uint32_t coverage;
+
+                if(F == image_format_a8) {
+                    coverage = src[x];
+                } else {
+                    int sx = e.tint_blit.src_x + x;
+                    coverage = ((src[sx >> 1] >> ((sx & 1) ? 0 : 4)) & 0xf) * 17;
+                }
+
+                if(coverage != 0) {
+                    tint_blend<T>::blend(dst_row, rgb, coverage, alpha);
+                }
+                dst_row += 3;
+            }
+            src += stride;
+            dst += LCD_WIDTH * 3;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename T> void do_tint_blit(display_list_entry const &e, uint8_t *buffer, int section)
+    {
+        image_t const *source_image = image_get(e.tint_blit.image_id);
+
+        if(source_image == nullptr) {
+            return;
+        }
+
+        uint32_t stride = image_format_stride(source_image->format, source_image->width);
+        uint8_t const *src = source_image->alpha_data + e.tint_blit.src_y * stride;
+
+        switch(source_image->format) {
+        case image_format_a8:
+            do_tint_blit<T, image_format_a8>(e, src + e.tint_blit.src_x, stride, buffer);
+            break;
+        case image_format_a4:
+            do_tint_blit<T, image_format_a4>(e, src, stride, buffer);
+            break;
+        default:
+            break;
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////
     // Hacky special for drawing the globe (very slowly!)
 
     template <typename T> void do_sphere_blit(display_list_entry const &e, uint8_t *buffer, int section)
     {
         assert(e.pos.x == 0);
-        assert(e.pos.y < 16);
+        assert(e.pos.y < section_height);
 
         image_t const *source_image = image_get_unchecked(e.blit.image_id);
 
@@ -309,232 +787,582 @@ namespace local
         }
     }
 
-}    // namespace local
+    //////////////////////////////////////////////////////////////////////
+    // signed distance (8.8 screen pixels, positive inside) to coverage (0..256),
+    // smoothstep across a one pixel wide edge
 
-using namespace local;
+    inline uint32_t edge_coverage(int32_t distance)
+    {
+        int32_t t = distance + 128;
 
-//////////////////////////////////////////////////////////////////////
+        if(t <= 0) {
+            return 0;
+        }
+        if(t >= 256) {
+            return 256;
+        }
+        return (t * t * (768 - 2 * t)) >> 16;
+    }
 
-void display_begin_frame()
-{
-    // allocate one dummy head node for each list
+    //////////////////////////////////////////////////////////////////////
+    // bilinear sample of an A8 distance atlas, the outline and glow are just
+    // more edges further out along the same distance field
 
-    display_list_used = 0;
+    void do_sdf_text(display_list_entry const &e, uint8_t *buffer, int section)
+    {
+        sdf_glyph_params const &g = get_params<sdf_glyph_params>(e.param.params);
+        sdf_style_params const &style = get_params<sdf_style_params>(g.style);
 
-    for(display_list_t &d : display_lists) {
+        image_t const *atlas = image_get(g.image_id);
 
-        d.root.next = 0xffff;
-        d.head = &d.root;
-    }
-}
+        if(atlas == nullptr || atlas->format != image_format_a8) {
+            return;
+        }
 
-//////////////////////////////////////////////////////////////////////
+        uint8_t const *pixels = atlas->alpha_data;
+        int stride = atlas->width;
 
-void display_image(vec2i *pos, uint8_t image_id, uint8_t alpha, uint8_t blendmode, vec2f *pivot)
-{
-    image_t const *image = image_get(image_id);
-    vec2i src_pos = { 0, 0 };
-    vec2i size = { image->width, image->height };
-    vec2i dst_pos = { pos->x - (int)(size.x * pivot->x), pos->y - (int)(size.y * pivot->y) };
-    display_imagerect(&dst_pos, &src_pos, &size, image_id, alpha, blendmode);
-}
+        int left = g.left;
+        int top = g.top;
+        int right = g.right - 1;
+        int bottom = g.bottom - 1;
 
-//////////////////////////////////////////////////////////////////////
+        bool outline = get_a(style.outline_color) != 0 && style.outline > 0;
+        bool glow = get_a(style.glow_color) != 0 && style.glow > 0;
 
-void display_sphere(int offset, uint8_t image_id, uint8_t alpha, uint8_t blendmode)
-{
-    uint8_t src_y = 0;
+        // nothing can be drawn further out than this
+        int32_t reach = -(style.outline + style.glow + 128);
 
-    for(display_list_t &d : display_lists) {
+        uint8_t *dst = buffer + (e.pos.x + e.pos.y * LCD_WIDTH) * 3;
 
-        for(uint8_t y = 0; y < LCD_SECTION_HEIGHT; ++y) {
+        int32_t sy = g.src_y + e.param.row * g.step;
 
-            display_list_entry *e = alloc_display_list_entry(&d);
-            if(e == nullptr) {
-                return;
-            }
+        for(int y = 0; y < e.size.y; ++y) {
 
-            e->pos = vec2b{ 0, y };     // dummy x
-            e->size = vec2b{ 1, 1 };    // dummy w,h
-            e->blit.image_id = image_id;
-            e->blit.src_x = offset;
-            e->blit.src_y = src_y;
-            e->blit.alpha = alpha;
-            e->node.blendmode = blendmode;
-            e->node.draw_mode = draw_mode_world_blit;
+            int iy = sy >> 16;
+            int32_t fy = (sy >> 8) & 0xff;
+
+            uint8_t const *row0 = pixels + max(top, min(iy, bottom)) * stride;
+            uint8_t const *row1 = pixels + max(top, min(iy + 1, bottom)) * stride;
+
+            int32_t sx = g.src_x;
+            uint8_t *d = dst;
+
+            for(int x = e.size.x; x != 0; --x) {
 
-            src_y += 1;
+                int ix = sx >> 16;
+                int32_t fx = (sx >> 8) & 0xff;
+                sx += g.step;
+
+                int x0 = max(left, min(ix, right));
+                int x1 = max(left, min(ix + 1, right));
+
+                // 8.8 atlas value
+                int32_t upper = (row0[x0] << 8) + (row0[x1] - row0[x0]) * fx;
+                int32_t lower = (row1[x0] << 8) + (row1[x1] - row1[x0]) * fx;
+                int32_t value = upper + (((lower - upper) * fy) >> 8);
+
+                int32_t distance = ((value - (128 << 8)) * g.distance_scale) >> 8;
+
+                if(distance > reach) {
+
+                    if(glow) {
+                        int32_t outside = -(distance + style.outline);
+                        uint32_t coverage = 256;
+                        if(outside > 0) {
+                            coverage = 256 - (uint32_t)min((int64_t)256, ((int64_t)outside * style.glow_scale) >> 16);
+                            coverage = (coverage * coverage) >> 8;
+                        }
+                        blend_coverage(d, style.glow_color, coverage);
+                    }
+                    if(outline) {
+                        blend_coverage(d, style.outline_color, edge_coverage(distance + style.outline));
+                    }
+                    blend_coverage(d, style.color, edge_coverage(distance));
+                }
+                d += 3;
+            }
+            sy += g.step;
+            dst += LCD_WIDTH * 3;
         }
     }
-}
 
-//////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////
+    // anti-aliased edges blend by alpha, so opaque blends them in by coverage too
 
-void display_imagerect(vec2i const *dst_pos, vec2i const *src_pos, vec2i const *size, uint8_t image_id, uint8_t alpha, uint8_t blendmode)
-{
-    // clip
-    vec2i sz = *size;
-    vec2i src = *src_pos;
-    vec2i dst = *dst_pos;
-    if(dst.x < 0) {
-        sz.x += dst.x;
-        src.x -= dst.x;
-        dst.x = 0;
-    }
-    if(sz.x <= 0) {
-        return;
-    }
-    if(dst.y < 0) {
-        sz.y += dst.y;
-        src.y -= dst.y;
-        dst.y = 0;
-    }
-    if(sz.y <= 0) {
-        return;
-    }
-    int right_clip = (dst.x + sz.x) - LCD_WIDTH;
-    if(right_clip > 0) {
-        sz.x -= right_clip;
-        if(sz.x <= 0) {
-            return;
+    template <typename T> struct edge_blend
+    {
+        static void blend(uint8_t *dst, uint32_t color, uint32_t coverage)
+        {
+            T::blend(dst, (min<uint32_t>(coverage, 255) << 24) | (color & 0xffffff), get_a(color));
         }
-    }
-    int bottom_clip = (dst.y + sz.y) - LCD_HEIGHT;
-    if(bottom_clip > 0) {
-        sz.y -= bottom_clip;
-        if(sz.y <= 0) {
-            return;
+    };
+
+    template <> struct edge_blend<do_blend_opaque>
+    {
+        static void blend(uint8_t *dst, uint32_t color, uint32_t coverage)
+        {
+            if(coverage >= 256) {
+                do_blend_opaque::blend(dst, color, 0xff);
+            } else {
+                blend_coverage(dst, color | 0xff000000, coverage);
+            }
         }
-    }
+    };
+
+    //////////////////////////////////////////////////////////////////////
+    // the span of each row is found once, then each pixel's distance to the circles is
+    // estimated from its squared distance so there's no sqrt or texture read per pixel
+
+    template <typename T> void do_arc(display_list_entry const &e, uint8_t *buffer, int section)
+    {
+        arc_params const &a = get_params<arc_params>(e.param.params);
 
-    int top_section = dst.y / LCD_SECTION_HEIGHT;
-    int section_top_y = top_section * LCD_SECTION_HEIGHT;
+        int left = e.pos.x;
+        int right = e.pos.x + e.size.x;
 
-    int src_y = src.y;
-    int dst_y = dst.y - section_top_y;
+        int32_t dy = (section * section_height + e.pos.y) * 16 + 8 - a.cy;
 
-    int remaining_height = sz.y;
-    int cur_height = min(remaining_height, section_top_y + LCD_SECTION_HEIGHT - dst.y);
+        uint8_t *dst = buffer + e.pos.y * LCD_WIDTH * 3;
 
-    display_list_t *display_list = display_lists + top_section;
+        for(int y = 0; y < e.size.y; ++y, dy += 16, dst += LCD_WIDTH * 3) {
 
-    do {
+            int32_t dy2 = dy * dy;
 
-        cur_height = min(remaining_height, LCD_SECTION_HEIGHT);
+            if(dy2 >= a.outer_out2) {
+                continue;
+            }
+
+            int32_t extent = (int32_t)sqrtf((float)(a.outer_out2 - dy2));
+            int x0 = max(left, (int)((a.cx - extent - 8) >> 4));
+            int x1 = min(right, (int)((a.cx + extent - 8) >> 4) + 2);
 
-        int overflow = LCD_SECTION_HEIGHT - (dst_y + cur_height);
+            // pixels wholly inside the hole
+            int hole0 = x1;
+            int hole1 = x1;
+
+            if(dy2 < a.inner_in2) {
+                int32_t hole = (int32_t)sqrtf((float)(a.inner_in2 - dy2));
+                hole0 = ((a.cx - hole - 8) >> 4) + 1;
+                hole1 = (a.cx + hole - 8) >> 4;
+            }
 
-        if(overflow < 0) {
-            cur_height += overflow;
+            int32_t dx = x0 * 16 + 8 - a.cx;
+
+            for(int x = x0; x < x1; ++x, dx += 16) {
+
+                if(x >= hole0 && x < hole1) {
+                    dx += (hole1 - 1 - x) * 16;
+                    x = hole1 - 1;
+                    continue;
+                }
+
+                int32_t d2 = dx * dx + dy2;
+
+                if(d2 >= a.outer_out2 || d2 <= a.inner_in2) {
+                    continue;
+                }
+
+                uint32_t coverage = 256;
+
+                // distance = (r^2 - d^2) / (r + d), first with d = r and then with that estimate of d
+                if(d2 > a.outer_in2) {
+                    int32_t n = (a.outer_r2 - d2) << 8;
+                    int32_t distance = n / a.outer_d;
+                    distance = n / (a.outer_d - distance);
+                    coverage = edge_coverage(distance);
+                }
+
+                if(d2 < a.inner_out2) {
+                    int32_t n = (d2 - a.inner_r2) << 8;
+                    int32_t distance = n / a.inner_d;
+                    distance = n / (a.inner_d + distance);
+                    coverage = min(coverage, edge_coverage(distance));
+                }
+
+                if(a.angles != arc_angles_all) {
+                    uint32_t start = edge_coverage((dx * a.start_x + dy * a.start_y) >> 4);
+                    uint32_t end = edge_coverage((dx * a.end_x + dy * a.end_y) >> 4);
+                    if(a.angles == arc_angles_inside_both) {
+                        coverage = min(coverage, min(start, end));
+                    } else {
+                        coverage = min(coverage, max(start, end));
+                    }
+                }
+
+                if(coverage != 0) {
+                    edge_blend<T>::blend(dst + x * 3, a.color, coverage);
+                }
+            }
         }
+    }
 
-        display_list_entry *e = alloc_display_list_entry(display_list);
-        if(e == nullptr) {
-            break;
+    //////////////////////////////////////////////////////////////////////
+    // narrow x0..x1 to the pixels where base + x * step is strictly between lo and hi, give or take a pixel
+
+    bool clip_line_span(int32_t base, int32_t step, int32_t lo, int32_t hi, int *x0, int *x1)
+    {
+        if(step == 0) {
+            return base > lo && base < hi;
         }
-        e->pos = vec2b{ (uint8_t)dst.x, (uint8_t)dst_y };
-        e->size = vec2b{ (uint8_t)sz.x, (uint8_t)cur_height };
-        e->blit.image_id = image_id;
-        e->blit.src_x = src.x;
-        e->blit.src_y = src.y;
-        e->blit.alpha = alpha;
-        e->node.blendmode = blendmode;
-        e->node.draw_mode = draw_mode_blit;
 
-        src_y += cur_height;
-        remaining_height -= cur_height;
-        dst_y = 0;
-        display_list += 1;
+        int32_t a = (lo - base) / step;
+        int32_t b = (hi - base) / step;
 
-    } while(remaining_height > 0);
-}
+        *x0 = max(*x0, (int)min(a, b) - 1);
+        *x1 = min(*x1, (int)max(a, b) + 2);
+        return *x0 < *x1;
+    }
 
-//////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////
+    // columns of row y which the line might cover, coverage runs out half a pixel past the edges
 
-void display_fillrect(vec2i const *dst_pos, vec2i const *size, uint32_t color, uint8_t blendmode)
-{
-    // clip
-    vec2i sz = *size;
-    vec2i d = *dst_pos;
-    if(d.x < 0) {
-        sz.x += d.x;
-        d.x = 0;
+    bool get_line_span(line_params const &l, int y, int *x0, int *x1)
+    {
+        int32_t across = l.across + y * l.across_y;
+        int32_t along = l.along + y * l.along_y;
+
+        int32_t reach = l.half_width + 0x8000;
+
+        return clip_line_span(across, l.across_x, -reach, reach, x0, x1) &&
+               clip_line_span(along, l.along_x, -0x8000, l.length + 0x8000, x0, x1);
     }
-    if(sz.x <= 0) {
-        return;
+
+    //////////////////////////////////////////////////////////////////////
+    // coverage is the nearest of the sides and the ends, with a one pixel soft edge
+
+    template <typename T> void do_line(display_list_entry const &e, uint8_t *buffer, int section)
+    {
+        line_params const &l = get_params<line_params>(e.param.params);
+
+        int y = section * section_height + e.pos.y;
+
+        uint8_t *dst = buffer + e.pos.y * LCD_WIDTH * 3;
+
+        for(int row = 0; row < e.size.y; ++row, ++y, dst += LCD_WIDTH * 3) {
+
+            int x0 = e.pos.x;
+            int x1 = e.pos.x + e.size.x;
+
+            if(!get_line_span(l, y, &x0, &x1)) {
+                continue;
+            }
+
+            int32_t across = l.across + x0 * l.across_x + y * l.across_y;
+            int32_t along = l.along + x0 * l.along_x + y * l.along_y;
+
+            for(int x = x0; x < x1; ++x, across += l.across_x, along += l.along_x) {
+
+                int32_t side = l.half_width - (across < 0 ? -across : across);
+                uint32_t coverage = edge_coverage(side >> 8);
+                coverage = min(coverage, edge_coverage(along >> 8));
+                coverage = min(coverage, edge_coverage((l.length - along) >> 8));
+
+                if(coverage != 0) {
+                    edge_blend<T>::blend(dst + x * 3, l.color, coverage);
+                }
+            }
+        }
     }
-    if(d.y < 0) {
-        sz.y += d.y;
-        d.y = 0;
+
+    //////////////////////////////////////////////////////////////////////
+    // gradient channels are 8.16 so they can be stepped along a span with adds
+
+    struct gradient_color
+    {
+        int32_t a;
+        int32_t r;
+        int32_t g;
+        int32_t b;
+    };
+
+    gradient_color gradient_lerp(gradient_params const &g, int32_t t)
+    {
+        gradient_color c;
+        c.a = (get_a(g.color0) << 16) + ((int32_t)get_a(g.color1) - (int32_t)get_a(g.color0)) * t;
+        c.r = (get_r(g.color0) << 16) + ((int32_t)get_r(g.color1) - (int32_t)get_r(g.color0)) * t;
+        c.g = (get_g(g.color0) << 16) + ((int32_t)get_g(g.color1) - (int32_t)get_g(g.color0)) * t;
+        c.b = (get_b(g.color0) << 16) + ((int32_t)get_b(g.color1) - (int32_t)get_b(g.color0)) * t;
+        return c;
     }
-    if(sz.y <= 0) {
-        return;
+
+    gradient_color gradient_step(gradient_params const &g, int32_t t_step)
+    {
+        gradient_color c;
+        c.a = ((int32_t)get_a(g.color1) - (int32_t)get_a(g.color0)) * t_step;
+        c.r = ((int32_t)get_r(g.color1) - (int32_t)get_r(g.color0)) * t_step;
+        c.g = ((int32_t)get_g(g.color1) - (int32_t)get_g(g.color0)) * t_step;
+        c.b = ((int32_t)get_b(g.color1) - (int32_t)get_b(g.color0)) * t_step;
+        return c;
     }
-    int right_clip = (d.x + sz.x) - LCD_WIDTH;
-    if(right_clip > 0) {
-        sz.x -= right_clip;
-        if(sz.x <= 0) {
-            return;
+
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename T> void put_gradient_pixel(uint8_t *dst, gradient_color const &c, int bayer)
+    {
+        uint32_t a = c.a >> 16;
+        uint32_t r = min(255l, (long)(c.r + (bayer << gradient_dither_shift_rb)) >> 16);
+        uint32_t g = min(255l, (long)(c.g + (bayer << gradient_dither_shift_g)) >> 16);
+        uint32_t b = min(255l, (long)(c.b + (bayer << gradient_dither_shift_rb)) >> 16);
+        T::blend(dst, (a << 24) | (r << 16) | (g << 8) | b, 0xff);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // n pixels from x stepping the color along
+
+    template <typename T> void gradient_run(uint8_t *dst, int x, int n, gradient_color c, gradient_color const &step, uint8_t const *bayer)
+    {
+        for(; n != 0; --n, ++x) {
+            put_gradient_pixel<T>(dst + x * 3, c, bayer != nullptr ? bayer[x & 3] : 0);
+            c.a += step.a;
+            c.r += step.r;
+            c.g += step.g;
+            c.b += step.b;
         }
     }
-    int bottom_clip = (d.y + sz.y) - LCD_HEIGHT;
-    if(bottom_clip > 0) {
-        sz.y -= bottom_clip;
-        if(sz.y <= 0) {
-            return;
+
+    //////////////////////////////////////////////////////////////////////
+    // each row splits into runs before, inside and after the gradient, only the middle one steps
+
+    template <typename T> void do_linear_gradient(gradient_params const &g, uint8_t *dst, int y, int x, int n, uint8_t const *bayer)
+    {
+        gradient_color const none = {};
+        gradient_color const step = gradient_step(g, g.t_x);
+
+        int32_t t = g.t + x * g.t_x + y * g.t_y;
+
+        while(n > 0) {
+
+            int count = n;
+
+            if(t <= 0 || t >= 0x10000) {
+
+                bool end = t >= 0x10000;
+
+                // clamped, up to where it comes back into range
+                if(end && g.t_x < 0) {
+                    count = min(n, (int)((t - 0x10000) / -g.t_x) + 1);
+                } else if(!end && g.t_x > 0) {
+                    count = min(n, (int)(-t / g.t_x) + 1);
+                }
+                gradient_run<T>(dst, x, count, gradient_lerp(g, end ? 0x10000 : 0), none, bayer);
+
+            } else {
+
+                if(g.t_x > 0) {
+                    count = min(n, (int)((0x10000 - t) / g.t_x) + 1);
+                } else if(g.t_x < 0) {
+                    count = min(n, (int)(t / -g.t_x) + 1);
+                }
+                gradient_run<T>(dst, x, count, gradient_lerp(g, t), step, bayer);
+            }
+
+            t += count * g.t_x;
+            x += count;
+            n -= count;
         }
     }
 
-    int top_section = dst_pos->y / LCD_SECTION_HEIGHT;
-    int section_top_y = top_section * LCD_SECTION_HEIGHT;
+    //////////////////////////////////////////////////////////////////////
+    // outside the circle is a run of color1, inside the squared distance is stepped along
+    // the row (in 0.24 of the radius squared) and square rooted by table
+
+    template <typename T> void do_radial_gradient(gradient_params const &g, uint8_t *dst, int y, int x, int n, uint8_t const *bayer)
+    {
+        gradient_color const none = {};
+        gradient_color const outside = gradient_lerp(g, 0x10000);
+
+        int x1 = x + n;
 
-    int remaining_height = size->y;
-    int cur_height = min(remaining_height, section_top_y + LCD_SECTION_HEIGHT - dst_pos->y);
+        float dy = y + 0.5f - g.cy;
+        float h2 = g.radius * g.radius - dy * dy;
 
-    display_list_t *display_list = display_lists + top_section;
+        int inside0 = x1;
+        int inside1 = x1;
 
-    int dst_y = dst_pos->y - section_top_y;
+        if(h2 > 0) {
+            float h = sqrtf(h2);
+            inside0 = max(x, min(x1, (int)ceilf(g.cx - h - 0.5f)));
+            inside1 = max(inside0, min(x1, (int)floorf(g.cx + h - 0.5f) + 1));
+        }
 
-    do {
-        cur_height = min(remaining_height, LCD_SECTION_HEIGHT);
+        gradient_run<T>(dst, x, inside0 - x, outside, none, bayer);
 
-        int overflow = LCD_SECTION_HEIGHT - (dst_y + cur_height);
+        float dx = inside0 + 0.5f - g.cx;
+        float scale = g.inv_r2 * 16777216.0f;
 
-        cur_height += min(0, overflow);
+        int32_t s = (int32_t)((dx * dx + dy * dy) * scale);
+        int32_t ds = (int32_t)((2 * dx + 1) * scale);
+        int32_t dds = (int32_t)(2 * scale);
 
-        display_list_entry *e = alloc_display_list_entry(display_list);
-        if(e == nullptr) {
-            break;
+        for(int i = inside0; i < inside1; ++i) {
+
+            int32_t u = max(0l, min(0xffffffl, (long)s));
+            int index = u >> 16;
+            int32_t f = (u >> 8) & 0xff;
+            int32_t t = gradient_sqrt[index] + (((gradient_sqrt[index + 1] - gradient_sqrt[index]) * f) >> 8);
+
+            put_gradient_pixel<T>(dst + i * 3, gradient_lerp(g, t), bayer != nullptr ? bayer[i & 3] : 0);
+
+            s += ds;
+            ds += dds;
         }
-        e->pos = vec2b{ (uint8_t)dst_pos->x, (uint8_t)dst_y };
-        e->size = vec2b{ (uint8_t)size->x, (uint8_t)cur_height };
-        e->color = color;
-        e->node.blendmode = blendmode;
-        e->node.draw_mode = draw_mode_fill;
 
-        remaining_height -= cur_height;
-        dst_y = 0;
-        display_list += 1;
+        gradient_run<T>(dst, inside1, x1 - inside1, outside, none, bayer);
+    }
 
-    } while(remaining_height > 0);
-}
+    //////////////////////////////////////////////////////////////////////
 
-//////////////////////////////////////////////////////////////////////
+    template <typename T> void do_gradient(display_list_entry const &e, uint8_t *buffer, int section)
+    {
+        gradient_params const &g = get_params<gradient_params>(e.param.params);
 
-void display_list_draw(int section, uint8_t *buffer)
-{
+        int y = section * section_height + e.pos.y;
+
+        uint8_t *dst = buffer + e.pos.y * LCD_WIDTH * 3;
+
+        for(int row = 0; row < e.size.y; ++row, ++y, dst += LCD_WIDTH * 3) {
+
+            uint8_t const *bayer = g.dither ? gradient_bayer + (y & 3) * 4 : nullptr;
+
+            if(g.shape == gradient_shape_radial) {
+                do_radial_gradient<T>(g, dst, y, e.pos.x, e.size.x, bayer);
+            } else {
+                do_linear_gradient<T>(g, dst, y, e.pos.x, e.size.x, bayer);
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // index into display_tints, -1 if the palette is full
+
+    int add_tint(uint32_t color)
+    {
+        if(display_num_tints != 0 && display_tints[display_num_tints - 1] == color) {
+            return display_num_tints - 1;
+        }
+
+        for(int i = 0; i < display_num_tints; ++i) {
+            if(display_tints[i] == color) {
+                return i;
+            }
+        }
+
+        if(display_num_tints == (int)countof(display_tints)) {
+            LOG_E("Out of tints");
+            return -1;
+        }
+
+        display_tints[display_num_tints] = color;
+        return display_num_tints++;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    uint16_t add_sdf_style(display_sdf_style const *style, float max_reach)
+    {
+        if(last_sdf_style_valid && memcmp(style, &last_sdf_style, sizeof(display_sdf_style)) == 0) {
+            return last_sdf_style_offset;
+        }
+
+        uint16_t offset;
+        sdf_style_params *p = alloc_params<sdf_style_params>(&offset);
+
+        if(p == nullptr) {
+            return 0xffff;
+        }
+
+        // the distance field only goes out so far
+        float outline = min(max(style->outline_width, 0.0f), max_reach);
+        float glow = min(max(style->glow_width, 0.0f), max_reach - outline);
+
+        p->color = style->color;
+        p->outline_color = style->outline_color;
+        p->glow_color = style->glow_color;
+        p->outline = (int32_t)(outline * 256);
+        p->glow = (int32_t)(glow * 256);
+        p->glow_scale = p->glow > 0 ? (int32_t)((256ll << 16) / p->glow) : 0;
+
+        last_sdf_style = *style;
+        last_sdf_style_offset = offset;
+        last_sdf_style_valid = true;
+        return offset;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void fill_solid_buffer(uint8_t *pixels, uint32_t color)
+    {
 #if LCD_BITS_PER_PIXEL == 16
-    uint8_t *draw_buffer = display_buffer;
+        uint16_t pixel = __builtin_bswap16(get_r(color) >> 3 << 11 | get_g(color) >> 2 << 5 | get_b(color) >> 3);
+        uint16_t *dst = reinterpret_cast<uint16_t *>(pixels);
+
+        for(int i = 0; i < LCD_WIDTH * LCD_MAX_SECTION_HEIGHT; ++i) {
+            *dst++ = pixel;
+        }
 #else
-    uint8_t *draw_buffer = buffer;
+        for(int i = 0; i < LCD_WIDTH * LCD_MAX_SECTION_HEIGHT; ++i) {
+            *pixels++ = get_r(color);
+            *pixels++ = get_g(color);
+            *pixels++ = get_b(color);
+        }
 #endif
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // only the last entry matters, an opaque fill of the whole section hides everything before it
+
+    uint8_t const *get_solid_section(int section)
+    {
+        display_list_t const &d = display_lists[section];
+
+        uint32_t color = COLOR_BLACK;
+
+        if(d.head != &d.root) {
+
+            display_list_entry const &e = *reinterpret_cast<display_list_entry const *>(d.head);
+
+            if(e.node.draw_mode != draw_mode_fill || e.node.blendmode != blend_opaque || e.pos.x != 0 || e.pos.y != 0 || e.size.x != LCD_WIDTH ||
+               e.size.y != section_height) {
+                return nullptr;
+            }
+
+            // opaque ignores the alpha
+            color = e.color | 0xff000000;
+        }
+
+        solid_buffer *oldest = nullptr;
+
+        for(solid_buffer &b : solid_buffers) {
+
+            if(b.pixels == nullptr) {
+                continue;
+            }
+
+            if(b.color == color) {
+                b.frame = display_frame;
+                return b.pixels;
+            }
 
-    uint16_t offset = display_lists[section].root.next;
+            if(b.frame != display_frame && (oldest == nullptr || (int32_t)(b.frame - oldest->frame) < 0)) {
+                oldest = &b;
+            }
+        }
+
+        if(oldest == nullptr) {
+            return nullptr;
+        }
 
-    while(offset != 0xffff) {
+        fill_solid_buffer(oldest->pixels, color);
+        oldest->color = color;
+        oldest->frame = display_frame;
+        return oldest->pixels;
+    }
 
-        display_list_entry const &e = get_display_list_entry(offset);
+    //////////////////////////////////////////////////////////////////////
 
+    void draw_entry(display_list_entry const &e, uint8_t *draw_buffer, int section)
+    {
         switch(e.node.draw_mode) {
         case draw_mode_blit:
             switch(e.node.blendmode) {
@@ -582,30 +1410,1164 @@ void display_list_draw(int section, uint8_t *buffer)
             default:
                 break;
             }
+            break;
+
+        case draw_mode_tint_blit:
+            switch(e.node.blendmode) {
+            case blend_opaque:
+                do_tint_blit<do_blend_opaque>(e, draw_buffer, section);
+                break;
+            case blend_add:
+                do_tint_blit<do_blend_add>(e, draw_buffer, section);
+                break;
+            case blend_multiply:
+                do_tint_blit<do_blend_multiply>(e, draw_buffer, section);
+                break;
+            default:
+                break;
+            }
+            break;
+
+        case draw_mode_sdf_text:
+            do_sdf_text(e, draw_buffer, section);
+            break;
+
+        case draw_mode_line:
+            switch(e.node.blendmode) {
+            case blend_opaque:
+                do_line<do_blend_opaque>(e, draw_buffer, section);
+                break;
+            case blend_add:
+                do_line<do_blend_add>(e, draw_buffer, section);
+                break;
+            case blend_multiply:
+                do_line<do_blend_multiply>(e, draw_buffer, section);
+                break;
+            default:
+                break;
+            }
+            break;
+
+        case draw_mode_gradient:
+            switch(e.node.blendmode) {
+            case blend_opaque:
+                do_gradient<do_blend_opaque>(e, draw_buffer, section);
+                break;
+            case blend_add:
+                do_gradient<do_blend_add>(e, draw_buffer, section);
+                break;
+            case blend_multiply:
+                do_gradient<do_blend_multiply>(e, draw_buffer, section);
+                break;
+            default:
+                break;
+            }
+            break;
+
+        case draw_mode_arc:
+            switch(e.node.blendmode) {
+            case blend_opaque:
+                do_arc<do_blend_opaque>(e, draw_buffer, section);
+                break;
+            case blend_add:
+                do_arc<do_blend_add>(e, draw_buffer, section);
+                break;
+            case blend_multiply:
+                do_arc<do_blend_multiply>(e, draw_buffer, section);
+                break;
+            default:
+                break;
+            }
+            break;
+
         default:
             break;
         }
-
-        offset = e.node.next;
     }
 
-#if LCD_BITS_PER_PIXEL == 16
+    //////////////////////////////////////////////////////////////////////
 
-    convert_display_buffer(buffer);
+    void draw_entries(display_list_t const *lists, int section, uint8_t *draw_buffer)
+    {
+        uint16_t offset = lists[section].root.next;
 
-#endif
-}
+        while(offset != 0xffff) {
 
-//////////////////////////////////////////////////////////////////////
+            display_list_entry const &e = get_display_list_entry(offset);
 
-void display_end_frame()
-{
-    lcd_update(display_list_draw);
-}
+            draw_entry(e, draw_buffer, section);
 
-//////////////////////////////////////////////////////////////////////
+            offset = e.node.next;
+        }
+    }
 
-void display_init()
-{
-    lcd_init();
+    //////////////////////////////////////////////////////////////////////
+
+    void commit_entry(display_list_entry const *e, int section)
+    {
+        if(backend == display_backend_framebuffer) {
+            draw_entry(*e, framebuffer + section * LCD_WIDTH * 3 * section_height, section);
+            section_dirty[section] = true;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // async memcpy callback, in ISR context
+
+    IRAM_ATTR bool on_background_copied(async_memcpy_handle_t, async_memcpy_event_t *, void *)
+    {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(background_copied, &woken);
+        return woken == pdTRUE;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // copy a section out of a whole screen in PSRAM (background or framebuffer), by DMA if it can
+
+    void copy_section(uint8_t *screen, int section, uint8_t *draw_buffer)
+    {
+        size_t bytes = LCD_WIDTH * 3 * section_height;
+        uint8_t *src = screen + section * bytes;
+
+        if(background_memcpy != nullptr && esp_async_memcpy(background_memcpy, draw_buffer, src, bytes, on_background_copied, nullptr) == ESP_OK) {
+            xSemaphoreTake(background_copied, portMAX_DELAY);
+        } else {
+            memcpy(draw_buffer, src, bytes);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // lcd_update_callback, the images it used can go now
+
+    void on_frame_drawn(void *)
+    {
+        image_cache_unlock();
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // a section of one scene, an empty one is black as it would have been from a solid buffer
+
+    void draw_scene_section(display_list_t const *lists, int section, uint8_t *draw_buffer)
+    {
+        if(background_valid) {
+            copy_section(background, section, draw_buffer);
+        } else if(lists[section].head == &lists[section].root) {
+            memset(draw_buffer, 0, LCD_WIDTH * 3 * section_height);
+        }
+        draw_entries(lists, section, draw_buffer);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // draw both scenes of a transition and combine them into draw_buffer, sections
+    // which only show one of them only draw that one
+
+    void draw_transition_section(int section, uint8_t *draw_buffer)
+    {
+        int amount = transition_amount;
+        int top = section * section_height;
+
+        bool need_outgoing = amount < 256;
+        bool need_incoming = amount > 0;
+
+        if(transition == display_transition_wipe_down) {
+            int edge = (amount * LCD_HEIGHT) >> 8;
+            need_outgoing = edge < top + section_height;
+            need_incoming = edge > top;
+        }
+
+        if(!need_incoming) {
+            draw_scene_section(display_lists, section, draw_buffer);
+            return;
+        }
+
+        if(!need_outgoing) {
+            draw_scene_section(incoming_lists, section, draw_buffer);
+            return;
+        }
+
+        draw_scene_section(display_lists, section, draw_buffer);
+        draw_scene_section(incoming_lists, section, transition_buffer);
+
+        int const stride = LCD_WIDTH * 3;
+
+        uint8_t *dst = draw_buffer;
+        uint8_t const *src = transition_buffer;
+
+        switch(transition) {
+
+        case display_transition_crossfade:
+            for(int i = stride * section_height; i != 0; --i) {
+                *dst += ((*src++ - *dst) * amount) >> 8;
+                dst += 1;
+            }
+            break;
+
+        case display_transition_wipe_right: {
+            int edge = ((amount * LCD_WIDTH) >> 8) * 3;
+            for(int y = 0; y < section_height; ++y, dst += stride, src += stride) {
+                memcpy(dst, src, edge);
+            }
+        } break;
+
+        case display_transition_wipe_down: {
+            int rows = ((amount * LCD_HEIGHT) >> 8) - top;
+            memcpy(dst, src, rows * stride);
+        } break;
+
+        case display_transition_slide_left: {
+            // the outgoing scene moves left and the incoming one follows it in from the right
+            int offset = ((amount * LCD_WIDTH) >> 8) * 3;
+            for(int y = 0; y < section_height; ++y, dst += stride, src += stride) {
+                memmove(dst, dst + offset, stride - offset);
+                memcpy(dst + stride - offset, src, offset);
+            }
+        } break;
+
+        default:
+            break;
+        }
+    }
+
+}    // namespace local
+
+using namespace local;
+
+//////////////////////////////////////////////////////////////////////
+
+void display_begin_frame()
+{
+    // the previous frame is drawn from the lists in the background so let it finish
+    lcd_wait(frame_in_flight, portMAX_DELAY);
+
+    // allocate one dummy head node for each list
+
+    display_list_used = 0;
+    display_params_used = 0;
+    display_num_tints = 0;
+    last_sdf_style_valid = false;
+
+    // images referenced by this frame's display lists mustn't be evicted until it's been drawn
+    image_cache_lock();
+
+    display_frame += 1;
+
+    section_height = lcd_get_section_height();
+    num_sections = lcd_get_num_sections();
+
+    for(int i = 0; i < num_sections; ++i) {
+
+        display_list_t &d = display_lists[i];
+        d.root.next = 0xffff;
+        d.head = &d.root;
+        display_list_t &incoming = incoming_lists[i];
+        incoming.root.next = 0xffff;
+        incoming.head = &incoming.root;
+
+        section_dirty[i] = framebuffer_resend;
+    }
+    framebuffer_resend = false;
+    partial_frame = false;
+
+    clip_depth = 0;
+    clip = { 0, 0, LCD_WIDTH, LCD_HEIGHT };
+
+    drawing_lists = display_lists;
+    transition = display_transition_none;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_begin_incoming(display_transition type, float progress)
+{
+    if(transition != display_transition_none) {
+        LOG_E("Already drawing the incoming scene");
+        return;
+    }
+
+    // without the lists or the memory it's just a cut, the incoming scene is drawn over the outgoing one
+    if(backend != display_backend_lists) {
+        return;
+    }
+
+    if(transition_buffer == nullptr) {
+
+        transition_buffer = (uint8_t *)heap_caps_malloc(LCD_WIDTH * 3 * LCD_MAX_SECTION_HEIGHT, MALLOC_CAP_INTERNAL);
+
+        if(transition_buffer == nullptr) {
+            LOG_E("No memory for the transition buffer");
+            return;
+        }
+    }
+
+    // the incoming scene starts with no clipping
+    clip_depth = 0;
+    clip = { 0, 0, LCD_WIDTH, LCD_HEIGHT };
+
+    transition = type;
+    transition_amount = (int)(min(max(progress, 0.0f), 1.0f) * 256.0f);
+    drawing_lists = incoming_lists;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_push_clip(vec2i const *pos, vec2i const *size)
+{
+    // too deep, keep count so the pops still match up
+    if(clip_depth >= DISPLAY_CLIP_DEPTH) {
+        LOG_E("Clip stack full");
+        clip_depth += 1;
+        return;
+    }
+
+    clip_stack[clip_depth++] = clip;
+
+    // an empty clip is fine, everything's rejected until it's popped
+    clip.x0 = max(clip.x0, pos->x);
+    clip.y0 = max(clip.y0, pos->y);
+    clip.x1 = max(clip.x0, min(clip.x1, pos->x + size->x));
+    clip.y1 = max(clip.y0, min(clip.y1, pos->y + size->y));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_pop_clip()
+{
+    if(clip_depth == 0) {
+        LOG_E("Clip stack empty");
+        return;
+    }
+
+    clip_depth -= 1;
+
+    if(clip_depth < DISPLAY_CLIP_DEPTH) {
+        clip = clip_stack[clip_depth];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_image(vec2i *pos, uint8_t image_id, uint8_t alpha, uint8_t blendmode, vec2f *pivot)
+{
+    image_t const *image = image_get(image_id);
+    if(image == nullptr) {
+        return;
+    }
+    vec2i src_pos = { 0, 0 };
+    vec2i size = { image->width, image->height };
+    vec2i dst_pos = { pos->x - (int)(size.x * pivot->x), pos->y - (int)(size.y * pivot->y) };
+    display_imagerect(&dst_pos, &src_pos, &size, image_id, alpha, blendmode);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_sphere(int offset, uint8_t image_id, uint8_t alpha, uint8_t blendmode)
+{
+    uint8_t src_y = 0;
+
+    for(int i = 0; i < num_sections; ++i) {
+
+        for(uint8_t y = 0; y < section_height; ++y, ++src_y) {
+
+            // it's drawn a whole row at a time so only the rows are clipped
+            int screen_y = i * section_height + y;
+            if(screen_y < clip.y0 || screen_y >= clip.y1) {
+                continue;
+            }
+
+            display_list_entry scratch;
+            display_list_entry *e = new_entry(i, &scratch);
+            if(e == nullptr) {
+                return;
+            }
+
+            e->pos = vec2b{ 0, y };     // dummy x
+            e->size = vec2b{ 1, 1 };    // dummy w,h
+            e->blit.image_id = image_id;
+            e->blit.src_x = offset;
+            e->blit.src_y = src_y;
+            e->blit.alpha = alpha;
+            e->node.blendmode = blendmode;
+            e->node.draw_mode = draw_mode_world_blit;
+            commit_entry(e, i);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_imagerect(vec2i const *dst_pos, vec2i const *src_pos, vec2i const *size, uint8_t image_id, uint8_t alpha, uint8_t blendmode)
+{
+    vec2i sz = *size;
+    vec2i src = *src_pos;
+    vec2i dst = *dst_pos;
+
+    if(!clip_rectangle(&dst, &sz, &src)) {
+        return;
+    }
+
+    add_section_entries(dst.x, dst.y, sz.x, sz.y, [=](display_list_entry *e, int row) {
+        e->blit.image_id = image_id;
+        e->blit.src_x = src.x;
+        e->blit.src_y = src.y + row;
+        e->blit.alpha = alpha;
+        e->node.blendmode = blendmode;
+        e->node.draw_mode = draw_mode_blit;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_tintrect(vec2i const *dst_pos, vec2i const *src_pos, vec2i const *size, uint8_t image_id, uint32_t color, uint8_t blendmode)
+{
+    vec2i sz = *size;
+    vec2i src = *src_pos;
+    vec2i dst = *dst_pos;
+
+    if(get_a(color) == 0 || !clip_rectangle(&dst, &sz, &src)) {
+        return;
+    }
+
+    int tint = add_tint(color);
+
+    if(tint < 0) {
+        return;
+    }
+
+    add_section_entries(dst.x, dst.y, sz.x, sz.y, [=](display_list_entry *e, int row) {
+        e->tint_blit.image_id = image_id;
+        e->tint_blit.src_x = src.x;
+        e->tint_blit.src_y = src.y + row;
+        e->tint_blit.tint = tint;
+        e->node.blendmode = blendmode;
+        e->node.draw_mode = draw_mode_tint_blit;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_fillrect(vec2i const *dst_pos, vec2i const *size, uint32_t color, uint8_t blendmode)
+{
+    vec2i sz = *size;
+    vec2i d = *dst_pos;
+
+    if(!clip_rectangle(&d, &sz, nullptr)) {
+        return;
+    }
+
+    add_section_entries(d.x, d.y, sz.x, sz.y, [=](display_list_entry *e, int row) {
+        e->color = color;
+        e->node.blendmode = blendmode;
+        e->node.draw_mode = draw_mode_fill;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_sdf_glyph(vec2f const *pos, float scale, vec2i const *src_pos, vec2i const *src_size, uint8_t image_id, int spread, display_sdf_style const *style)
+{
+    if(scale <= 0 || spread <= 0 || style == nullptr) {
+        return;
+    }
+
+    float inv_scale = 1.0f / scale;
+
+    int x0 = (int)floorf(pos->x);
+    int y0 = (int)floorf(pos->y);
+    int x1 = (int)ceilf(pos->x + src_size->x * scale);
+    int y1 = (int)ceilf(pos->y + src_size->y * scale);
+
+    if(!clip_bounds(&x0, &y0, &x1, &y1)) {
+        return;
+    }
+
+    uint16_t style_offset = add_sdf_style(style, spread * scale - 1.0f);
+
+    if(style_offset == 0xffff) {
+        return;
+    }
+
+    uint16_t offset;
+    sdf_glyph_params *g = alloc_params<sdf_glyph_params>(&offset);
+
+    if(g == nullptr) {
+        return;
+    }
+
+    g->style = style_offset;
+    g->image_id = image_id;
+    g->src_x = (int32_t)((src_pos->x + (x0 + 0.5f - pos->x) * inv_scale - 0.5f) * 65536.0f);
+    g->src_y = (int32_t)((src_pos->y + (y0 + 0.5f - pos->y) * inv_scale - 0.5f) * 65536.0f);
+    g->step = (int32_t)(inv_scale * 65536.0f);
+    g->distance_scale = (int32_t)(spread * scale / 127.0f * 256.0f);
+    g->left = src_pos->x;
+    g->top = src_pos->y;
+    g->right = src_pos->x + src_size->x;
+    g->bottom = src_pos->y + src_size->y;
+
+    add_section_entries(x0, y0, x1 - x0, y1 - y0, [=](display_list_entry *e, int row) {
+        e->param.params = offset;
+        e->param.row = row;
+        e->node.blendmode = blend_opaque;
+        e->node.draw_mode = draw_mode_sdf_text;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_arc(vec2f const *centre, float inner_radius, float outer_radius, float start_angle, float end_angle, uint32_t color, uint8_t blendmode)
+{
+    float sweep = end_angle - start_angle;
+
+    if(outer_radius <= 0 || inner_radius >= outer_radius || sweep <= 0) {
+        return;
+    }
+
+    // a hole smaller than a pixel just draws as a filled circle
+    if(inner_radius < 0.5f) {
+        inner_radius = 0;
+    }
+
+    float cx = centre->x;
+    float cy = centre->y;
+
+    float x0 = cx - outer_radius;
+    float y0 = cy - outer_radius;
+    float x1 = cx + outer_radius;
+    float y1 = cy + outer_radius;
+
+    uint8_t angles = arc_angles_all;
+
+    if(sweep < (float)M_TWOPI) {
+
+        angles = sweep <= (float)M_PI ? arc_angles_inside_both : arc_angles_inside_either;
+
+        // bounds of the ends and of any compass points the arc passes through
+        float sx = sinf(start_angle);
+        float sy = -cosf(start_angle);
+        float ex = sinf(end_angle);
+        float ey = -cosf(end_angle);
+
+        x0 = min(min(sx, ex) * outer_radius, min(sx, ex) * inner_radius);
+        x1 = max(max(sx, ex) * outer_radius, max(sx, ex) * inner_radius);
+        y0 = min(min(sy, ey) * outer_radius, min(sy, ey) * inner_radius);
+        y1 = max(max(sy, ey) * outer_radius, max(sy, ey) * inner_radius);
+
+        int first = (int)ceilf(start_angle / (float)M_PI_2);
+        int last = (int)floorf(end_angle / (float)M_PI_2);
+
+        for(int i = first; i <= last; ++i) {
+            switch(i & 3) {
+            case 0:
+                y0 = -outer_radius;
+                break;
+            case 1:
+                x1 = outer_radius;
+                break;
+            case 2:
+                y1 = outer_radius;
+                break;
+            case 3:
+                x0 = -outer_radius;
+                break;
+            }
+        }
+
+        x0 += cx;
+        y0 += cy;
+        x1 += cx;
+        y1 += cy;
+    }
+
+    // a pixel past the radius for the soft edge
+    int left = (int)floorf(x0 - 1);
+    int top = (int)floorf(y0 - 1);
+    int right = (int)ceilf(x1 + 1);
+    int bottom = (int)ceilf(y1 + 1);
+
+    if(!clip_bounds(&left, &top, &right, &bottom)) {
+        return;
+    }
+
+    uint16_t offset;
+    arc_params *a = alloc_params<arc_params>(&offset);
+
+    if(a == nullptr) {
+        return;
+    }
+
+    auto squared = [](float r) { return (int32_t)(r * r * 256.0f); };
+
+    a->color = color;
+    a->cx = (int32_t)(cx * 16.0f);
+    a->cy = (int32_t)(cy * 16.0f);
+    a->outer_r2 = squared(outer_radius);
+    a->outer_in2 = squared(max(0.0f, outer_radius - 0.5f));
+    a->outer_out2 = squared(outer_radius + 0.5f);
+    a->outer_d = (int32_t)(outer_radius * 512.0f);
+    a->inner_r2 = squared(inner_radius);
+    a->inner_in2 = inner_radius != 0 ? squared(inner_radius - 0.5f) : 0;
+    a->inner_out2 = inner_radius != 0 ? squared(inner_radius + 0.5f) : 0;
+    a->inner_d = (int32_t)(inner_radius * 512.0f);
+
+    // angles are clockwise from 12 o'clock and y is down, so the inward normal of the start edge is (cos, sin)
+    a->start_x = (int16_t)(cosf(start_angle) * 256.0f);
+    a->start_y = (int16_t)(sinf(start_angle) * 256.0f);
+    a->end_x = (int16_t)(-cosf(end_angle) * 256.0f);
+    a->end_y = (int16_t)(-sinf(end_angle) * 256.0f);
+    a->angles = angles;
+
+    add_section_entries(left, top, right - left, bottom - top, [=](display_list_entry *e, int row) {
+        e->param.params = offset;
+        e->param.row = row;
+        e->node.blendmode = blendmode;
+        e->node.draw_mode = draw_mode_arc;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_circle(vec2f const *centre, float radius, float thickness, uint32_t color, uint8_t blendmode)
+{
+    float inner_radius = thickness > 0 ? radius - thickness : 0;
+
+    display_arc(centre, inner_radius, radius, 0, (float)M_TWOPI, color, blendmode);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_line(vec2f const *p0, vec2f const *p1, float width, uint32_t color, uint8_t blendmode)
+{
+    float dx = p1->x - p0->x;
+    float dy = p1->y - p0->y;
+    float length = sqrtf(dx * dx + dy * dy);
+
+    if(length < 1.0f / 256.0f || width <= 0) {
+        return;
+    }
+
+    float half_width = width * 0.5f;
+
+    int left = (int)floorf(min(p0->x, p1->x) - half_width - 1);
+    int top = (int)floorf(min(p0->y, p1->y) - half_width - 1);
+    int right = (int)ceilf(max(p0->x, p1->x) + half_width + 1);
+    int bottom = (int)ceilf(max(p0->y, p1->y) + half_width + 1);
+
+    if(!clip_bounds(&left, &top, &right, &bottom)) {
+        return;
+    }
+
+    uint16_t offset;
+    line_params *l = alloc_params<line_params>(&offset);
+
+    if(l == nullptr) {
+        return;
+    }
+
+    float ux = dx / length;
+    float uy = dy / length;
+
+    // from p0 to the centre of pixel 0,0
+    float ox = 0.5f - p0->x;
+    float oy = 0.5f - p0->y;
+
+    l->color = color;
+    l->across = (int32_t)((ox * -uy + oy * ux) * 65536.0f);
+    l->across_x = (int32_t)(-uy * 65536.0f);
+    l->across_y = (int32_t)(ux * 65536.0f);
+    l->along = (int32_t)((ox * ux + oy * uy) * 65536.0f);
+    l->along_x = (int32_t)(ux * 65536.0f);
+    l->along_y = (int32_t)(uy * 65536.0f);
+    l->half_width = (int32_t)(half_width * 65536.0f);
+    l->length = (int32_t)(length * 65536.0f);
+
+    auto span = [=](int y, int h, int *x0, int *x1) {
+        *x0 = right;
+        *x1 = left;
+        for(int i = 0; i < h; ++i) {
+            int row_left = left;
+            int row_right = right;
+            if(get_line_span(*l, y + i, &row_left, &row_right)) {
+                *x0 = min(*x0, row_left);
+                *x1 = max(*x1, row_right);
+            }
+        }
+        return *x0 < *x1;
+    };
+
+    add_section_spans(top, bottom - top, span, [=](display_list_entry *e, int row) {
+        e->param.params = offset;
+        e->param.row = row;
+        e->node.blendmode = blendmode;
+        e->node.draw_mode = draw_mode_line;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+// clip the rectangle and add the params for a gradient, nullptr if there's nothing to draw
+
+namespace
+{
+    gradient_params *add_gradient(vec2i const *dst_pos, vec2i const *size, uint16_t *offset, vec2i *d, vec2i *sz)
+    {
+        *sz = *size;
+        *d = *dst_pos;
+
+        if(!clip_rectangle(d, sz, nullptr)) {
+            return nullptr;
+        }
+
+        gradient_params *g = alloc_params<gradient_params>(offset);
+
+        if(g != nullptr) {
+            memset(g, 0, sizeof(gradient_params));
+        }
+        return g;
+    }
+
+    void add_gradient_entries(vec2i const &d, vec2i const &sz, uint16_t offset, uint8_t blendmode)
+    {
+        add_section_entries(d.x, d.y, sz.x, sz.y, [=](display_list_entry *e, int row) {
+            e->param.params = offset;
+            e->param.row = row;
+            e->node.blendmode = blendmode;
+            e->node.draw_mode = draw_mode_gradient;
+        });
+    }
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void display_gradient_linear(vec2i const *dst_pos, vec2i const *size, vec2f const *p0, uint32_t color0, vec2f const *p1, uint32_t color1, uint8_t blendmode, bool dither)
+{
+    float dx = p1->x - p0->x;
+    float dy = p1->y - p0->y;
+    float length2 = dx * dx + dy * dy;
+
+    if(length2 < 1.0f) {
+        return;
+    }
+
+    uint16_t offset;
+    vec2i d;
+    vec2i sz;
+    gradient_params *g = add_gradient(dst_pos, size, &offset, &d, &sz);
+
+    if(g == nullptr) {
+        return;
+    }
+
+    // t is how far along p0 -> p1 the pixel projects
+    float tx = dx / length2;
+    float ty = dy / length2;
+
+    g->color0 = color0;
+    g->color1 = color1;
+    g->shape = gradient_shape_linear;
+    g->dither = dither;
+    g->t = (int32_t)(((0.5f - p0->x) * tx + (0.5f - p0->y) * ty) * 65536.0f);
+    g->t_x = (int32_t)(tx * 65536.0f);
+    g->t_y = (int32_t)(ty * 65536.0f);
+
+    add_gradient_entries(d, sz, offset, blendmode);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_gradient_radial(vec2i const *dst_pos, vec2i const *size, vec2f const *centre, float radius, uint32_t color0, uint32_t color1, uint8_t blendmode, bool dither)
+{
+    if(radius <= 0) {
+        return;
+    }
+
+    uint16_t offset;
+    vec2i d;
+    vec2i sz;
+    gradient_params *g = add_gradient(dst_pos, size, &offset, &d, &sz);
+
+    if(g == nullptr) {
+        return;
+    }
+
+    g->color0 = color0;
+    g->color1 = color1;
+    g->shape = gradient_shape_radial;
+    g->dither = dither;
+    g->cx = centre->x;
+    g->cy = centre->y;
+    g->radius = radius;
+    g->inv_r2 = 1.0f / (radius * radius);
+
+    add_gradient_entries(d, sz, offset, blendmode);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+uint8_t const *display_list_draw(int section, uint8_t *buffer)
+{
+    // nothing changed in it, the panel has it already
+    if(partial_frame && transition == display_transition_none && !section_dirty[section]) {
+        return nullptr;
+    }
+
+    // with a background, a framebuffer or a transition the sections are never one color
+
+    if(!background_valid && backend == display_backend_lists && transition == display_transition_none) {
+
+        uint8_t const *solid = get_solid_section(section);
+
+        if(solid != nullptr) {
+            return solid;
+        }
+    }
+
+#if LCD_BITS_PER_PIXEL == 16
+    uint8_t *draw_buffer = display_buffer;
+#else
+    uint8_t *draw_buffer = buffer;
+#endif
+
+    if(backend == display_backend_framebuffer) {
+
+        // it's all been drawn already
+        if(!section_dirty[section]) {
+            return nullptr;
+        }
+        copy_section(framebuffer, section, draw_buffer);
+
+    } else if(transition != display_transition_none) {
+
+        draw_transition_section(section, draw_buffer);
+
+    } else {
+
+        if(background_valid) {
+            copy_section(background, section, draw_buffer);
+        }
+        draw_entries(display_lists, section, draw_buffer);
+    }
+
+#if LCD_BITS_PER_PIXEL == 16
+
+    convert_display_buffer(buffer);
+
+#endif
+
+    return buffer;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_end_frame()
+{
+    display_list_peak = max(display_list_peak, display_list_used);
+    display_params_peak = max(display_params_peak, display_params_used);
+
+    if(clip_depth != 0) {
+        LOG_W("%d clip rectangles still pushed", clip_depth);
+    }
+
+    // the sections are copied out of the framebuffer by DMA
+    if(backend == display_backend_framebuffer) {
+        esp_cache_msync(framebuffer, LCD_WIDTH * LCD_HEIGHT * 3, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    }
+
+    // image_cache_unlock when it's been drawn, the caller gets on with the next frame meanwhile
+    esp_err_t ret = lcd_update_async(display_list_draw, on_frame_drawn, nullptr, &frame_in_flight);
+
+    // nothing in flight so on_frame_drawn is never going to be called
+    if(ret != ESP_OK) {
+        LOG_E("Can't send frame: %d", ret);
+        frame_in_flight = 0;
+        image_cache_unlock();
+    }
+    panel_current = ret == ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool display_add_damage(vec2i *pos, vec2i *size)
+{
+    // the framebuffer keeps everything and sends the sections which were drawn in
+    if(backend == display_backend_framebuffer) {
+        return true;
+    }
+
+    if(!panel_current || scroll_active) {
+        return false;
+    }
+    partial_frame = true;
+
+    int y0 = max(0, pos->y);
+    int y1 = min((int)LCD_HEIGHT, pos->y + size->y);
+
+    if(y0 >= y1 || pos->x >= LCD_WIDTH || pos->x + size->x <= 0) {
+        size->x = 0;
+        size->y = 0;
+        return true;
+    }
+
+    // each section is drawn from scratch so all of one has to be drawn if any of it is
+
+    int first = y0 / section_height;
+    int last = (y1 - 1) / section_height;
+
+    for(int i = first; i <= last; ++i) {
+        section_dirty[i] = true;
+    }
+
+    *pos = vec2i{ 0, first * section_height };
+    *size = vec2i{ LCD_WIDTH, (last + 1 - first) * section_height };
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_begin_background()
+{
+    if(background == nullptr) {
+
+        background = (uint8_t *)heap_caps_aligned_alloc(64, LCD_WIDTH * LCD_HEIGHT * 3, MALLOC_CAP_SPIRAM);
+
+        if(background == nullptr) {
+            LOG_E("No memory for the background");
+        }
+    }
+
+    display_begin_frame();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_end_background()
+{
+    // the framebuffer is retained anyway so it's been drawn straight into that
+    if(backend == display_backend_framebuffer) {
+        framebuffer_resend = true;
+        image_cache_unlock();
+        return;
+    }
+
+    if(background != nullptr) {
+
+        size_t bytes = LCD_WIDTH * 3 * section_height;
+
+        for(int i = 0; i < num_sections; ++i) {
+            uint8_t *dst = background + i * bytes;
+            memset(dst, 0, bytes);
+            draw_entries(display_lists, i, dst);
+        }
+
+        // the copies read PSRAM directly so get it out of the cache
+        esp_cache_msync(background, LCD_WIDTH * LCD_HEIGHT * 3, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+
+        background_valid = true;
+    }
+    panel_current = false;
+
+    image_cache_unlock();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_clear_background()
+{
+    lcd_wait(frame_in_flight, portMAX_DELAY);
+
+    background_valid = false;
+    panel_current = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_set_scroll(int top, int height, int offset)
+{
+    if(lcd_set_scroll_area(top, height) != ESP_OK) {
+        LOG_E("Bad scroll area %d,%d", top, height);
+        return;
+    }
+    lcd_set_scroll_offset(offset);
+
+    // lines scrolling into view have to be drawn wherever they turn up
+    scroll_active = height != 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_invalidate_scroll()
+{
+    lcd_invalidate_scroll_area();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_benchmark_sections(display_scene_function scene, int frames)
+{
+    if(scene == nullptr || frames <= 0) {
+        return;
+    }
+
+    int original_height = lcd_get_section_height();
+
+    LOG_I("Section benchmark, %d frames per height", frames);
+    LOG_I("height sections  frame_us   fill_us   wait_us   idle_us dma_bytes list_bytes");
+
+    for(int height = LCD_MIN_SECTION_HEIGHT; height <= LCD_MAX_SECTION_HEIGHT; ++height) {
+
+        if(lcd_set_section_height(height) != ESP_OK) {
+            continue;
+        }
+
+        // one frame to settle (image decodes, caches) before measuring
+        display_begin_frame();
+        scene(0);
+        display_end_frame();
+
+        lcd_reset_stats();
+        display_list_peak = 0;
+        display_params_peak = 0;
+
+        int64_t start = esp_timer_get_time();
+
+        for(int frame = 1; frame <= frames; ++frame) {
+            display_begin_frame();
+            scene(frame);
+            display_end_frame();
+        }
+
+        // wait for the last frame to go out so the frame time is the whole frame
+        lcd_wait(frame_in_flight, portMAX_DELAY);
+
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        lcd_stats_t stats;
+        lcd_get_stats(&stats);
+
+        LOG_I("%6d %8d %9lld %9lld %9lld %9lld %9u %10u", height, lcd_get_num_sections(), elapsed / frames, stats.fill_us / frames,
+              stats.dma_wait_us / frames, stats.dma_idle_us / frames, lcd_get_section_buffer_bytes(),
+              display_list_peak + display_params_peak);
+    }
+
+    lcd_set_section_height(original_height);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_set_backend(display_backend new_backend)
+{
+    lcd_wait(frame_in_flight, portMAX_DELAY);
+
+    if(new_backend == backend) {
+        return;
+    }
+
+    if(new_backend == display_backend_framebuffer) {
+
+        if(framebuffer == nullptr) {
+
+            framebuffer = (uint8_t *)heap_caps_aligned_alloc(64, LCD_WIDTH * LCD_HEIGHT * 3, MALLOC_CAP_SPIRAM);
+
+            if(framebuffer == nullptr) {
+                LOG_E("No memory for the framebuffer");
+                return;
+            }
+        }
+
+        // whatever the lists drew last isn't in it
+        memset(framebuffer, 0, LCD_WIDTH * LCD_HEIGHT * 3);
+        framebuffer_resend = true;
+    }
+
+    backend = new_backend;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+display_backend display_get_backend()
+{
+    return backend;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_benchmark_backends(display_scene_function scene, int frames)
+{
+    if(scene == nullptr || frames <= 0) {
+        return;
+    }
+
+    display_backend original_backend = backend;
+
+    static char const *names[] = { "lists", "framebuffer" };
+
+    LOG_I("Backend benchmark, %d frames each", frames);
+    LOG_I("    backend  frame_us  scene_us   fill_us lines/frame");
+
+    for(int b = display_backend_lists; b <= display_backend_framebuffer; ++b) {
+
+        display_set_backend((display_backend)b);
+
+        if(backend != b) {
+            continue;
+        }
+
+        // one frame to settle, and the framebuffer's first frame sends everything
+        display_begin_frame();
+        scene(0);
+        display_end_frame();
+        lcd_wait(frame_in_flight, portMAX_DELAY);
+
+        lcd_reset_stats();
+
+        int64_t scene_us = 0;
+        int64_t start = esp_timer_get_time();
+
+        for(int frame = 1; frame <= frames; ++frame) {
+            display_begin_frame();
+            int64_t scene_start = esp_timer_get_time();
+            scene(frame);
+            scene_us += esp_timer_get_time() - scene_start;
+            display_end_frame();
+        }
+
+        lcd_wait(frame_in_flight, portMAX_DELAY);
+
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        lcd_stats_t stats;
+        lcd_get_stats(&stats);
+
+        LOG_I("%11s %9lld %9lld %9lld %11lld", names[b], elapsed / frames, scene_us / frames, stats.fill_us / frames, stats.lines_sent / frames);
+    }
+
+    display_set_backend(original_backend);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void display_init()
+{
+    lcd_init();
+
+    for(solid_buffer &b : solid_buffers) {
+        b.pixels = (uint8_t *)heap_caps_malloc(LCD_BYTES_PER_LINE * LCD_MAX_SECTION_HEIGHT, MALLOC_CAP_DMA);
+        if(b.pixels == nullptr) {
+            LOG_W("No memory for solid section buffers, they'll be drawn");
+        }
+    }
+
+    for(int i = 0; i < 257; ++i) {
+        gradient_sqrt[i] = (uint16_t)min(65535.0f, sqrtf(i / 256.0f) * 65536.0f);
+    }
+
+    background_copied = xSemaphoreCreateBinary();
+
+    // sections are a whole number of 720 byte lines so the PSRAM side is always 16 byte aligned
+
+    async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    config.psram_trans_align = 16;
+
+    if(esp_async_memcpy_install(&config, &background_memcpy) != ESP_OK) {
+        LOG_W("No async memcpy, the background will be copied by the CPU");
+        background_memcpy = nullptr;
+    }
 }
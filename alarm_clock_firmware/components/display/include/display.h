@@ -20,14 +20,109 @@ void display_init();
 
 void display_begin_frame();
 void display_end_frame();
-void display_list_draw(int section, uint8_t *buffer);
+uint8_t const *display_list_draw(int section, uint8_t *buffer);
+
+// retained background, kept in PSRAM and copied under every frame. Draw it between these two
+// instead of a frame whenever it changes, display_begin_frame then starts from it
+void display_begin_background();
+void display_end_background();
+void display_clear_background();
+
+// hardware scrolled band for tickers and lists (height 0 = off), offset is the content line at the top
+// of the band. Draw the whole frame as usual, keeping the band's contents inside it, and only the sections
+// with lines which scrolled into view get drawn and sent. Invalidate when the band changes in place
+void display_set_scroll(int top, int height, int offset);
+void display_invalidate_scroll();
+
+// lists records the frame and draws it a section at a time as it's sent. framebuffer draws
+// straight into a retained PSRAM framebuffer, so a frame only needs to draw what changed,
+// and only sends the sections which were drawn in. Backgrounds and scrolling are for lists,
+// which can skip unchanged sections too, see display_add_damage
+typedef enum display_backend
+{
+    display_backend_lists = 0,
+    display_backend_framebuffer = 1
+} display_backend;
+
+void display_set_backend(display_backend backend);
+display_backend display_get_backend();
+
+// only what changed is drawn this frame, everything else stays as it is. Call it after display_begin_frame
+// for each changed area and then draw at least pos,size, which can grow to whole sections (lists keep
+// nothing between frames). False if the whole frame has to be drawn, e.g. nothing's been sent yet
+bool display_add_damage(vec2i *pos, vec2i *size);
+
+// draw a scene at each section height the build allows and log frame time, DMA stalls and memory
+typedef void (*display_scene_function)(int frame);
+
+void display_benchmark_sections(display_scene_function scene, int frames);
+
+// draw a scene with each backend and log frame time, time in the scene and lines sent
+void display_benchmark_backends(display_scene_function scene, int frames);
+
+// a transition between two scenes, both drawn each frame. Draw the outgoing scene as usual, then call
+// display_begin_incoming and draw the incoming one. Each section of each is drawn and they're combined
+// as it's sent, so it only needs one more section buffer. Progress is 0 (outgoing) to 1 (incoming)
+typedef enum display_transition
+{
+    display_transition_none = 0,
+    display_transition_crossfade = 1,
+    display_transition_wipe_right = 2,    // the incoming scene is uncovered from the left
+    display_transition_wipe_down = 3,     // and from the top
+    display_transition_slide_left = 4     // the incoming scene pushes the outgoing one off to the left
+} display_transition;
+
+void display_begin_incoming(display_transition transition, float progress);
+
+// everything drawn is clipped to the top clip rectangle (and so to all the ones under it)
+// before it goes in the display lists. The stack is emptied by display_begin_frame
+void display_push_clip(vec2i const *pos, vec2i const *size);
+void display_pop_clip();
 
 void display_image(vec2i *pos, uint8_t image_id, uint8_t alpha, uint8_t blendmode, vec2f *pivot);
 void display_imagerect(vec2i const *dst_pos, vec2i const *src_pos, vec2i const *size, uint8_t image_id, uint8_t alpha, uint8_t blendmode);
 void display_fillrect(vec2i const *dst_pos, vec2i const *size, uint32_t color, uint8_t blendmode);
 
+// image must be A8 or A4, each pixel is color with its alpha scaled by the coverage
+void display_tintrect(vec2i const *dst_pos, vec2i const *src_pos, vec2i const *size, uint8_t image_id, uint32_t color, uint8_t blendmode);
+
 void display_sphere(int offset, uint8_t image_id, uint8_t alpha, uint8_t blendmode);
 
+//////////////////////////////////////////////////////////////////////
+// signed distance field glyphs from an A8 atlas (128 = the edge, spread = distance in atlas pixels at 0 and 255)
+
+typedef struct display_sdf_style
+{
+    uint32_t color;            // ARGB
+    uint32_t outline_color;    // ARGB, alpha 0 for no outline
+    uint32_t glow_color;       // ARGB, alpha 0 for no glow
+    float outline_width;       // screen pixels
+    float glow_width;          // screen pixels beyond the outline
+} display_sdf_style;
+
+// pos is where the top left of the source rectangle lands, scale is screen pixels per atlas pixel
+void display_sdf_glyph(vec2f const *pos, float scale, vec2i const *src_pos, vec2i const *src_size, uint8_t image_id, int spread, display_sdf_style const *style);
+
+//////////////////////////////////////////////////////////////////////
+// anti-aliased circles and arcs, worked out per pixel from the distance to the centre so they're
+// cheap at any size. Angles are radians clockwise from 12 o'clock, a whole turn or more is a ring
+
+void display_arc(vec2f const *centre, float inner_radius, float outer_radius, float start_angle, float end_angle, uint32_t color, uint8_t blendmode);
+
+// filled if thickness is 0, else a ring that thick inside radius
+void display_circle(vec2f const *centre, float radius, float thickness, uint32_t color, uint8_t blendmode);
+
+// anti-aliased line width pixels wide with square ends at p0 and p1, for clock hands and the like
+void display_line(vec2f const *p0, vec2f const *p1, float width, uint32_t color, uint8_t blendmode);
+
+//////////////////////////////////////////////////////////////////////
+// gradient fills of a rectangle, worked out as they're drawn so they need no image. Linear goes from
+// color0 at p0 to color1 at p1, radial from color0 at the centre to color1 at radius, and both carry on
+// with the end colors past that. Dithering hides the banding from the panel's 6 bits per channel
+
+void display_gradient_linear(vec2i const *dst_pos, vec2i const *size, vec2f const *p0, uint32_t color0, vec2f const *p1, uint32_t color1, uint8_t blendmode, bool dither);
+void display_gradient_radial(vec2i const *dst_pos, vec2i const *size, vec2f const *centre, float radius, uint32_t color0, uint32_t color1, uint8_t blendmode, bool dither);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -110,7 +110,7 @@ esp_err_t encoder_init(encoder_config_t *cfg, encoder_handle_t *handle)
 
     encoder->config = *cfg;
 
-    encoder->input_queue = xQueueCreate(32, sizeof(uint8_t));
+    encoder->input_queue = xQueueCreate(ENCODER_QUEUE_LENGTH, sizeof(uint8_t));
 
     gpio_config_t gpiocfg = {};
     gpiocfg.pin_bit_mask = gpio_bit(cfg->gpio_a) | gpio_bit(cfg->gpio_b);
@@ -172,3 +172,14 @@ esp_err_t encoder_get_message(encoder_handle_t encoder, encoder_message_t *msg)
     }
     return ESP_ERR_NOT_FOUND;
 }
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t encoder_get_queue(encoder_handle_t encoder, QueueHandle_t *queue)
+{
+    if(encoder == nullptr || queue == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *queue = encoder->input_queue;
+    return ESP_OK;
+}
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <esp_err.h>
 #include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include "util.h"
 
 #if defined(__cplusplus)
@@ -37,6 +39,9 @@ struct encoder;
 
 typedef struct encoder *encoder_handle_t;
 
+// messages the queue holds before the ISR starts dropping them
+#define ENCODER_QUEUE_LENGTH 32
+
 //////////////////////////////////////////////////////////////////////
 
 esp_err_t encoder_init(encoder_config_t *config, encoder_handle_t *handle);
@@ -44,6 +49,10 @@ esp_err_t encoder_destroy(encoder_handle_t encoder);
 
 esp_err_t encoder_get_message(encoder_handle_t encoder, encoder_message_t *msg);
 
+// the queue the messages arrive in, to wait on in a queue set. Read them with encoder_get_message,
+// one for each time the set returns it
+esp_err_t encoder_get_queue(encoder_handle_t encoder, QueueHandle_t *queue);
+
 //////////////////////////////////////////////////////////////////////
 
 #if defined(__cplusplus)
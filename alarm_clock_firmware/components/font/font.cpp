@@ -14,7 +14,166 @@ LOG_CONTEXT("font");
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t font_drawtext(font_handle_t fnt, vec2i const *pos, uint8_t const *text, uint8_t alpha, int blend_mode)
+namespace
+{
+    uint32_t constexpr REPLACEMENT_CHARACTER = 0xfffd;
+
+    //////////////////////////////////////////////////////////////////////
+    // decode the next UTF-8 sequence. Radio metadata is often Latin-1, so a
+    // byte which doesn't start a valid sequence is taken as a code point by itself
+
+    uint32_t utf8_next(uint8_t const *&text)
+    {
+        uint8_t const *p = text;
+        uint32_t c = *p++;
+
+        if(c < 0x80) {
+            text = p;
+            return c;
+        }
+
+        int extra;
+        uint32_t lowest;
+
+        if((c & 0xe0) == 0xc0) {
+            extra = 1;
+            c &= 0x1f;
+            lowest = 0x80;
+        } else if((c & 0xf0) == 0xe0) {
+            extra = 2;
+            c &= 0x0f;
+            lowest = 0x800;
+        } else if((c & 0xf8) == 0xf0) {
+            extra = 3;
+            c &= 0x07;
+            lowest = 0x10000;
+        } else {
+            return *text++;
+        }
+
+        // the nul terminator fails this test so it's never skipped over
+
+        for(int i = 0; i < extra; ++i) {
+            if((p[i] & 0xc0) != 0x80) {
+                return *text++;
+            }
+            c = (c << 6) | (p[i] & 0x3f);
+        }
+
+        // overlong, surrogate or out of range
+
+        if(c < lowest || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) {
+            return *text++;
+        }
+
+        text = p + extra;
+        return c;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    font_glyph const *find_glyph(font_data const *f, uint32_t codepoint)
+    {
+        if(f->glyph_hash != nullptr) {
+
+            uint32_t mask = f->glyph_hash_size - 1;
+
+            for(uint32_t slot = font_glyph_hash(codepoint) & mask;; slot = (slot + 1) & mask) {
+
+                uint16_t index = f->glyph_hash[slot];
+
+                if(index == FONT_HASH_EMPTY) {
+                    return nullptr;
+                }
+                if(f->glyphs[index].codepoint == codepoint) {
+                    return f->glyphs + index;
+                }
+            }
+        }
+
+        int lo = 0;
+        int hi = f->num_glyphs - 1;
+
+        while(lo <= hi) {
+            int mid = (lo + hi) / 2;
+            uint32_t c = f->glyphs[mid].codepoint;
+            if(c == codepoint) {
+                return f->glyphs + mid;
+            }
+            if(c < codepoint) {
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // something to show for characters the font doesn't have
+
+    font_glyph const *find_glyph_or_fallback(font_data const *f, uint32_t codepoint)
+    {
+        font_glyph const *glyph = find_glyph(f, codepoint);
+
+        if(glyph == nullptr) {
+            glyph = find_glyph(f, REPLACEMENT_CHARACTER);
+        }
+        if(glyph == nullptr) {
+            glyph = find_glyph(f, '?');
+        }
+        return glyph;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    int find_kerning(font_data const *f, uint32_t first, uint32_t second)
+    {
+        if(f->num_kerning == 0) {
+            return 0;
+        }
+
+        if(f->kerning_hash != nullptr) {
+
+            uint32_t mask = f->kerning_hash_size - 1;
+
+            for(uint32_t slot = font_kerning_hash(first, second) & mask;; slot = (slot + 1) & mask) {
+
+                uint16_t index = f->kerning_hash[slot];
+
+                if(index == FONT_HASH_EMPTY) {
+                    return 0;
+                }
+                font_kerning const &k = f->kerning[index];
+                if(k.first == first && k.second == second) {
+                    return k.amount;
+                }
+            }
+        }
+
+        int lo = 0;
+        int hi = f->num_kerning - 1;
+
+        while(lo <= hi) {
+            int mid = (lo + hi) / 2;
+            font_kerning const &k = f->kerning[mid];
+            if(k.first == first && k.second == second) {
+                return k.amount;
+            }
+            if(k.first < first || (k.first == first && k.second < second)) {
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return 0;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t font_drawtext(font_handle_t fnt, vec2i const *pos, uint8_t const *text, uint32_t color, int blend_mode)
 {
     if(fnt == nullptr || pos == nullptr || text == nullptr) {
         return ESP_ERR_INVALID_ARG;
@@ -26,32 +185,53 @@ esp_err_t font_drawtext(font_handle_t fnt, vec2i const *pos, uint8_t const *text
 
     font_data const *f = fnt->font_struct;
 
-    if(f == nullptr || f->graphics == nullptr || f->num_graphics == 0) {
+    if(f == nullptr || f->graphics == nullptr || f->num_graphics == 0 || f->glyphs == nullptr) {
         return ESP_ERR_INVALID_STATE;
     }
 
+    if(f->sdf_spread != 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    image_t const *atlas = image_get(fnt->image_index);
+
+    if(atlas == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    bool tinted = atlas->format != image_format_argb32;
+    uint8_t alpha = color >> 24;
+
     vec2i curpos = *pos;
+    uint32_t prev = 0;
+
+    while(*text != 0) {
+
+        uint32_t c = utf8_next(text);
 
-    for(uint8_t c = *text; c != 0; c = *++text) {
+        curpos.x += find_kerning(f, prev, c);
+        prev = c;
 
-        int char_width = f->advances[c];
+        font_glyph const *glyph = find_glyph_or_fallback(f, c);
 
-        if(char_width <= 0) {
+        if(glyph == nullptr) {
             continue;
         }
 
-        int glyph_index = f->lookup[c];
-
-        if(glyph_index >= 0) {
-            font_graphic const &graphic = f->graphics[glyph_index];
+        if(glyph->graphic >= 0) {
+            font_graphic const &graphic = f->graphics[glyph->graphic];
             vec2i src = { graphic.x, graphic.y };
             vec2i offset = { graphic.offset_x, graphic.offset_y };
             vec2i dst = { curpos.x + offset.x, curpos.y + offset.y };
             vec2i size = { graphic.width, graphic.height };
 
-            display_imagerect(&dst, &src, &size, fnt->image_index, alpha, blend_mode);
+            if(tinted) {
+                display_tintrect(&dst, &src, &size, fnt->image_index, color, blend_mode);
+            } else {
+                display_imagerect(&dst, &src, &size, fnt->image_index, alpha, blend_mode);
+            }
         }
-        curpos.x += char_width;
+        curpos.x += glyph->advance;
     }
     return ESP_OK;
 }
@@ -66,9 +246,25 @@ esp_err_t font_measure_string(font_handle_t fnt, uint8_t const *text, vec2i *siz
 
     font_data const *f = fnt->font_struct;
 
+    if(f == nullptr || f->glyphs == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
     int width = 0;
-    for(uint8_t c = *text; c != 0; c = *++text) {
-        width += f->advances[c];
+    uint32_t prev = 0;
+
+    while(*text != 0) {
+
+        uint32_t c = utf8_next(text);
+
+        width += find_kerning(f, prev, c);
+        prev = c;
+
+        font_glyph const *glyph = find_glyph_or_fallback(f, c);
+
+        if(glyph != nullptr) {
+            width += glyph->advance;
+        }
     }
     size->x = width;
     size->y = f->height;
@@ -78,11 +274,87 @@ esp_err_t font_measure_string(font_handle_t fnt, uint8_t const *text, vec2i *siz
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t font_init(font_data const *fnt, char const *name, uint8_t const *png_start, uint8_t const *png_end, font_handle_t *handle)
+esp_err_t font_drawtext_sdf(font_handle_t fnt, vec2f const *pos, uint8_t const *text, float size, display_sdf_style const *style)
 {
-    LOG_D("init font %s", name);
+    if(fnt == nullptr || pos == nullptr || text == nullptr || style == nullptr || size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    if(handle == nullptr) {
+    if(fnt->image_index == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    font_data const *f = fnt->font_struct;
+
+    if(f == nullptr || f->graphics == nullptr || f->num_graphics == 0 || f->glyphs == nullptr || f->height <= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if(f->sdf_spread == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    float scale = size / f->height;
+    float x = pos->x;
+    uint32_t prev = 0;
+
+    while(*text != 0) {
+
+        uint32_t c = utf8_next(text);
+
+        x += find_kerning(f, prev, c) * scale;
+        prev = c;
+
+        font_glyph const *glyph = find_glyph_or_fallback(f, c);
+
+        if(glyph == nullptr) {
+            continue;
+        }
+
+        if(glyph->graphic >= 0) {
+            font_graphic const &graphic = f->graphics[glyph->graphic];
+            vec2i src = { graphic.x, graphic.y };
+            vec2i src_size = { graphic.width, graphic.height };
+            vec2f dst = { x + graphic.offset_x * scale, pos->y + graphic.offset_y * scale };
+
+            display_sdf_glyph(&dst, scale, &src, &src_size, fnt->image_index, f->sdf_spread, style);
+        }
+        x += glyph->advance * scale;
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t font_measure_string_sdf(font_handle_t fnt, uint8_t const *text, float size, vec2f *out_size)
+{
+    if(out_size == nullptr || text == nullptr || fnt == nullptr || size <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    font_data const *f = fnt->font_struct;
+
+    if(f == nullptr || f->glyphs == nullptr || f->height <= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    vec2i unscaled;
+    ESP_RETURN_IF_FAILED(font_measure_string(fnt, text, &unscaled));
+
+    float scale = size / f->height;
+    out_size->x = unscaled.x * scale;
+    out_size->y = size;
+
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t font_create(font_data const *fnt, char const *name, int image_id, font_handle_t *handle)
+{
+    LOG_D("create font %s", name);
+
+    if(handle == nullptr || fnt == nullptr || image_id <= 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
@@ -94,10 +366,24 @@ esp_err_t font_init(font_data const *fnt, char const *name, uint8_t const *png_s
 
     new_font->name = name;
     new_font->font_struct = fnt;
-    esp_err_t ret = image_decode_png(name, &new_font->image_index, png_start, png_end - png_start);
+    new_font->image_index = image_id;
+
+    *handle = new_font;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
 
-    if(ret == ESP_OK) {
-        *handle = new_font;
+esp_err_t font_init(font_data const *fnt, char const *name, uint8_t const *png_start, uint8_t const *png_end, font_handle_t *handle)
+{
+    LOG_D("init font %s", name);
+
+    if(handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
     }
-    return ret;
+
+    int image_id;
+    ESP_RETURN_IF_FAILED(image_decode_png(name, &image_id, png_start, png_end - png_start));
+
+    return font_create(fnt, name, image_id, handle);
 }
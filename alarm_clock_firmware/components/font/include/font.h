@@ -9,29 +9,25 @@ extern "C" {
 #include <stdint.h>
 #include <esp_err.h>
 
-//////////////////////////////////////////////////////////////////////
-
-typedef struct font_graphic
-{
-    int8_t offset_x;
-    int8_t offset_y;
-    uint8_t x;
-    uint8_t y;
-    uint8_t width;
-    uint8_t height;
-} font_graphic;
+#include "font_format.h"
+#include "display.h"
 
 //////////////////////////////////////////////////////////////////////
 
 typedef struct font_data
 {
-    font_graphic *graphics;
-    int16_t *lookup;
-    uint8_t *advances;
+    font_graphic const *graphics;
+    font_glyph const *glyphs;        // sorted by codepoint
+    font_kerning const *kerning;     // sorted by first then second, can be NULL
+    uint16_t const *glyph_hash;      // optional, glyph index by font_glyph_hash
+    uint16_t const *kerning_hash;    // optional, kerning index by font_kerning_hash
     int height;
     int num_graphics;
-    int num_lookup;
-    int num_advances;
+    int num_glyphs;
+    int num_kerning;
+    int glyph_hash_size;      // power of 2
+    int kerning_hash_size;    // power of 2
+    int sdf_spread;           // non zero if the atlas is an A8 signed distance field
 } font_data;
 
 //////////////////////////////////////////////////////////////////////
@@ -47,12 +43,23 @@ typedef struct font_t *font_handle_t;
 
 //////////////////////////////////////////////////////////////////////
 
+// font_data must outlive the font, font_init decodes the png, font_create uses an image which is already loaded
 esp_err_t font_init(font_data const *fnt, char const *name, uint8_t const *png_start, uint8_t const *png_end, font_handle_t *handle);
+esp_err_t font_create(font_data const *fnt, char const *name, int image_id, font_handle_t *handle);
+
+// text is UTF-8, bytes which aren't part of a valid sequence are taken as Latin-1
 
-esp_err_t font_drawtext(font_handle_t fnt, vec2i const *pos, uint8_t const *text, uint8_t alpha, int blend_mode);
+// color is ARGB, A4/A8 fonts are drawn in it, ARGB32 fonts keep their own colors and just use its alpha
+esp_err_t font_drawtext(font_handle_t fnt, vec2i const *pos, uint8_t const *text, uint32_t color, int blend_mode);
 
 esp_err_t font_measure_string(font_handle_t fnt, uint8_t const *text, vec2i *size);
 
+// distance field fonts draw at any size (the height of a line in pixels), font_drawtext won't draw them
+
+esp_err_t font_drawtext_sdf(font_handle_t fnt, vec2f const *pos, uint8_t const *text, float size, display_sdf_style const *style);
+
+esp_err_t font_measure_string_sdf(font_handle_t fnt, uint8_t const *text, float size, vec2f *out_size);
+
 //////////////////////////////////////////////////////////////////////
 
 #define __FONT_JOIN2(x, y) x##y
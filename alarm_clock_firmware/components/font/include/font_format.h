@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////
+// Font tables, shared with tools/asset_compiler so plain C only
+//
+// Glyphs are sorted by code point so a font only pays for the glyphs it has.
+// The optional hash tables (built offline) make lookups a single probe,
+// without them lookups fall back to a binary search.
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+#define FONT_HASH_EMPTY 0xffff
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct font_graphic
+{
+    int8_t offset_x;
+    int8_t offset_y;
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+} font_graphic;
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct font_glyph
+{
+    uint32_t codepoint;
+    int16_t graphic;    // index into graphics or -1 (e.g. space)
+    uint8_t advance;
+    uint8_t reserved;
+} font_glyph;
+
+//////////////////////////////////////////////////////////////////////
+
+typedef struct font_kerning
+{
+    uint32_t first;
+    uint32_t second;
+    int16_t amount;    // added to the advance of first when second follows it
+    uint16_t reserved;
+} font_kerning;
+
+//////////////////////////////////////////////////////////////////////
+// slot = hash & (hash_size - 1), then linear probing
+
+static inline uint32_t font_glyph_hash(uint32_t codepoint)
+{
+    return (codepoint * 2654435761u) >> 16;
+}
+
+static inline uint32_t font_kerning_hash(uint32_t first, uint32_t second)
+{
+    return ((first * 2654435761u) ^ (second * 2246822519u)) >> 16;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+}
+#endif
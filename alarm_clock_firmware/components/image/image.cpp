@@ -1,15 +1,23 @@
 //////////////////////////////////////////////////////////////////////
+// Images are either decoded up front (image_decode_png, resident forever)
+// or registered with a source and decoded on first image_acquire.
+// Registered images which nobody holds a reference to sit in an LRU list
+// and get evicted when the cache is over budget or PSRAM is running low.
+
+#include <string.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <esp_http_client.h>
 
 #include "pngle.h"
 #include "util.h"
+#include "chs_list.h"
 #include "image.h"
-#include "util.h"
 
 LOG_CONTEXT("image");
 
@@ -19,16 +27,149 @@ namespace
 {
     int constexpr MAX_IMAGES = 64;
 
+    // bytes read from a flash partition or http at a time
+
+    size_t constexpr STREAM_CHUNK_SIZE = 4096;
+
+    // always leave this much PSRAM free for everyone else
+
+    size_t constexpr PSRAM_RESERVE = 512 * 1024;
+
+    size_t constexpr DEFAULT_CACHE_BUDGET = 4 * 1024 * 1024;
+
+    //////////////////////////////////////////////////////////////////////
+
+    enum image_source_type
+    {
+        image_source_none = 0,    // decoded by image_decode_png, never evicted
+        image_source_embedded,
+        image_source_partition,
+        image_source_http,
+        image_source_fill    // image_register_fill, pixels come from a callback
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    struct image_info : chs::list_node<image_info>
+    {
+        char const *name;
+        image_source_type source_type;
+        int ref_count;
+        bool in_lru;
+
+        union
+        {
+            struct
+            {
+                uint8_t const *data;
+                size_t size;
+            } embedded;
+
+            struct
+            {
+                esp_partition_t const *partition;
+                size_t offset;
+                size_t size;
+            } partition;
+
+            struct
+            {
+                char *url;
+            } http;
+
+            struct
+            {
+                image_fill_function_t fill;
+                void *context;
+                image_format_t format;
+                uint16_t width;
+                uint16_t height;
+            } fill;
+        };
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    // image id 0 is reserved to mean 'not loaded'
+
     EXT_RAM_BSS_ATTR image_t images[MAX_IMAGES];
-    int num_images = 0;
+    image_info image_infos[MAX_IMAGES];
+    int num_images = 1;
+
+    // protects the tables and the cache accounting
 
     SemaphoreHandle_t image_semaphore;
 
+    // serializes lazy decodes so two tasks don't decode the same image at once
+
+    SemaphoreHandle_t load_semaphore;
+
+    // unreferenced, resident, evictable images - least recently used at the front
+
+    chs::linked_list<image_info> lru_list;
+
+    // only registered images count, pinned ones can never be evicted so they'd just eat the budget
+
+    size_t cache_bytes = 0;
+    size_t cache_budget = DEFAULT_CACHE_BUDGET;
+
+    // no evictions while a frame which might reference any image is being built and drawn
+
+    int cache_lock_count = 0;
+
+    //////////////////////////////////////////////////////////////////////
+
+    size_t image_bytes(image_t const &img)
+    {
+        return image_format_stride(img.format, img.width) * img.height;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // call with image_semaphore held, cached is whether bytes_needed will count against the budget
+
+    void evict_until(size_t bytes_needed, bool cached)
+    {
+        while(cache_lock_count == 0 && !lru_list.empty()) {
+
+            bool over_budget = cache_bytes + (cached ? bytes_needed : 0) > cache_budget;
+            bool low_memory = heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < bytes_needed + PSRAM_RESERVE;
+
+            if(!over_budget && !low_memory) {
+                break;
+            }
+
+            image_info *info = lru_list.pop_front();
+            info->in_lru = false;
+
+            int image_id = info - image_infos;
+            image_t &img = images[image_id];
+
+            LOG_D("Evict %s (%d bytes)", info->name, image_bytes(img));
+
+            cache_bytes -= image_bytes(img);
+            heap_caps_free(const_cast<uint32_t *>(img.pixel_data));
+            img.pixel_data = nullptr;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // pngle's user data while decoding
+
+    struct png_decode
+    {
+        image_t *img;
+        bool cached;    // registered image, counts against the cache budget
+        bool done;      // got as far as IEND, anything less is a truncated file
+    };
+
     //////////////////////////////////////////////////////////////////////
 
     void setpixel(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
     {
-        image_t *img = (image_t *)pngle_get_user_data(pngle);
+        image_t *img = ((png_decode *)pngle_get_user_data(pngle))->img;
+        if(img->pixel_data == nullptr) {
+            return;
+        }
         uint32_t r = rgba[0] << 16;
         uint32_t g = rgba[1] << 8;
         uint32_t b = rgba[2] << 0;
@@ -38,15 +179,343 @@ namespace
     }
 
     //////////////////////////////////////////////////////////////////////
+    // fast path, convert a whole RGBA8 scanline to ARGB32
 
-    void on_init(pngle_t *pngle, uint32_t w, uint32_t h)
+    void on_row(pngle_t *pngle, uint32_t y, uint32_t w, uint8_t const *rgba)
     {
-        image_t *img = (image_t *)pngle_get_user_data(pngle);
+        image_t *img = ((png_decode *)pngle_get_user_data(pngle))->img;
+        if(img->pixel_data == nullptr) {
+            return;
+        }
+        uint32_t *dst = const_cast<uint32_t *>(img->pixel_data) + y * w;
+        for(uint32_t x = w; x != 0; --x) {
+            *dst++ = (rgba[3] << 24) | (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+            rgba += 4;
+        }
+    }
 
+    //////////////////////////////////////////////////////////////////////
+
+    void alloc_pixels(image_t *img, int w, int h, bool cached)
+    {
+        // img->format must already be set, PNG decodes are always ARGB32
         img->width = w;
         img->height = h;
-        img->pixel_data = (uint32_t const *)heap_caps_malloc(w * h * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
-        assert(img->pixel_data != NULL);
+
+        size_t bytes = image_bytes(*img);
+
+        // make room first, then account for it so parallel decodes don't all think there's space
+
+        xSemaphoreTake(image_semaphore, portMAX_DELAY);
+        evict_until(bytes, cached);
+        img->pixel_data = (uint32_t const *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        if(img->pixel_data != nullptr && cached) {
+            cache_bytes += bytes;
+        }
+        xSemaphoreGive(image_semaphore);
+
+        if(img->pixel_data == nullptr) {
+            LOG_E("Can't allocate %d bytes for %dx%d image", bytes, w, h);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_init(pngle_t *pngle, uint32_t w, uint32_t h)
+    {
+        png_decode *decode = (png_decode *)pngle_get_user_data(pngle);
+        alloc_pixels(decode->img, w, h, decode->cached);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_done(pngle_t *pngle)
+    {
+        ((png_decode *)pngle_get_user_data(pngle))->done = true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void free_pixels(image_t &img, bool cached)
+    {
+        if(img.pixel_data != nullptr) {
+            if(cached) {
+                xSemaphoreTake(image_semaphore, portMAX_DELAY);
+                cache_bytes -= image_bytes(img);
+                xSemaphoreGive(image_semaphore);
+            }
+            heap_caps_free(const_cast<uint32_t *>(img.pixel_data));
+            img.pixel_data = nullptr;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    pngle_t *new_decoder(png_decode *decode)
+    {
+        pngle_t *pngle = pngle_new();
+
+        if(pngle != nullptr) {
+            pngle_set_user_data(pngle, decode);
+            pngle_set_init_callback(pngle, on_init);
+            pngle_set_draw_callback(pngle, setpixel);    // interlaced images only
+            pngle_set_row_callback(pngle, on_row);
+            pngle_set_done_callback(pngle, on_done);
+        }
+        return pngle;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // returns bytes read, 0 at the end, < 0 on error
+
+    typedef int (*stream_read_fn)(void *context, uint8_t *buffer, size_t len);
+
+    esp_err_t decode_stream(pngle_t *pngle, stream_read_fn read, void *context)
+    {
+        uint8_t *buffer = (uint8_t *)heap_caps_malloc(STREAM_CHUNK_SIZE, MALLOC_CAP_INTERNAL);
+
+        if(buffer == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t ret = ESP_OK;
+        size_t remain = 0;
+
+        while(true) {
+
+            int got = read(context, buffer + remain, STREAM_CHUNK_SIZE - remain);
+
+            if(got < 0) {
+                ret = ESP_FAIL;
+                break;
+            }
+            if(got == 0) {
+                if(!((png_decode *)pngle_get_user_data(pngle))->done) {
+                    LOG_E("PNG is truncated");
+                    ret = ESP_FAIL;
+                }
+                break;
+            }
+
+            remain += got;
+
+            int fed = pngle_feed(pngle, buffer, remain);
+
+            if(fed < 0) {
+                LOG_E("PNGLE Error: %s", pngle_error(pngle));
+                ret = ESP_FAIL;
+                break;
+            }
+
+            // keep whatever pngle couldn't consume yet for next time
+            remain -= fed;
+            memmove(buffer, buffer + fed, remain);
+        }
+
+        heap_caps_free(buffer);
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    struct partition_reader
+    {
+        esp_partition_t const *partition;
+        size_t offset;
+        size_t remain;
+    };
+
+    int read_partition(void *context, uint8_t *buffer, size_t len)
+    {
+        partition_reader *r = reinterpret_cast<partition_reader *>(context);
+        len = min(len, r->remain);
+        if(len == 0) {
+            return 0;
+        }
+        if(esp_partition_read(r->partition, r->offset, buffer, len) != ESP_OK) {
+            return -1;
+        }
+        r->offset += len;
+        r->remain -= len;
+        return (int)len;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    int read_http(void *context, uint8_t *buffer, size_t len)
+    {
+        return esp_http_client_read(reinterpret_cast<esp_http_client_handle_t>(context), (char *)buffer, len);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t decode_http(pngle_t *pngle, char const *url)
+    {
+        esp_http_client_config_t config = {};
+        config.url = url;
+
+        esp_http_client_handle_t client = esp_http_client_init(&config);
+
+        if(client == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t ret = esp_http_client_open(client, 0);
+
+        if(ret == ESP_OK) {
+            esp_http_client_fetch_headers(client);
+            int status = esp_http_client_get_status_code(client);
+            if(status == 200) {
+                ret = decode_stream(pngle, read_http, client);
+            } else {
+                LOG_E("HTTP status %d for %s", status, url);
+                ret = ESP_ERR_NOT_FOUND;
+            }
+            esp_http_client_close(client);
+        }
+        esp_http_client_cleanup(client);
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t fill_source(image_info const &info, image_t *img)
+    {
+        img->format = info.fill.format;
+        alloc_pixels(img, info.fill.width, info.fill.height, true);
+
+        if(img->pixel_data == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t ret = info.fill.fill(info.fill.context, const_cast<uint32_t *>(img->pixel_data), img->width, img->height);
+
+        if(ret != ESP_OK) {
+            LOG_E("Can't fill %s: %d", info.name, ret);
+            free_pixels(*img, true);
+        }
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t decode_source(image_info const &info, image_t *img)
+    {
+        if(info.source_type == image_source_fill) {
+            return fill_source(info, img);
+        }
+
+        png_decode decode = { img, true, false };
+
+        pngle_t *pngle = new_decoder(&decode);
+
+        if(pngle == nullptr) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+        switch(info.source_type) {
+
+        case image_source_embedded:
+            ret = (pngle_feed(pngle, info.embedded.data, info.embedded.size) < 0 || !decode.done) ? ESP_FAIL : ESP_OK;
+            break;
+
+        case image_source_partition: {
+            partition_reader reader = { info.partition.partition, info.partition.offset, info.partition.size };
+            ret = decode_stream(pngle, read_partition, &reader);
+        } break;
+
+        case image_source_http:
+            ret = decode_http(pngle, info.http.url);
+            break;
+
+        default:
+            break;
+        }
+
+        if(ret == ESP_OK && img->pixel_data == nullptr) {
+            ret = ESP_ERR_NO_MEM;
+        }
+
+        if(ret != ESP_OK) {
+            LOG_E("Can't decode %s: %s", info.name, pngle_error(pngle));
+            free_pixels(*img, true);
+        }
+
+        pngle_destroy(pngle);
+        return ret;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // call with image_semaphore held
+
+    esp_err_t allocate_image_id(char const *name, image_source_type source_type, int *out_image_id)
+    {
+        if(num_images == MAX_IMAGES) {
+            LOG_E("Too many images");
+            return ESP_ERR_NO_MEM;
+        }
+
+        int image_id = num_images;
+        num_images += 1;
+
+        image_t &img = images[image_id];
+        img = {};
+        img.image_id = image_id;
+
+        image_info &info = image_infos[image_id];
+        info.name = name;
+        info.source_type = source_type;
+        info.ref_count = 0;
+        info.in_lru = false;
+
+        *out_image_id = image_id;
+        return ESP_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    // add a fully decoded image which stays resident forever
+
+    esp_err_t add_pinned_image(char const *name, image_t &temp_image, int *out_image_id)
+    {
+        // decodes can run in parallel on both cores, only the table update is serialized
+
+        xSemaphoreTake(image_semaphore, portMAX_DELAY);
+        int image_id;
+        esp_err_t ret = allocate_image_id(name, image_source_none, &image_id);
+        if(ret == ESP_OK) {
+            image_t *new_image = images + image_id;
+            *new_image = temp_image;
+            new_image->image_id = image_id;
+            image_infos[image_id].ref_count = 1;    // pinned
+        }
+        xSemaphoreGive(image_semaphore);
+
+        if(ret != ESP_OK) {
+            free_pixels(temp_image, false);
+            return ret;
+        }
+
+        *out_image_id = image_id;
+        return ESP_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    template <typename F> esp_err_t register_image(char const *name, image_source_type source_type, int *out_image_id, F set_source)
+    {
+        if(out_image_id == nullptr) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        xSemaphoreTake(image_semaphore, portMAX_DELAY);
+        esp_err_t ret = allocate_image_id(name, source_type, out_image_id);
+        if(ret == ESP_OK) {
+            set_source(image_infos[*out_image_id]);
+        }
+        xSemaphoreGive(image_semaphore);
+        return ret;
     }
 
 }    // namespace
@@ -55,7 +524,7 @@ namespace
 
 image_t const *image_get(int image_id)
 {
-    if(image_id <= 0 || image_id > num_images) {
+    if(image_id <= 0 || image_id >= num_images || images[image_id].pixel_data == nullptr) {
         return NULL;
     }
     return images + image_id;
@@ -74,45 +543,299 @@ esp_err_t image_decode_png(char const *name, int *out_image_id, uint8_t const *p
 {
     LOG_I("%s", name);
 
-    pngle_t *pngle = pngle_new();
+    image_t temp_image = {};
+
+    png_decode decode = { &temp_image, false, false };
+
+    pngle_t *pngle = new_decoder(&decode);
 
     if(pngle == nullptr) {
         return ESP_ERR_NO_MEM;
     }
 
-    image_t temp_image;
-
-    pngle_set_user_data(pngle, &temp_image);
-    pngle_set_init_callback(pngle, on_init);
-    pngle_set_draw_callback(pngle, setpixel);
-
     int err = pngle_feed(pngle, png_data, png_size);
 
-    if(err < 0) {
-        LOG_E("PNGLE Error %d", err);
-        heap_caps_free(const_cast<void *>(reinterpret_cast<void const *>(temp_image.pixel_data)));
-        return ESP_FAIL;
+    if(err < 0 || temp_image.pixel_data == nullptr || !decode.done) {
+        LOG_E("PNGLE Error %d: %s", err, (err >= 0 && !decode.done) ? "truncated" : pngle_error(pngle));
+        pngle_destroy(pngle);
+        free_pixels(temp_image, false);
+        return (err >= 0 && temp_image.pixel_data == nullptr) ? ESP_ERR_NO_MEM : ESP_FAIL;
     }
     pngle_destroy(pngle);
 
+    ESP_RETURN_IF_FAILED(add_pinned_image(name, temp_image, out_image_id));
+
+    LOG_D("Decoded PNG id %d (%dx%d)", *out_image_id, temp_image.width, temp_image.height);
+
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t image_format_stride(image_format_t format, int width)
+{
+    switch(format) {
+    case image_format_a8:
+        return width;
+    case image_format_a4:
+        return (width + 1) / 2;
+    default:
+        return width * sizeof(uint32_t);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_create(char const *name, image_format_t format, int width, int height, image_fill_function_t fill, void *context, int *out_image_id)
+{
+    if(fill == nullptr || out_image_id == nullptr || width <= 0 || height <= 0 || format < image_format_argb32 || format > image_format_a4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    LOG_I("%s", name);
+
+    image_t temp_image = {};
+    temp_image.format = format;
+
+    alloc_pixels(&temp_image, width, height, false);
+
+    if(temp_image.pixel_data == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = fill(context, const_cast<uint32_t *>(temp_image.pixel_data), width, height);
+
+    if(ret != ESP_OK) {
+        LOG_E("Can't fill %s: %d", name, ret);
+        free_pixels(temp_image, false);
+        return ret;
+    }
+
+    return add_pinned_image(name, temp_image, out_image_id);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_register_embedded(char const *name, uint8_t const *png_data, size_t png_size, int *out_image_id)
+{
+    if(png_data == nullptr || png_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return register_image(name, image_source_embedded, out_image_id, [=](image_info &info) {
+        info.embedded.data = png_data;
+        info.embedded.size = png_size;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_register_partition(char const *name, char const *partition_label, size_t offset, size_t size, int *out_image_id)
+{
+    esp_partition_t const *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+
+    if(partition == nullptr) {
+        LOG_E("Can't find partition %s", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if(size == 0 || offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return register_image(name, image_source_partition, out_image_id, [=](image_info &info) {
+        info.partition.partition = partition;
+        info.partition.offset = offset;
+        info.partition.size = size;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_register_http(char const *name, char const *url, int *out_image_id)
+{
+    if(url == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char *url_copy = strdup(url);
+
+    if(url_copy == nullptr) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = register_image(name, image_source_http, out_image_id, [=](image_info &info) { info.http.url = url_copy; });
+
+    if(ret != ESP_OK) {
+        free(url_copy);
+    }
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_register_fill(char const *name, image_format_t format, int width, int height, image_fill_function_t fill, void *context, int *out_image_id)
+{
+    if(fill == nullptr || width <= 0 || height <= 0 || width > UINT16_MAX || height > UINT16_MAX || format < image_format_argb32 || format > image_format_a4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return register_image(name, image_source_fill, out_image_id, [=](image_info &info) {
+        info.fill.fill = fill;
+        info.fill.context = context;
+        info.fill.format = format;
+        info.fill.width = (uint16_t)width;
+        info.fill.height = (uint16_t)height;
+    });
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t image_acquire(int image_id, image_t const **out_image)
+{
+    if(image_id <= 0 || image_id >= num_images) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    image_info &info = image_infos[image_id];
+    image_t &img = images[image_id];
+
+    // take a reference, pulling it out of the LRU list if it was in there
+
     xSemaphoreTake(image_semaphore, portMAX_DELAY);
-    image_t *new_image = images + num_images;
-    *new_image = temp_image;
-    new_image->image_id = num_images;
-    num_images += 1;
+    if(info.in_lru) {
+        lru_list.remove(&info);
+        info.in_lru = false;
+    }
+    info.ref_count += 1;
+    bool resident = img.pixel_data != nullptr;
     xSemaphoreGive(image_semaphore);
 
-    LOG_D("Decoded PNG id %d (%dx%d)", temp_image.image_id, temp_image.width, temp_image.height);
+    esp_err_t ret = ESP_OK;
+
+    if(!resident) {
+
+        xSemaphoreTake(load_semaphore, portMAX_DELAY);
+
+        // someone else might have loaded it while we waited
+        if(img.pixel_data == nullptr) {
+
+            LOG_I("Load %s", info.name);
 
-    *out_image_id = new_image->image_id;
+            image_t temp_image = {};
+            ret = decode_source(info, &temp_image);
 
+            if(ret == ESP_OK) {
+                xSemaphoreTake(image_semaphore, portMAX_DELAY);
+                img.format = temp_image.format;
+                img.width = temp_image.width;
+                img.height = temp_image.height;
+                img.pixel_data = temp_image.pixel_data;
+                xSemaphoreGive(image_semaphore);
+            }
+        }
+
+        xSemaphoreGive(load_semaphore);
+    }
+
+    if(ret != ESP_OK) {
+        xSemaphoreTake(image_semaphore, portMAX_DELAY);
+        info.ref_count -= 1;
+        xSemaphoreGive(image_semaphore);
+        return ret;
+    }
+
+    if(out_image != nullptr) {
+        *out_image = &img;
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
+esp_err_t image_release(int image_id)
+{
+    if(image_id <= 0 || image_id >= num_images) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    image_info &info = image_infos[image_id];
+
+    xSemaphoreTake(image_semaphore, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+
+    if(info.ref_count <= 0) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        info.ref_count -= 1;
+        if(info.ref_count == 0 && info.source_type != image_source_none && images[image_id].pixel_data != nullptr) {
+            lru_list.push_back(&info);
+            info.in_lru = true;
+            evict_until(0, true);
+        }
+    }
+    xSemaphoreGive(image_semaphore);
+    return ret;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void image_cache_set_budget(size_t bytes)
+{
+    xSemaphoreTake(image_semaphore, portMAX_DELAY);
+    cache_budget = bytes;
+    evict_until(0, true);
+    xSemaphoreGive(image_semaphore);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t image_cache_trim(size_t bytes_wanted)
+{
+    xSemaphoreTake(image_semaphore, portMAX_DELAY);
+    size_t before = cache_bytes;
+    evict_until(bytes_wanted, true);
+    size_t freed = before - cache_bytes;
+    xSemaphoreGive(image_semaphore);
+    return freed;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t image_cache_get_used()
+{
+    return cache_bytes;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void image_cache_lock()
+{
+    xSemaphoreTake(image_semaphore, portMAX_DELAY);
+    cache_lock_count += 1;
+    xSemaphoreGive(image_semaphore);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void image_cache_unlock()
+{
+    xSemaphoreTake(image_semaphore, portMAX_DELAY);
+    cache_lock_count -= 1;
+    evict_until(0, true);
+    xSemaphoreGive(image_semaphore);
+}
+
+//////////////////////////////////////////////////////////////////////
+
 esp_err_t image_init()
 {
     image_semaphore = xSemaphoreCreateMutex();
+    ESP_RETURN_IF_NULL(image_semaphore);
+
+    load_semaphore = xSemaphoreCreateMutex();
+    ESP_RETURN_IF_NULL(load_semaphore);
+
+    lru_list.clear();
     return ESP_OK;
 }
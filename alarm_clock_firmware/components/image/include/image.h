@@ -10,23 +10,69 @@
 extern "C" {
 #endif
 
+typedef enum image_format
+{
+    image_format_argb32 = 0,
+    image_format_a8 = 1,    // one byte per pixel, e.g. an SDF font atlas
+    image_format_a4 = 2,    // two pixels per byte, left one in the high nibble, rows padded to a whole byte
+
+} image_format_t;
+
 typedef struct image
 {
-    uint32_t const *pixel_data;
+    union
+    {
+        uint32_t const *pixel_data;    // image_format_argb32
+        uint8_t const *alpha_data;     // image_format_a8, image_format_a4
+    };
     int width;
     int height;
     int image_id;
+    image_format_t format;
 } image_t;
 
 //////////////////////////////////////////////////////////////////////
 
 esp_err_t image_init();
 
+// returns NULL if the image isn't resident
 image_t const *image_get(int image_id);
 image_t const *image_get_unchecked(int image_id);
 
+// decode now, the image stays resident forever
 esp_err_t image_decode_png(char const *name, int *out_image_id, uint8_t const *png_data, size_t png_size);
 
+// allocate a resident image and have fill() write its pixels, for decoders of other formats
+typedef esp_err_t (*image_fill_function_t)(void *context, void *pixels, int width, int height);
+
+esp_err_t image_create(char const *name, image_format_t format, int width, int height, image_fill_function_t fill, void *context, int *out_image_id);
+
+// bytes per row
+size_t image_format_stride(image_format_t format, int width);
+
+//////////////////////////////////////////////////////////////////////
+// lazily decoded images, decoded by the first image_acquire and
+// evicted (least recently released first) once nothing holds a reference
+
+esp_err_t image_register_embedded(char const *name, uint8_t const *png_data, size_t png_size, int *out_image_id);
+esp_err_t image_register_partition(char const *name, char const *partition_label, size_t offset, size_t size, int *out_image_id);
+esp_err_t image_register_http(char const *name, char const *url, int *out_image_id);
+
+// like image_create but fill() runs on each image_acquire which finds it evicted, context must outlive the image
+esp_err_t image_register_fill(char const *name, image_format_t format, int width, int height, image_fill_function_t fill, void *context, int *out_image_id);
+
+esp_err_t image_acquire(int image_id, image_t const **out_image);
+esp_err_t image_release(int image_id);
+
+// the budget and usage only cover these, not image_decode_png or image_create images
+void image_cache_set_budget(size_t bytes);
+size_t image_cache_trim(size_t bytes_wanted);
+size_t image_cache_get_used();
+
+// no evictions between lock and unlock (e.g. while a frame which refers to images is being drawn)
+void image_cache_lock();
+void image_cache_unlock();
+
 //////////////////////////////////////////////////////////////////////
 
 #if defined(__cplusplus)
@@ -31,9 +31,11 @@
 #include "miniz.h"
 #include "pngle.h"
 
+#if defined(ESP_PLATFORM)
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#endif
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
@@ -45,7 +47,9 @@
 #define debug_printf(...) ((void)0)
 #endif
 
+#if defined(ESP_PLATFORM)
 #define PNGLE_MEM_CAPS MALLOC_CAP_SPIRAM
+#endif
 
 #define PNGLE_ERROR(s) (pngle->error = (s), pngle->state = PNGLE_STATE_ERROR, -1)
 
@@ -57,16 +61,25 @@
 
 void *pngle_calloc(size_t n, size_t s, char const *name)
 {
+    PNGLE_UNUSED(name);
+#if defined(ESP_PLATFORM)
     void *data = heap_caps_malloc(n * s, PNGLE_MEM_CAPS);
     if(data != NULL) {
         memset(data, 0, n * s);
     }
     return data;
+#else
+    return calloc(n, s);
+#endif
 }
 
 void pngle_free(void *p)
 {
+#if defined(ESP_PLATFORM)
     heap_caps_free(p);
+#else
+    free(p);
+#endif
 }
 
 typedef enum
@@ -123,6 +136,16 @@ struct _pngle_t
     uint32_t drawing_x;
     uint32_t drawing_y;
 
+    // row output (non-interlaced images only), hdr.width RGBA8 pixels
+    uint8_t *row_buf;
+
+    // whole scanline decoder for 8 bit row output, two lines each with bytes_per_pixel of zero padding in front
+    uint8_t *line_buf;
+    uint8_t *line_cur;
+    uint8_t *line_prev;
+    size_t line_stride;
+    size_t line_pos;
+
     // interlace
     uint_fast8_t interlace_pass;
 
@@ -134,6 +157,7 @@ struct _pngle_t
     // callbacks
     pngle_init_callback_t init_callback;
     pngle_draw_callback_t draw_callback;
+    pngle_row_callback_t row_callback;
     pngle_done_callback_t done_callback;
 
     // misc
@@ -186,6 +210,10 @@ void pngle_reset(pngle_t *pngle)
 
     if(pngle->scanline_ringbuf)
         PNGLE_FREE(pngle->scanline_ringbuf);
+    if(pngle->row_buf)
+        PNGLE_FREE(pngle->row_buf);
+    if(pngle->line_buf)
+        PNGLE_FREE(pngle->line_buf);
     if(pngle->palette)
         PNGLE_FREE(pngle->palette);
     if(pngle->trans_palette)
@@ -196,6 +224,8 @@ void pngle_reset(pngle_t *pngle)
 #endif
 
     pngle->scanline_ringbuf = NULL;
+    pngle->row_buf = NULL;
+    pngle->line_buf = NULL;
     pngle->palette = NULL;
     pngle->trans_palette = NULL;
 #ifndef PNGLE_NO_GAMMA_CORRECTION
@@ -275,10 +305,16 @@ static int is_trans_color(pngle_t *pngle, uint16_t *value, size_t n)
     return 1;    // true
 }
 
+// indices only ever step forward by less than the ring size, so wrap with a compare instead of a divide
+static inline size_t ringbuf_wrap(pngle_t *pngle, size_t idx)
+{
+    return idx >= pngle->scanline_ringbuf_size ? idx - pngle->scanline_ringbuf_size : idx;
+}
+
 static inline void scanline_ringbuf_push(pngle_t *pngle, uint8_t value)
 {
     pngle->scanline_ringbuf[pngle->scanline_ringbuf_cidx] = value;
-    pngle->scanline_ringbuf_cidx = (pngle->scanline_ringbuf_cidx + 1) % pngle->scanline_ringbuf_size;
+    pngle->scanline_ringbuf_cidx = ringbuf_wrap(pngle, pngle->scanline_ringbuf_cidx + 1);
 }
 
 static inline uint16_t get_value(pngle_t *pngle, size_t *ridx, int *bitcount, int depth)
@@ -291,7 +327,7 @@ static inline uint16_t get_value(pngle_t *pngle, size_t *ridx, int *bitcount, in
     case 4:
         if(*bitcount >= 8) {
             *bitcount = 0;
-            *ridx = (*ridx + 1) % pngle->scanline_ringbuf_size;
+            *ridx = ringbuf_wrap(pngle, *ridx + 1);
         }
         *bitcount += depth;
         uint8_t mask = ((1UL << depth) - 1);
@@ -300,15 +336,15 @@ static inline uint16_t get_value(pngle_t *pngle, size_t *ridx, int *bitcount, in
 
     case 8:
         v = pngle->scanline_ringbuf[*ridx];
-        *ridx = (*ridx + 1) % pngle->scanline_ringbuf_size;
+        *ridx = ringbuf_wrap(pngle, *ridx + 1);
         return v;
 
     case 16:
         v = pngle->scanline_ringbuf[*ridx];
-        *ridx = (*ridx + 1) % pngle->scanline_ringbuf_size;
+        *ridx = ringbuf_wrap(pngle, *ridx + 1);
 
         v = v * 0x100 + pngle->scanline_ringbuf[*ridx];
-        *ridx = (*ridx + 1) % pngle->scanline_ringbuf_size;
+        *ridx = ringbuf_wrap(pngle, *ridx + 1);
         return v;
     }
 
@@ -324,6 +360,8 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
 
     int n_pixels = pngle->hdr.depth == 16 ? 1 : (8 / pngle->hdr.depth);
 
+    uint8_t *row_buf = pngle->row_buf;
+
     for(; n_pixels-- > 0 && pngle->drawing_x < pngle->hdr.width;
         pngle->drawing_x = U32_CLAMP_ADD(pngle->drawing_x, interlace_div_x[pngle->interlace_pass], pngle->hdr.width)) {
         for(uint_fast8_t c = 0; c < pngle->channels; c++) {
@@ -363,7 +401,28 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
             v[1] = v[2] = v[0];
         }
 
-        if(pngle->draw_callback) {
+        if(row_buf != NULL) {
+            uint8_t *rgba = row_buf + pngle->drawing_x * 4;
+
+            if(maxval == 255) {
+                rgba[0] = v[0];
+                rgba[1] = v[1];
+                rgba[2] = v[2];
+                rgba[3] = v[3];
+            } else {
+                for(int i = 0; i < 4; i++) {
+                    rgba[i] = (v[i] * 255 + maxval / 2) / maxval;
+                }
+            }
+
+#ifndef PNGLE_NO_GAMMA_CORRECTION
+            if(pngle->gamma_table) {
+                for(int i = 0; i < 3; i++) {
+                    rgba[i] = pngle->gamma_table[v[i]];
+                }
+            }
+#endif
+        } else if(pngle->draw_callback) {
             uint8_t rgba[4] = { (v[0] * 255 + maxval / 2) / maxval, (v[1] * 255 + maxval / 2) / maxval, (v[2] * 255 + maxval / 2) / maxval,
                                 (v[3] * 255 + maxval / 2) / maxval };
 
@@ -382,6 +441,10 @@ static int pngle_draw_pixels(pngle_t *pngle, size_t scanline_ringbuf_xidx)
         }
     }
 
+    if(row_buf != NULL && pngle->drawing_x >= pngle->hdr.width) {
+        pngle->row_callback(pngle, pngle->drawing_y, pngle->hdr.width, row_buf);
+    }
+
     return 0;
 }
 
@@ -419,6 +482,22 @@ static int set_interlace_pass(pngle_t *pngle, uint_fast8_t pass)
     pngle->drawing_y = interlace_off_y[pngle->interlace_pass];
     pngle->filter_type = -1;
 
+    // whole rows are only available when the image isn't interlaced
+    if(pngle->row_callback && pass == 0 && pngle->row_buf == NULL) {
+        if((pngle->row_buf = PNGLE_CALLOC(pngle->hdr.width, 4, "row buf")) == NULL)
+            return PNGLE_ERROR("Insufficient memory");
+
+        // and for 8 bit images, unfilter a whole scanline at a time instead of going through the ring buffer
+        if(pngle->hdr.depth == 8) {
+            pngle->line_stride = scanline_stride;
+            if((pngle->line_buf = PNGLE_CALLOC(2, scanline_stride + bytes_per_pixel, "line buf")) == NULL)
+                return PNGLE_ERROR("Insufficient memory");
+            pngle->line_cur = pngle->line_buf + bytes_per_pixel;
+            pngle->line_prev = pngle->line_cur + scanline_stride + bytes_per_pixel;
+            pngle->line_pos = 0;
+        }
+    }
+
     pngle->scanline_ringbuf_cidx = 0;
     pngle->scanline_remain_bytes_to_render = -1;
 
@@ -455,8 +534,152 @@ static int setup_gamma_table(pngle_t *pngle, uint32_t png_gamma)
 }
 
 
+// convert a reconstructed 8 bit scanline to RGBA8 and hand it to the row callback
+static int pngle_emit_line(pngle_t *pngle)
+{
+    const uint8_t *src = pngle->line_cur;
+    uint8_t *dst = pngle->row_buf;
+    uint32_t width = pngle->hdr.width;
+    int has_trans = pngle->n_trans_palettes == 1;
+
+    switch(pngle->hdr.color_type) {
+    case 0:    // grayscale
+        for(uint32_t x = 0; x < width; x++, dst += 4) {
+            uint8_t g = *src++;
+            dst[0] = dst[1] = dst[2] = g;
+            dst[3] = (has_trans && g == pngle->trans_palette[0] * 0x100 + pngle->trans_palette[1]) ? 0 : 255;
+        }
+        break;
+
+    case 2:    // truecolor
+        for(uint32_t x = 0; x < width; x++, src += 3, dst += 4) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 255;
+            if(has_trans) {
+                uint16_t v[3] = { src[0], src[1], src[2] };
+                if(is_trans_color(pngle, v, 3))
+                    dst[3] = 0;
+            }
+        }
+        break;
+
+    case 3:    // indexed color
+        for(uint32_t x = 0; x < width; x++, dst += 4) {
+            uint8_t pidx = *src++;
+            if(pidx >= pngle->n_palettes)
+                return PNGLE_ERROR("Color index is out of range");
+            dst[0] = pngle->palette[pidx * 3 + 0];
+            dst[1] = pngle->palette[pidx * 3 + 1];
+            dst[2] = pngle->palette[pidx * 3 + 2];
+            dst[3] = pidx < pngle->n_trans_palettes ? pngle->trans_palette[pidx] : 255;
+        }
+        break;
+
+    case 4:    // grayscale + alpha
+        for(uint32_t x = 0; x < width; x++, src += 2, dst += 4) {
+            dst[0] = dst[1] = dst[2] = src[0];
+            dst[3] = src[1];
+        }
+        break;
+
+    case 6:    // truecolor + alpha
+        memcpy(dst, src, width * 4);
+        break;
+    }
+
+#ifndef PNGLE_NO_GAMMA_CORRECTION
+    if(pngle->gamma_table) {
+        dst = pngle->row_buf;
+        for(uint32_t x = 0; x < width; x++, dst += 4) {
+            dst[0] = pngle->gamma_table[dst[0]];
+            dst[1] = pngle->gamma_table[dst[1]];
+            dst[2] = pngle->gamma_table[dst[2]];
+        }
+    }
+#endif
+
+    pngle->row_callback(pngle, pngle->drawing_y, width, pngle->row_buf);
+    return 0;
+}
+
+// reverse the filter on a whole scanline, the padding in front of both lines stands in for the missing left neighbours
+static void pngle_unfilter_line(pngle_t *pngle)
+{
+    uint8_t *cur = pngle->line_cur;
+    const uint8_t *prev = pngle->line_prev;
+    size_t n = pngle->line_stride;
+    int bpp = pngle->channels;
+
+    switch(pngle->filter_type) {
+    case 1:    // Sub
+        for(size_t i = 0; i < n; i++)
+            cur[i] += cur[(int)i - bpp];
+        break;
+    case 2:    // Up
+        for(size_t i = 0; i < n; i++)
+            cur[i] += prev[i];
+        break;
+    case 3:    // Average
+        for(size_t i = 0; i < n; i++)
+            cur[i] += (cur[(int)i - bpp] + prev[i]) / 2;
+        break;
+    case 4:    // Paeth
+        for(size_t i = 0; i < n; i++)
+            cur[i] += paeth(cur[(int)i - bpp], prev[i], prev[(int)i - bpp]);
+        break;
+    default:    // None
+        break;
+    }
+}
+
+static int pngle_on_data_lines(pngle_t *pngle, const uint8_t *p, int len)
+{
+    const uint8_t *ep = p + len;
+
+    while(p < ep) {
+        if(pngle->drawing_y >= pngle->hdr.height)
+            return len;    // Do nothing further
+
+        if(pngle->filter_type < 0) {
+            if(*p > 4) {
+                debug_printf("[pngle] Invalid filter type is found; 0x%02x\n", *p);
+                return PNGLE_ERROR("Invalid filter type is found");
+            }
+            pngle->filter_type = (int_fast8_t)*p++;    // 0 - 4
+            pngle->line_pos = 0;
+            continue;
+        }
+
+        size_t n = MIN((size_t)(ep - p), pngle->line_stride - pngle->line_pos);
+        memcpy(pngle->line_cur + pngle->line_pos, p, n);
+        pngle->line_pos += n;
+        p += n;
+
+        if(pngle->line_pos == pngle->line_stride) {
+            pngle_unfilter_line(pngle);
+
+            if(pngle_emit_line(pngle) < 0)
+                return -1;
+
+            uint8_t *t = pngle->line_prev;
+            pngle->line_prev = pngle->line_cur;
+            pngle->line_cur = t;
+
+            pngle->drawing_y += 1;
+            pngle->filter_type = -1;    // Indicate new line
+        }
+    }
+
+    return len;
+}
+
 static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
 {
+    if(pngle->line_buf)
+        return pngle_on_data_lines(pngle, p, len);
+
     const uint8_t *ep = p + len;
 
     uint_fast8_t bytes_per_pixel = (pngle->channels * pngle->hdr.depth + 7) / 8;    // 1 if depth <= 8
@@ -498,8 +721,8 @@ static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
         }
 
         size_t cidx = pngle->scanline_ringbuf_cidx;
-        size_t bidx = (pngle->scanline_ringbuf_cidx + bytes_per_pixel) % pngle->scanline_ringbuf_size;
-        size_t aidx = (pngle->scanline_ringbuf_cidx + pngle->scanline_ringbuf_size - bytes_per_pixel) % pngle->scanline_ringbuf_size;
+        size_t bidx = ringbuf_wrap(pngle, pngle->scanline_ringbuf_cidx + bytes_per_pixel);
+        size_t aidx = ringbuf_wrap(pngle, pngle->scanline_ringbuf_cidx + pngle->scanline_ringbuf_size - bytes_per_pixel);
         // debug_printf("[pngle] cidx = %zd, bidx = %zd, aidx = %zd\n", cidx, bidx, aidx);
 
         uint8_t c = pngle->scanline_ringbuf[cidx];    // left-up
@@ -531,7 +754,7 @@ static int pngle_on_data(pngle_t *pngle, const uint8_t *p, int len)
         if(pngle->scanline_remain_bytes_to_render < 0)
             pngle->scanline_remain_bytes_to_render = bytes_per_pixel;
         if(--pngle->scanline_remain_bytes_to_render == 0) {
-            size_t xidx = (pngle->scanline_ringbuf_cidx + pngle->scanline_ringbuf_size - bytes_per_pixel) % pngle->scanline_ringbuf_size;
+            size_t xidx = ringbuf_wrap(pngle, pngle->scanline_ringbuf_cidx + pngle->scanline_ringbuf_size - bytes_per_pixel);
 
             if(pngle_draw_pixels(pngle, xidx) < 0)
                 return -1;
@@ -977,6 +1200,13 @@ void pngle_set_draw_callback(pngle_t *pngle, pngle_draw_callback_t callback)
     pngle->draw_callback = callback;
 }
 
+void pngle_set_row_callback(pngle_t *pngle, pngle_row_callback_t callback)
+{
+    if(!pngle)
+        return;
+    pngle->row_callback = callback;
+}
+
 void pngle_set_done_callback(pngle_t *pngle, pngle_done_callback_t callback)
 {
     if(!pngle)
@@ -37,6 +37,7 @@ typedef struct _pngle_t pngle_t;
 // Callback signatures
 typedef void (*pngle_init_callback_t)(pngle_t *pngle, uint32_t w, uint32_t h);
 typedef void (*pngle_draw_callback_t)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4]);
+typedef void (*pngle_row_callback_t)(pngle_t *pngle, uint32_t y, uint32_t w, const uint8_t *rgba);
 typedef void (*pngle_done_callback_t)(pngle_t *pngle);
 
 // ----------------
@@ -53,6 +54,7 @@ uint32_t pngle_get_height(pngle_t *pngle);
 
 void pngle_set_init_callback(pngle_t *png, pngle_init_callback_t callback);
 void pngle_set_draw_callback(pngle_t *png, pngle_draw_callback_t callback);
+void pngle_set_row_callback(pngle_t *png, pngle_row_callback_t callback); // whole RGBA8 scanlines, non-interlaced images only (interlaced images still use the draw callback)
 void pngle_set_done_callback(pngle_t *png, pngle_done_callback_t callback);
 
 void pngle_set_display_gamma(pngle_t *pngle, double display_gamma); // enables gamma correction by specifying display gamma, typically 2.2. No effect when gAMA chunk is missing
@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////
+// Frame capture stream format, shared by lcd_capture.cpp and tools/frame_capture
+// so this must stay plain C with no ESP-IDF headers.
+//
+// The stream is a run of packets, each a header and data_size bytes of data. It shares the port
+// with the console so the decoder looks for the magic and checks the crc to find them.
+//
+// For each frame there's a section packet for every section, in order, then a frame end packet.
+// A section packet's data is the section's pixels exactly as they were sent to the panel,
+// run length encoded (see below). Its data is empty if the section wasn't sent, because the panel
+// already had it, or if the pixels were dropped because the port was behind. Either way the
+// timings are still there.
+//
+// With hardware scrolling, screen line scroll_top + i (for i < scroll_height) shows panel memory
+// line scroll_top + (scroll_offset + i) % scroll_height, every other line shows its own. A skipped
+// section, or the lines of one which weren't sent, are whatever that panel memory held already,
+// which after a scroll is what other screen lines showed last frame.
+//
+// Everything is little endian. Bump LCD_CAPTURE_VERSION when any of it changes.
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+//////////////////////////////////////////////////////////////////////
+
+#define LCD_CAPTURE_MAGIC 0x50414346    // 'FCAP'
+#define LCD_CAPTURE_VERSION 2
+
+//////////////////////////////////////////////////////////////////////
+
+typedef enum lcd_capture_type
+{
+    lcd_capture_type_section = 0,
+    lcd_capture_type_frame_end = 1,
+
+} lcd_capture_type_t;
+
+typedef enum lcd_capture_flags
+{
+    lcd_capture_flag_skipped = 1,    // not sent, the panel still shows what it had
+    lcd_capture_flag_dropped = 2,    // sent but not captured
+
+} lcd_capture_flags_t;
+
+//////////////////////////////////////////////////////////////////////
+// 18 bpp pixels are 3 bytes, R G B with the low 2 bits unused
+// 16 bpp pixels are 2 bytes, big endian RGB565
+
+typedef struct lcd_capture_header
+{
+    uint32_t magic;
+    uint8_t version;
+    uint8_t type;              // lcd_capture_type_t
+    uint8_t flags;             // lcd_capture_flags_t
+    uint8_t section;
+    uint8_t section_height;    // lines
+    uint8_t num_sections;
+    uint8_t bits_per_pixel;    // 16 or 18
+    uint8_t scroll_top;        // lines
+    uint16_t width;
+    uint16_t height;
+    uint8_t scroll_height;    // lines, 0 = not scrolling
+    uint8_t scroll_offset;    // 0..scroll_height - 1
+    uint16_t reserved;
+    uint32_t frame;      // counts up from 0 when the capture starts
+    uint32_t time_us;    // esp_timer time (low 32 bits) the section's fill started, or the frame was done
+    uint32_t wait_us;    // waiting for a section buffer before the fill, or in total for the frame
+    uint32_t fill_us;    // in the filler, or in total for the frame
+    uint32_t data_size;
+    uint32_t crc;    // CRC-32 (as zlib's crc32) of the header with crc 0, then the data
+
+} lcd_capture_header_t;
+
+//////////////////////////////////////////////////////////////////////
+// run length encoding of whole pixels. Each run starts with a count byte n,
+// n < 128: n + 1 different pixels follow
+// n >= 128: one pixel follows, repeated n - 126 times (2..129)
+
+#define LCD_CAPTURE_MAX_LITERAL 128
+#define LCD_CAPTURE_MAX_REPEAT 129
+
+// worst case for num_pixels pixels of pixel_size bytes
+#define LCD_CAPTURE_RLE_BOUND(num_pixels, pixel_size) \
+    ((num_pixels) * (pixel_size) + ((num_pixels) + LCD_CAPTURE_MAX_LITERAL - 1) / LCD_CAPTURE_MAX_LITERAL)
+
+//////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+}
+#endif
@@ -2,7 +2,10 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
 #include <esp_err.h>
+#include "sdkconfig.h"
 
 //////////////////////////////////////////////////////////////////////
 
@@ -20,8 +23,32 @@
 
 #define LCD_BYTES_PER_LINE (LCD_WIDTH * LCD_BYTES_PER_PIXEL)
 
-#define LCD_SECTION_HEIGHT 16    // largest power of 2 which is divisible into 240
-#define LCD_NUM_SECTIONS (LCD_HEIGHT / LCD_SECTION_HEIGHT)
+// the screen is sent in sections, the section height can be any divisor of LCD_HEIGHT from
+// LCD_MIN_SECTION_HEIGHT to LCD_MAX_SECTION_HEIGHT. The DMA buffers are sized for the max
+
+#if defined(CONFIG_LCD_MAX_SECTION_HEIGHT)
+#define LCD_MAX_SECTION_HEIGHT CONFIG_LCD_MAX_SECTION_HEIGHT
+#else
+#define LCD_MAX_SECTION_HEIGHT 16
+#endif
+
+#if defined(CONFIG_LCD_SECTION_HEIGHT)
+#define LCD_DEFAULT_SECTION_HEIGHT CONFIG_LCD_SECTION_HEIGHT
+#else
+#define LCD_DEFAULT_SECTION_HEIGHT 16
+#endif
+
+#if defined(CONFIG_LCD_SECTION_BUFFERS)
+#define LCD_SECTION_BUFFERS CONFIG_LCD_SECTION_BUFFERS
+#else
+#define LCD_SECTION_BUFFERS 3
+#endif
+
+#define LCD_MIN_SECTION_HEIGHT 8
+
+// the SPI master can't do a transaction bigger than this, a whole section goes in one
+#define LCD_MAX_TRANSFER_BYTES 32768
+#define LCD_MAX_SECTIONS (LCD_HEIGHT / LCD_MIN_SECTION_HEIGHT)
 
 //////////////////////////////////////////////////////////////////////
 
@@ -31,12 +58,87 @@ extern "C" {
 
 //////////////////////////////////////////////////////////////////////
 
-typedef void (*lcd_buffer_filler)(int section, uint8_t *buffer);
+// draw a section into buffer and return it, or return other DMA capable memory with the section's
+// pixels in it (which must stay put until the frame is done) to skip drawing, or nullptr if the
+// panel already has it
+typedef uint8_t const *(*lcd_buffer_filler)(int section, uint8_t *buffer);
 
 esp_err_t lcd_init();
+
+// frames are filled and sent by the lcd_update task, one at a time. lcd_update_async waits for the
+// previous frame then returns straight away with a handle for lcd_wait. The filler runs in the
+// lcd_update task so what it reads mustn't change until the frame is done. The callback (optional)
+// runs there too, once the last section has gone out
+typedef uint32_t lcd_update_handle;
+typedef void (*lcd_update_callback)(void *context);
+
+esp_err_t lcd_update_async(lcd_buffer_filler buffer_filler, lcd_update_callback callback, void *context, lcd_update_handle *out_handle);
+esp_err_t lcd_wait(lcd_update_handle handle, TickType_t ticks_to_wait);
+
+// lcd_update_async then lcd_wait
 esp_err_t lcd_update(lcd_buffer_filler buffer_filler);
+
 esp_err_t lcd_set_backlight(uint32_t brightness_0_8191);
 
+// brightness is perceptual (0..255), lcd_backlight_gamma maps it to a duty for lcd_set_backlight
+uint32_t lcd_backlight_gamma(uint8_t brightness);
+
+// fade on the LEDC hardware along the gamma curve, callback runs in the backlight task when it gets there
+// a new fade replaces one in progress (whose callback is then never called), don't mix with lcd_set_backlight
+typedef void (*lcd_fade_callback)(void *context);
+
+esp_err_t lcd_fade_backlight(uint8_t brightness, uint32_t duration_ms, lcd_fade_callback callback, void *context);
+
+// waits for the frame being sent, not from a filler or update callback
+esp_err_t lcd_set_section_height(int height);
+int lcd_get_section_height();
+int lcd_get_num_sections();
+
+// the ring of DMA section buffers at the current section height
+size_t lcd_get_section_buffer_bytes();
+
+//////////////////////////////////////////////////////////////////////
+// hardware vertical scrolling (VSCRDEF/VSCSAD). Lines top..top + height - 1 show the panel memory
+// scrolled so content line offset is at the top. lcd_update still asks for whole sections in screen
+// space but only sends the lines which scrolled into view since the last update (and everything
+// outside the area), sections with nothing to send aren't filled at all
+
+// these wait for the frame being sent and apply from the next one
+// height 0 turns it off, changing the area sends all of it on the next update
+esp_err_t lcd_set_scroll_area(int top, int height);
+
+// any value, the hardware offset is this mod the area height. Scrolling more than the area height
+// in one update sends all of it
+void lcd_set_scroll_offset(int offset);
+
+// something in the area changed other than by scrolling, send all of it on the next update
+void lcd_invalidate_scroll_area();
+
+//////////////////////////////////////////////////////////////////////
+// frame capture (CONFIG_LCD_CAPTURE). Each section is streamed out of the capture port as it's sent,
+// with its timings, for tools/frame_capture to turn into PNGs. When the port can't keep up a frame
+// goes without its pixels but its timings still go, so it can be left running for perf runs
+
+// frames 0 captures until lcd_capture_stop
+esp_err_t lcd_capture_start(uint32_t frames);
+esp_err_t lcd_capture_stop();
+
+//////////////////////////////////////////////////////////////////////
+// accumulated over lcd_update calls since lcd_reset_stats
+
+typedef struct lcd_stats
+{
+    int frames;
+    int64_t update_us;      // filling and sending sections
+    int64_t fill_us;        // in the buffer filler
+    int64_t dma_wait_us;    // waiting for a section buffer to finish sending
+    int64_t dma_idle_us;    // SPI bus idle between sections because the filler was slower
+    int64_t lines_sent;     // fewer than LCD_HEIGHT per frame when the scroll area doesn't need it all
+} lcd_stats_t;
+
+void lcd_get_stats(lcd_stats_t *stats);
+void lcd_reset_stats();
+
 //////////////////////////////////////////////////////////////////////
 
 #define COLOR_BLACK 0xff000000
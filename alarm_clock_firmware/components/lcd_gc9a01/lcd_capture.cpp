@@ -0,0 +1,418 @@
+//////////////////////////////////////////////////////////////////////
+// frame capture. The lcd_update task copies each section it sends into a ring buffer in PSRAM
+// and a low priority task compresses them and writes them to the capture port, so all it costs
+// the frame is a memcpy per section. A frame's pixels are only kept if there's room for all of
+// them when it starts, otherwise just its timings go
+
+#include <memory.h>
+#include <stdint.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/ringbuf.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+#if CONFIG_LCD_CAPTURE_UART
+#include "driver/uart.h"
+#else
+#include "driver/usb_serial_jtag.h"
+#endif
+
+#include "lcd_gc9a01.h"
+#include "lcd_capture_format.h"
+#include "lcd_capture.h"
+#include "util.h"
+
+LOG_CONTEXT("lcd_capture");
+
+#if CONFIG_LCD_CAPTURE
+
+#define LCD_CAPTURE_TASK_STACK_SIZE 3072
+#define LCD_CAPTURE_TASK_PRIORITY 2
+#define LCD_CAPTURE_TASK_CORE 0
+
+// USB Serial/JTAG writes have to fit in its buffer
+#define LCD_CAPTURE_TX_BUFFER_SIZE 4096
+#define LCD_CAPTURE_WRITE_CHUNK 1024
+
+// a no-split ring buffer item has an 8 byte header and is padded to 4 bytes
+#define LCD_CAPTURE_ITEM_OVERHEAD 12
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    RingbufHandle_t ring = nullptr;
+
+    // the compressed section, for the capture task
+    uint8_t *rle_buffer = nullptr;
+
+    volatile bool capturing = false;
+    volatile bool restart = false;
+    volatile uint32_t frames_left = 0;    // 0 = until stopped
+
+    // the frame the lcd_update task is sending
+    uint32_t frame = 0;
+    bool frame_active = false;
+    bool keep_pixels = false;
+    bool pixels_dropped = false;
+    int frame_sections = 0;
+    int frame_section_height = 0;
+    int frame_scroll_top = 0;
+    int frame_scroll_height = 0;
+    int frame_scroll_offset = 0;
+
+    uint32_t frames_dropped = 0;
+    uint32_t packets_lost = 0;
+
+    //////////////////////////////////////////////////////////////////////
+
+    lcd_capture_header_t make_header(lcd_capture_type_t type)
+    {
+        lcd_capture_header_t header = {};
+        header.magic = LCD_CAPTURE_MAGIC;
+        header.version = LCD_CAPTURE_VERSION;
+        header.type = type;
+        header.section_height = frame_section_height;
+        header.num_sections = frame_sections;
+        header.bits_per_pixel = LCD_BITS_PER_PIXEL;
+        header.scroll_top = frame_scroll_top;
+        header.width = LCD_WIDTH;
+        header.height = LCD_HEIGHT;
+        header.scroll_height = frame_scroll_height;
+        header.scroll_offset = frame_scroll_offset;
+        header.frame = frame;
+        return header;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the header's data_size is the raw size of the pixels in the ring, never blocks
+
+    bool send_item(lcd_capture_header_t const &header, uint8_t const *pixels)
+    {
+        void *item;
+
+        if(xRingbufferSendAcquire(ring, &item, sizeof(header) + header.data_size, 0) != pdTRUE) {
+            return false;
+        }
+
+        memcpy(item, &header, sizeof(header));
+
+        if(header.data_size != 0) {
+            memcpy((uint8_t *)item + sizeof(header), pixels, header.data_size);
+        }
+
+        xRingbufferSendComplete(ring, item);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool same_pixel(uint8_t const *a, uint8_t const *b)
+    {
+        for(int i = 0; i < LCD_BYTES_PER_PIXEL; ++i) {
+            if(a[i] != b[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // see lcd_capture_format.h, returns the compressed size
+
+    size_t rle_encode(uint8_t const *src, int num_pixels, uint8_t *dst)
+    {
+        int constexpr size = LCD_BYTES_PER_PIXEL;
+
+        uint8_t *out = dst;
+        int i = 0;
+
+        while(i < num_pixels) {
+
+            uint8_t const *pixel = src + i * size;
+
+            int run = 1;
+            while(i + run < num_pixels && run < LCD_CAPTURE_MAX_REPEAT && same_pixel(pixel, pixel + run * size)) {
+                run += 1;
+            }
+
+            if(run >= 2) {
+                *out++ = (uint8_t)(run + 126);
+                memcpy(out, pixel, size);
+                out += size;
+                i += run;
+                continue;
+            }
+
+            // different pixels up to the next repeat
+            int count = 0;
+            while(i + count < num_pixels && count < LCD_CAPTURE_MAX_LITERAL) {
+                if(i + count + 1 < num_pixels && same_pixel(src + (i + count) * size, src + (i + count + 1) * size)) {
+                    break;
+                }
+                count += 1;
+            }
+
+            *out++ = (uint8_t)(count - 1);
+            memcpy(out, pixel, count * size);
+            out += count * size;
+            i += count;
+        }
+        return out - dst;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void write_port(void const *data, size_t size)
+    {
+        uint8_t const *p = (uint8_t const *)data;
+
+        while(size != 0) {
+
+            size_t chunk = min(size, (size_t)LCD_CAPTURE_WRITE_CHUNK);
+
+#if CONFIG_LCD_CAPTURE_UART
+            int written = uart_write_bytes(CONFIG_LCD_CAPTURE_UART_NUM, p, chunk);
+#else
+            int written = usb_serial_jtag_write_bytes(p, chunk, portMAX_DELAY);
+#endif
+            if(written <= 0) {
+                return;
+            }
+            p += written;
+            size -= written;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // if the host isn't reading this blocks and the ring fills up, which just drops frames
+
+    void capture_task(void *)
+    {
+        while(true) {
+
+            size_t size;
+            uint8_t *item = (uint8_t *)xRingbufferReceive(ring, &size, portMAX_DELAY);
+
+            if(item == nullptr) {
+                continue;
+            }
+
+            lcd_capture_header_t header;
+            memcpy(&header, item, sizeof(header));
+
+            if(header.data_size != 0) {
+                header.data_size = rle_encode(item + sizeof(header), header.data_size / LCD_BYTES_PER_PIXEL, rle_buffer);
+            }
+
+            vRingbufferReturnItem(ring, item);
+
+            header.crc = 0;
+            uint32_t crc = esp_rom_crc32_le(0, (uint8_t const *)&header, sizeof(header));
+            header.crc = esp_rom_crc32_le(crc, rle_buffer, header.data_size);
+
+            write_port(&header, sizeof(header));
+            write_port(rle_buffer, header.data_size);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t init_port()
+    {
+#if CONFIG_LCD_CAPTURE_UART
+        uart_config_t config = {};
+        config.baud_rate = CONFIG_LCD_CAPTURE_UART_BAUD_RATE;
+        config.data_bits = UART_DATA_8_BITS;
+        config.parity = UART_PARITY_DISABLE;
+        config.stop_bits = UART_STOP_BITS_1;
+        config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+        config.source_clk = UART_SCLK_DEFAULT;
+
+        ESP_RETURN_IF_FAILED(uart_driver_install(CONFIG_LCD_CAPTURE_UART_NUM, 256, LCD_CAPTURE_TX_BUFFER_SIZE, 0, nullptr, 0));
+        ESP_RETURN_IF_FAILED(uart_param_config(CONFIG_LCD_CAPTURE_UART_NUM, &config));
+        ESP_RETURN_IF_FAILED(
+            uart_set_pin(CONFIG_LCD_CAPTURE_UART_NUM, CONFIG_LCD_CAPTURE_UART_TX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+#else
+        usb_serial_jtag_driver_config_t config = {};
+        config.tx_buffer_size = LCD_CAPTURE_TX_BUFFER_SIZE;
+        config.rx_buffer_size = 256;
+
+        ESP_RETURN_IF_FAILED(usb_serial_jtag_driver_install(&config));
+#endif
+        return ESP_OK;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    esp_err_t init_capture()
+    {
+        ESP_RETURN_IF_FAILED(init_port());
+
+        rle_buffer = (uint8_t *)heap_caps_malloc(LCD_CAPTURE_RLE_BOUND(LCD_WIDTH * LCD_MAX_SECTION_HEIGHT, LCD_BYTES_PER_PIXEL), MALLOC_CAP_INTERNAL);
+        ESP_RETURN_IF_NULL(rle_buffer);
+
+        RingbufHandle_t new_ring = xRingbufferCreateWithCaps(CONFIG_LCD_CAPTURE_BUFFER_KB * 1024, RINGBUF_TYPE_NOSPLIT, MALLOC_CAP_SPIRAM);
+        ESP_RETURN_IF_NULL(new_ring);
+
+        ring = new_ring;
+
+        TaskHandle_t task = nullptr;
+        xTaskCreatePinnedToCore(capture_task, "lcd_capture", LCD_CAPTURE_TASK_STACK_SIZE, nullptr, LCD_CAPTURE_TASK_PRIORITY, &task, LCD_CAPTURE_TASK_CORE);
+        ESP_RETURN_IF_NULL(task);
+
+        return ESP_OK;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_capture_begin_frame(int num_sections, int section_height, int scroll_top, int scroll_height, int scroll_offset)
+{
+    frame_active = capturing;
+
+    if(!frame_active) {
+        return;
+    }
+
+    if(restart) {
+        restart = false;
+        frame = 0;
+        frames_dropped = 0;
+        packets_lost = 0;
+    }
+
+    frame_sections = num_sections;
+    frame_section_height = section_height;
+    frame_scroll_top = scroll_top;
+    frame_scroll_height = scroll_height;
+    frame_scroll_offset = scroll_offset;
+
+    size_t section_bytes = sizeof(lcd_capture_header_t) + LCD_BYTES_PER_LINE * section_height + LCD_CAPTURE_ITEM_OVERHEAD;
+    size_t end_bytes = sizeof(lcd_capture_header_t) + LCD_CAPTURE_ITEM_OVERHEAD;
+
+    keep_pixels = xRingbufferGetCurFreeSize(ring) >= num_sections * section_bytes + end_bytes;
+    pixels_dropped = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_capture_section(int section, uint8_t const *pixels, int64_t fill_start_us, int64_t wait_us, int64_t fill_us)
+{
+    if(!frame_active) {
+        return;
+    }
+
+    lcd_capture_header_t header = make_header(lcd_capture_type_section);
+    header.section = section;
+    header.time_us = (uint32_t)fill_start_us;
+    header.wait_us = (uint32_t)wait_us;
+    header.fill_us = (uint32_t)fill_us;
+
+    if(pixels == nullptr) {
+        header.flags = lcd_capture_flag_skipped;
+    } else if(!keep_pixels) {
+        header.flags = lcd_capture_flag_dropped;
+        pixels_dropped = true;
+    } else {
+        header.data_size = LCD_BYTES_PER_LINE * frame_section_height;
+    }
+
+    if(send_item(header, pixels)) {
+        return;
+    }
+
+    // no room after all, keep the timings at least
+    if(header.data_size != 0) {
+        keep_pixels = false;
+        pixels_dropped = true;
+        header.flags = lcd_capture_flag_dropped;
+        header.data_size = 0;
+        if(send_item(header, nullptr)) {
+            return;
+        }
+    }
+    packets_lost += 1;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_capture_end_frame(int64_t wait_us, int64_t fill_us)
+{
+    if(!frame_active) {
+        return;
+    }
+
+    lcd_capture_header_t header = make_header(lcd_capture_type_frame_end);
+    header.time_us = (uint32_t)esp_timer_get_time();
+    header.wait_us = (uint32_t)wait_us;
+    header.fill_us = (uint32_t)fill_us;
+
+    if(!send_item(header, nullptr)) {
+        packets_lost += 1;
+    }
+
+    if(pixels_dropped) {
+        frames_dropped += 1;
+    }
+
+    frame += 1;
+
+    if(frames_left != 0) {
+        frames_left = frames_left - 1;
+        if(frames_left == 0) {
+            capturing = false;
+            LOG_I("Captured %lu frames, %lu without pixels, %lu packets lost", frame, frames_dropped, packets_lost);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_capture_start(uint32_t frames)
+{
+    if(ring == nullptr) {
+        ESP_RETURN_IF_FAILED(init_capture());
+    }
+
+    frames_left = frames;
+    restart = true;
+    capturing = true;
+
+    LOG_I("Capturing %lu frames", frames);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_capture_stop()
+{
+    capturing = false;
+    return ESP_OK;
+}
+
+#else
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_capture_start(uint32_t frames)
+{
+    LOG_E("Frame capture isn't enabled (CONFIG_LCD_CAPTURE)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_capture_stop()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,35 @@
+//////////////////////////////////////////////////////////////////////
+// called from the lcd_update task as it sends each frame, these do nothing unless
+// a capture is running. See lcd_capture_start
+
+#pragma once
+
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////
+
+#if CONFIG_LCD_CAPTURE
+
+// scroll_offset is already wrapped into 0..scroll_height - 1
+void lcd_capture_begin_frame(int num_sections, int section_height, int scroll_top, int scroll_height, int scroll_offset);
+
+// pixels is nullptr if the section wasn't sent
+void lcd_capture_section(int section, uint8_t const *pixels, int64_t fill_start_us, int64_t wait_us, int64_t fill_us);
+
+void lcd_capture_end_frame(int64_t wait_us, int64_t fill_us);
+
+#else
+
+inline void lcd_capture_begin_frame(int, int, int, int, int)
+{
+}
+
+inline void lcd_capture_section(int, uint8_t const *, int64_t, int64_t, int64_t)
+{
+}
+
+inline void lcd_capture_end_frame(int64_t, int64_t)
+{
+}
+
+#endif
@@ -3,28 +3,41 @@
 
 #include <memory.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/semphr.h>
 #include <freertos/event_groups.h>
+#include <freertos/queue.h>
 
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include "esp_system.h"
 
 #include "rom/ets_sys.h"
+#include <esp_rom_sys.h>
+#include <esp_heap_caps.h>
 
 #include <driver/spi_master.h>
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "lcd_gc9a01.h"
+#include "lcd_capture.h"
 #include "util.h"
 
 LOG_CONTEXT("lcd");
 
-#define SPI_BIT_DMA_COMPLETE 1
 #define SPI_BIT_SETUP_COMPLETE 2
+#define SPI_BIT_LCD_READY 4
+#define SPI_BIT_FRAME_IDLE 8
+
+// frames are filled and sent from here
+#define LCD_UPDATE_TASK_STACK_SIZE 4096
+#define LCD_UPDATE_TASK_PRIORITY 16
+#define LCD_UPDATE_TASK_CORE 1
 
 //////////////////////////////////////////////////////////////////////
 // LCD SPI
@@ -53,13 +66,35 @@ LOG_CONTEXT("lcd");
 #define LCD_BL_CHANNEL LEDC_CHANNEL_0
 #define LCD_BL_DUTY_RES LEDC_TIMER_13_BIT    // duty resolution 13 bits
 #define LCD_BL_FREQUENCY 4000                // 4 kHz
+#define LCD_BL_MAX_DUTY 8191
+
+// the hardware only does linear fades, so a gamma curve is this many linear steps
+#define LCD_BL_FADE_SEGMENTS 8
+#define LCD_BL_GAMMA 2.2f
 
 //////////////////////////////////////////////////////////////////////
 
-#define LCD_NUM_SPI_TRANSFERS (LCD_NUM_SECTIONS + 5)
+#define LCD_NUM_SETUP_TRANSFERS 5
+
+// with hardware scrolling a section can go out as a few runs of lines to different places in the
+// panel memory: the top fixed area, the exposed lines of the scroll area either side of where it
+// wraps, and the bottom fixed area. Each run is RASET, its data, RAMWR and the pixels
+
+#define LCD_MAX_SECTION_RUNS 4
+#define LCD_RUN_TRANSFERS (LCD_MAX_SECTION_RUNS * 4)
+
+#define LCD_NUM_SCROLL_TRANSFERS 4
+
+// setup, scrolling and a full ring of sections
+#define LCD_SPI_QUEUE_SIZE (LCD_NUM_SETUP_TRANSFERS + LCD_NUM_SCROLL_TRANSFERS + LCD_SECTION_BUFFERS * LCD_RUN_TRANSFERS)
 
-static_assert(LCD_HEIGHT % LCD_SECTION_HEIGHT == 0);
+static_assert(LCD_HEIGHT % LCD_MIN_SECTION_HEIGHT == 0);
+static_assert(LCD_HEIGHT % LCD_MAX_SECTION_HEIGHT == 0 && LCD_MAX_SECTION_HEIGHT >= LCD_MIN_SECTION_HEIGHT);
+static_assert(LCD_HEIGHT % LCD_DEFAULT_SECTION_HEIGHT == 0 && LCD_DEFAULT_SECTION_HEIGHT >= LCD_MIN_SECTION_HEIGHT &&
+              LCD_DEFAULT_SECTION_HEIGHT <= LCD_MAX_SECTION_HEIGHT);
+static_assert(LCD_BYTES_PER_LINE * LCD_MAX_SECTION_HEIGHT <= LCD_MAX_TRANSFER_BYTES);
 static_assert(LCD_BITS_PER_PIXEL == 16 || LCD_BITS_PER_PIXEL == 18);
+static_assert(LCD_SECTION_BUFFERS >= 2);
 
 //////////////////////////////////////////////////////////////////////
 
@@ -77,14 +112,67 @@ namespace
 
     spi_device_handle_t spi;
 
-    DMA_ATTR spi_transaction_t spi_transactions[LCD_NUM_SPI_TRANSFERS];
+    DMA_ATTR spi_transaction_t spi_transactions[LCD_NUM_SETUP_TRANSFERS];
+
+    // one set for each section buffer
+    DMA_ATTR spi_transaction_t run_transactions[LCD_SECTION_BUFFERS][LCD_RUN_TRANSFERS];
+
+    DMA_ATTR spi_transaction_t scroll_transactions[LCD_NUM_SCROLL_TRANSFERS];
+    DMA_ATTR uint8_t scroll_definition[6];
 
     IRAM_ATTR void spi_callback_set_data();
     IRAM_ATTR void spi_callback_clear_data();
     IRAM_ATTR void spi_callback_setup_complete();
     IRAM_ATTR void spi_callback_dma_complete();
 
-    DMA_ATTR uint8_t lcd_buffer[2][LCD_BYTES_PER_LINE * LCD_SECTION_HEIGHT];
+    // a ring, filled in order and sent in order. free_buffers counts the ones which aren't waiting
+    // to go out, the DMA complete callback gives it back
+
+    DMA_ATTR uint8_t lcd_buffer[LCD_SECTION_BUFFERS][LCD_BYTES_PER_LINE * LCD_MAX_SECTION_HEIGHT];
+
+    SemaphoreHandle_t free_buffers;
+
+    int sections_queued = 0;
+    volatile int sections_sent = 0;
+
+    int section_height = LCD_DEFAULT_SECTION_HEIGHT;
+    int num_sections = LCD_HEIGHT / LCD_DEFAULT_SECTION_HEIGHT;
+
+    struct update_request
+    {
+        lcd_buffer_filler filler;
+        lcd_update_callback callback;
+        void *context;
+        lcd_update_handle handle;
+    };
+
+    QueueHandle_t update_queue;
+
+    lcd_update_handle last_handle = 0;                 // from the latest lcd_update_async
+    volatile lcd_update_handle completed_handle = 0;    // last one whose final section has gone out
+
+    // hardware scrolling, lines scroll_top..scroll_top + scroll_height - 1 show panel memory
+    // rotated by scroll_offset. The panel memory for content line n is scroll_top + (n mod scroll_height)
+
+    int scroll_top = 0;
+    int scroll_height = 0;              // 0 = off
+    int scroll_offset = 0;              // content line at the top of the scroll area
+    int sent_scroll_offset = 0;         // what the panel memory in the scroll area holds
+    bool scroll_area_valid = false;     // false = send all of the scroll area next frame
+    bool scroll_area_changed = false;   // VSCRDEF needs sending
+
+    // a run of lines from a section buffer and where they go in the panel memory
+    struct section_run
+    {
+        int line;
+        int gram_line;
+        int count;
+    };
+
+    lcd_stats_t stats;
+
+    // set by the DMA complete callback, for measuring how long the bus sits idle
+    volatile int64_t dma_complete_time;
 
     spi_callback_user_data_t spi_callback_cmd = { .pre_callback = spi_callback_clear_data, .post_callback = nullptr };
 
@@ -94,10 +182,21 @@ namespace
 
     spi_callback_user_data_t spi_callback_dma_data = { .pre_callback = spi_callback_set_data, .post_callback = spi_callback_dma_complete };
 
+    // pixels straight after pixels, D/C is already set
+    spi_callback_user_data_t spi_callback_dma_data_continue = { .pre_callback = nullptr, .post_callback = spi_callback_dma_complete };
+
+    spi_callback_user_data_t spi_callback_data_last = { .pre_callback = spi_callback_set_data, .post_callback = spi_callback_setup_complete };
+
     //////////////////////////////////////////////////////////////////////
+    // len, cmd, data[len & 0x1f], and if (len & 0x80) a delay in ms before the next command
+    // if (len & 0x40) the command can't go until LCD_RESET_TO_SLEEP_OUT_MS after reset
+    // delays are the datasheet minimums, the data is sent straight from here so it's in DRAM
+
+    // the datasheet forbids Sleep Out for this long after a hardware reset
+    int constexpr LCD_RESET_TO_SLEEP_OUT_MS = 120;
 
     // clang-format off
-    uint8_t const GC9A01A_initcmds[] = {
+    DRAM_ATTR uint8_t const GC9A01A_initcmds[] = {
 
         0, 0xEF,
         1, 0xEB, 0x14,
@@ -150,8 +249,8 @@ namespace
         2, 0x98, 0x3e, 0x07,
         0, 0x35,
         0, 0x21,
-        0x80, 0x11,
-        0x80, 0x29,
+        0xC0, 0x11, 5,      // sleep out, 120ms after reset and 5ms before the next command
+        0, 0x29,
         0xff
     };
     // clang-format on
@@ -163,6 +262,9 @@ namespace
     void init_dma_flag()
     {
         spi_bits = xEventGroupCreate();
+        xEventGroupSetBits(spi_bits, SPI_BIT_FRAME_IDLE);
+
+        free_buffers = xSemaphoreCreateCounting(LCD_SECTION_BUFFERS, LCD_SECTION_BUFFERS);
     }
 
     void spi_callback_setup_complete()
@@ -174,9 +276,10 @@ namespace
 
     void spi_callback_dma_complete()
     {
-        gpio_set_level(LCD_PIN_NUM_DC, 0);
+        dma_complete_time = esp_timer_get_time();
+        sections_sent = sections_sent + 1;
         BaseType_t woken = pdFALSE;
-        xEventGroupSetBitsFromISR(spi_bits, SPI_BIT_DMA_COMPLETE, &woken);
+        xSemaphoreGiveFromISR(free_buffers, &woken);
         portYIELD_FROM_ISR(woken);
     }
 
@@ -195,58 +298,550 @@ namespace
     }
 
     //////////////////////////////////////////////////////////////////////
+    // This function is called (in irq context!) just before a transmission starts. It will
+    // set the D/C line to the value indicated in the user field.
 
-    esp_err_t lcd_cmd(const uint8_t cmd, bool keep_cs_active)
+    void lcd_spi_pre_transfer_callback(spi_transaction_t *t)
     {
-        spi_transaction_t t;
-        memset(&t, 0, sizeof(t));
-        t.length = 8;
-        t.tx_data[0] = cmd;
-        t.user = &spi_callback_cmd;
-        t.flags = SPI_TRANS_USE_TXDATA;
-        if(keep_cs_active) {
-            t.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+        spi_callback_user_data_t *p = (spi_callback_user_data_t *)t->user;
+        if(p != nullptr && p->pre_callback != nullptr) {
+            p->pre_callback();
         }
-        ESP_ERROR_CHECK(spi_device_polling_transmit(spi, &t));
-        return ESP_OK;
     }
 
     //////////////////////////////////////////////////////////////////////
 
-    esp_err_t lcd_data(const uint8_t *data, int len)
+    void lcd_spi_post_transfer_complete(spi_transaction_t *t)
     {
-        if(len == 0) {
-            return ESP_OK;
+        spi_callback_user_data_t *p = (spi_callback_user_data_t *)t->user;
+        if(p != nullptr && p->post_callback != nullptr) {
+            p->post_callback();
         }
+    }
 
-        spi_transaction_t t;
-        memset(&t, 0, sizeof(t));
-        t.length = len * 8;
-        t.tx_buffer = data;
-        t.user = &spi_callback_data;
-        ESP_ERROR_CHECK(spi_device_polling_transmit(spi, &t));
-        return ESP_OK;
+    //////////////////////////////////////////////////////////////////////
+
+    void set_cmd(spi_transaction_t *t, uint8_t cmd, spi_callback_user_data_t *callback)
+    {
+        memset(t, 0, sizeof(spi_transaction_t));
+        t->tx_data[0] = cmd;
+        t->length = 8;
+        t->user = callback;
+        t->flags = SPI_TRANS_USE_TXDATA;
     }
 
     //////////////////////////////////////////////////////////////////////
-    // This function is called (in irq context!) just before a transmission starts. It will
-    // set the D/C line to the value indicated in the user field.
 
-    void lcd_spi_pre_transfer_callback(spi_transaction_t *t)
+    void set_data16(spi_transaction_t *t, int a, int b)
     {
-        spi_callback_user_data_t *p = (spi_callback_user_data_t *)t->user;
-        if(p != nullptr && p->pre_callback != nullptr) {
-            p->pre_callback();
+        memset(t, 0, sizeof(spi_transaction_t));
+        t->tx_data[0] = a >> 8;
+        t->tx_data[1] = a & 0xff;
+        t->tx_data[2] = b >> 8;
+        t->tx_data[3] = b & 0xff;
+        t->length = 8 * 4;
+        t->user = &spi_callback_data;
+        t->flags = SPI_TRANS_USE_TXDATA;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // VSCRDEF if the area changed and VSCSAD, ahead of the setup transfers
+
+    void queue_scroll_transfers()
+    {
+        spi_transaction_t *t = scroll_transactions;
+        int n = 0;
+
+        // off is the whole screen scrolling by 0, which is the same as not scrolling
+
+        int top = scroll_height == 0 ? 0 : scroll_top;
+        int height = scroll_height == 0 ? LCD_HEIGHT : scroll_height;
+        int bottom = LCD_HEIGHT - top - height;
+        int start = scroll_height == 0 ? 0 : scroll_top + scroll_offset % scroll_height;
+
+        if(start < scroll_top) {
+            start += scroll_height;
+        }
+
+        if(scroll_area_changed) {
+
+            scroll_definition[0] = top >> 8;
+            scroll_definition[1] = top & 0xff;
+            scroll_definition[2] = height >> 8;
+            scroll_definition[3] = height & 0xff;
+            scroll_definition[4] = bottom >> 8;
+            scroll_definition[5] = bottom & 0xff;
+
+            set_cmd(t + n++, 0x33, &spi_callback_cmd);    // Vertical Scrolling Definition
+
+            memset(t + n, 0, sizeof(spi_transaction_t));
+            t[n].tx_buffer = scroll_definition;
+            t[n].length = 8 * sizeof(scroll_definition);
+            t[n].user = &spi_callback_data;
+            n += 1;
+
+            scroll_area_changed = false;
+
+        } else if(scroll_height == 0) {
+            return;
+        }
+
+        set_cmd(t + n++, 0x37, &spi_callback_cmd);    // Vertical Scrolling Start Address
+
+        // VSCSAD only has 2 bytes of data
+        set_data16(t + n, start, 0);
+        t[n].length = 8 * 2;
+        n += 1;
+
+        for(int i = 0; i < n; ++i) {
+            ESP_ERROR_CHECK(spi_device_queue_trans(spi, t + i, portMAX_DELAY));
         }
     }
 
     //////////////////////////////////////////////////////////////////////
+    // which lines of the scroll area (relative to scroll_top) need sending this frame
 
-    void lcd_spi_post_transfer_complete(spi_transaction_t *t)
+    void get_exposed_lines(int *begin, int *end)
     {
-        spi_callback_user_data_t *p = (spi_callback_user_data_t *)t->user;
-        if(p != nullptr && p->post_callback != nullptr) {
-            p->post_callback();
+        int delta = scroll_offset - sent_scroll_offset;
+
+        *begin = 0;
+        *end = scroll_height;
+
+        if(scroll_area_valid && abs(delta) < scroll_height) {
+            if(delta >= 0) {
+                *begin = scroll_height - delta;
+            } else {
+                *end = -delta;
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // split a section into runs of lines which are contiguous in the panel memory, skipping
+    // lines of the scroll area which are already there. Returns the number of runs
+
+    int get_section_runs(int section, int exposed_begin, int exposed_end, section_run *runs)
+    {
+        int n = 0;
+        int y = section * section_height;
+
+        for(int line = 0; line < section_height; ++line, ++y) {
+
+            int gram_line = y;
+            int i = y - scroll_top;
+
+            if(scroll_height != 0 && i >= 0 && i < scroll_height) {
+
+                if(i < exposed_begin || i >= exposed_end) {
+                    continue;
+                }
+                gram_line = (scroll_offset + i) % scroll_height;
+                if(gram_line < 0) {
+                    gram_line += scroll_height;
+                }
+                gram_line += scroll_top;
+            }
+
+            section_run *r = runs + n - 1;
+
+            if(n != 0 && r->line + r->count == line && r->gram_line + r->count == gram_line) {
+                r->count += 1;
+            } else {
+                assert(n < LCD_MAX_SECTION_RUNS);
+                runs[n++] = { line, gram_line, 1 };
+            }
+        }
+        return n;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // queue the runs of a filled section buffer, a run which carries on from where the panel
+    // is writing just sends pixels, otherwise it moves the row window first. D/C only changes
+    // around commands so pixels following pixels don't need the pre transfer callback
+
+    void queue_section_runs(uint8_t const *buffer, spi_transaction_t *t, section_run const *runs, int num_runs, int &gram_next, bool &sending_data)
+    {
+        int n = 0;
+
+        for(int r = 0; r < num_runs; ++r) {
+
+            section_run const &run = runs[r];
+
+            if(run.gram_line != gram_next) {
+                set_cmd(t + n++, 0x2B, &spi_callback_cmd);    // Row address set
+                set_data16(t + n++, run.gram_line, LCD_HEIGHT - 1);
+                set_cmd(t + n++, 0x2C, &spi_callback_cmd);    // Memory write
+                sending_data = false;
+            }
+
+            bool last = r == num_runs - 1;
+
+            memset(t + n, 0, sizeof(spi_transaction_t));
+            t[n].tx_buffer = buffer + run.line * LCD_BYTES_PER_LINE;
+            t[n].length = LCD_BYTES_PER_LINE * 8 * run.count;
+
+            if(sending_data) {
+                t[n].user = last ? &spi_callback_dma_data_continue : nullptr;
+            } else {
+                t[n].user = last ? &spi_callback_dma_data : &spi_callback_data;
+            }
+            n += 1;
+
+            sending_data = true;
+            gram_next = run.gram_line + run.count;
+            stats.lines_sent += run.count;
+        }
+
+        for(int i = 0; i < n; ++i) {
+            ESP_ERROR_CHECK(spi_device_queue_trans(spi, t + i, portMAX_DELAY));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // FreeRTOS ticks are 10ms, round up and add one because the first tick can be partial
+
+    void sleep_at_least_ms(int ms)
+    {
+        vTaskDelay((ms * configTICK_RATE_HZ + 999) / 1000 + 1);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // turn init commands into transactions up to the next delay (or the end), a command which has
+    // to wait after reset starts a new batch. The pre callbacks set D/C for each one
+
+    int build_init_transactions(uint8_t const *&cmds, spi_transaction_t *t, int *delay_ms, bool *after_reset)
+    {
+        int n = 0;
+        *delay_ms = 0;
+        *after_reset = false;
+
+        while(*cmds != 0xff) {
+
+            if((*cmds & 0x40) != 0) {
+                if(n != 0) {
+                    break;
+                }
+                *after_reset = true;
+            }
+
+            uint8_t len = *cmds++;
+            uint8_t cmd = *cmds++;
+            uint8_t data_len = len & 0x1f;
+
+            memset(t + n, 0, sizeof(spi_transaction_t));
+            t[n].length = 8;
+            t[n].tx_data[0] = cmd;
+            t[n].flags = SPI_TRANS_USE_TXDATA;
+            t[n].user = &spi_callback_cmd;
+            n += 1;
+
+            if(data_len != 0) {
+                memset(t + n, 0, sizeof(spi_transaction_t));
+                t[n].length = data_len * 8;
+                t[n].user = &spi_callback_data;
+                if(data_len <= 4) {
+                    t[n].flags = SPI_TRANS_USE_TXDATA;
+                    memcpy(t[n].tx_data, cmds, data_len);
+                } else {
+                    t[n].tx_buffer = cmds;
+                }
+                n += 1;
+            }
+            cmds += data_len;
+
+            if((len & 0x80) != 0) {
+                *delay_ms = *cmds++;
+                break;
+            }
+        }
+
+        // the last one signals when the batch has gone out
+
+        if(n != 0) {
+            bool is_cmd = t[n - 1].user == &spi_callback_cmd;
+            t[n - 1].user = is_cmd ? &spi_callback_cmd_last : &spi_callback_data_last;
+        }
+        return n;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // reset and init the panel in the background so the rest of boot carries on
+
+    void lcd_init_task(void *)
+    {
+        int64_t start = esp_timer_get_time();
+
+        // a transaction for each command and one for its data
+        size_t max_transactions = sizeof(GC9A01A_initcmds);
+
+        spi_transaction_t *transactions = (spi_transaction_t *)heap_caps_malloc(max_transactions * sizeof(spi_transaction_t), MALLOC_CAP_DMA);
+
+        if(transactions == nullptr) {
+            LOG_E("Can't allocate init transactions");
+            vTaskDelete(nullptr);
+            return;
+        }
+
+        // reset pulse is 10uS minimum, then 5ms before the first command (it comes out of reset in sleep mode)
+
+        gpio_set_level(LCD_PIN_NUM_RST, 0);
+        esp_rom_delay_us(10);
+        gpio_set_level(LCD_PIN_NUM_RST, 1);
+        int64_t reset_time = esp_timer_get_time();
+        sleep_at_least_ms(5);
+
+        uint8_t const *cmds = GC9A01A_initcmds;
+
+        while(*cmds != 0xff) {
+
+            int delay_ms;
+            bool after_reset;
+            int n = build_init_transactions(cmds, transactions, &delay_ms, &after_reset);
+
+            // everything before it has gone out meanwhile
+            if(after_reset) {
+                int64_t wait_us = reset_time + LCD_RESET_TO_SLEEP_OUT_MS * 1000 - esp_timer_get_time();
+                if(wait_us > 0) {
+                    sleep_at_least_ms((int)((wait_us + 999) / 1000));
+                }
+            }
+
+            xEventGroupClearBits(spi_bits, SPI_BIT_SETUP_COMPLETE);
+
+            for(int i = 0; i < n; ++i) {
+                ESP_ERROR_CHECK(spi_device_queue_trans(spi, transactions + i, portMAX_DELAY));
+            }
+
+            xEventGroupWaitBits(spi_bits, SPI_BIT_SETUP_COMPLETE, pdTRUE, pdTRUE, portMAX_DELAY);
+
+            if(delay_ms != 0) {
+                sleep_at_least_ms(delay_ms);
+            }
+        }
+
+        heap_caps_free(transactions);
+
+        LOG_I("LCD ready after %lld ms", (esp_timer_get_time() - start) / 1000);
+
+        xEventGroupSetBits(spi_bits, SPI_BIT_LCD_READY);
+
+        vTaskDelete(nullptr);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // fill the ring of section buffers as fast as they come free. The bus is held for the whole
+    // frame and everything is queued in order, so the DMA runs from one section to the next
+    // without waiting for this task
+
+    void send_frame(lcd_buffer_filler filler_callback)
+    {
+        spi_device_acquire_bus(spi, portMAX_DELAY);
+
+        xEventGroupClearBits(spi_bits, SPI_BIT_SETUP_COMPLETE);
+
+        queue_scroll_transfers();
+
+        for(int i = 0; i < LCD_NUM_SETUP_TRANSFERS; ++i) {
+            spi_device_queue_trans(spi, spi_transactions + i, portMAX_DELAY);
+        }
+
+        int exposed_begin;
+        int exposed_end;
+        get_exposed_lines(&exposed_begin, &exposed_end);
+
+        int64_t start_time = esp_timer_get_time();
+
+        // the setup transfers leave the panel writing from the top line, expecting a command
+        int gram_next = 0;
+        bool sending_data = false;
+
+        int buffer = 0;
+        bool sent_any = false;
+
+        int64_t frame_wait_us = 0;
+        int64_t frame_fill_us = 0;
+
+        // so the capture can tell which panel memory the lines it didn't get pixels for show
+        int wrapped_offset = scroll_height == 0 ? 0 : (scroll_offset % scroll_height + scroll_height) % scroll_height;
+        lcd_capture_begin_frame(num_sections, section_height, scroll_top, scroll_height, wrapped_offset);
+
+        for(int i = 0; i < num_sections; ++i) {
+
+            section_run runs[LCD_MAX_SECTION_RUNS];
+            int num_runs = get_section_runs(i, exposed_begin, exposed_end, runs);
+
+            // all of it is in the scroll area and already on the panel
+            if(num_runs == 0) {
+                lcd_capture_section(i, nullptr, esp_timer_get_time(), 0, 0);
+                continue;
+            }
+
+            // wait for the oldest buffer to finish sending
+            int64_t wait_start = esp_timer_get_time();
+            xSemaphoreTake(free_buffers, portMAX_DELAY);
+            int64_t now = esp_timer_get_time();
+
+            int64_t wait_us = now - wait_start;
+            stats.dma_wait_us += wait_us;
+
+            if(sent_any && sections_sent == sections_queued) {
+                stats.dma_idle_us += max((int64_t)0, now - dma_complete_time);
+            }
+
+            // draw the pixels into the buffer (or the filler has them somewhere already)
+            uint8_t const *pixels = filler_callback(i, lcd_buffer[buffer]);
+
+            int64_t fill_us = esp_timer_get_time() - now;
+            stats.fill_us += fill_us;
+
+            frame_wait_us += wait_us;
+            frame_fill_us += fill_us;
+
+            lcd_capture_section(i, pixels, now, wait_us, fill_us);
+
+            if(pixels == nullptr) {
+                xSemaphoreGive(free_buffers);
+                continue;
+            }
+
+            // and queue it behind the others
+            queue_section_runs(pixels, run_transactions[buffer], runs, num_runs, gram_next, sending_data);
+
+            sections_queued += 1;
+            buffer = (buffer + 1) % LCD_SECTION_BUFFERS;
+            sent_any = true;
+        }
+
+        sent_scroll_offset = scroll_offset;
+        scroll_area_valid = true;
+
+        stats.update_us += esp_timer_get_time() - start_time;
+        stats.frames += 1;
+
+        lcd_capture_end_frame(frame_wait_us, frame_fill_us);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // wait for the ring to empty, then all the buffers and transactions are free. The setup
+    // has its own signal for when every section was already on the panel
+
+    void finish_frame()
+    {
+        xEventGroupWaitBits(spi_bits, SPI_BIT_SETUP_COMPLETE, pdTRUE, pdTRUE, portMAX_DELAY);
+
+        for(int i = 0; i < LCD_SECTION_BUFFERS; ++i) {
+            xSemaphoreTake(free_buffers, portMAX_DELAY);
+        }
+        for(int i = 0; i < LCD_SECTION_BUFFERS; ++i) {
+            xSemaphoreGive(free_buffers);
+        }
+
+        spi_device_release_bus(spi);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // frames come from lcd_update_async one at a time, the UI task gets on with the next frame's
+    // logic while this fills and waits for the DMA
+
+    void lcd_update_task(void *)
+    {
+        update_request request;
+
+        while(xQueueReceive(update_queue, &request, portMAX_DELAY) == pdTRUE) {
+
+            xEventGroupWaitBits(spi_bits, SPI_BIT_LCD_READY, pdFALSE, pdTRUE, portMAX_DELAY);
+
+            send_frame(request.filler);
+            finish_frame();
+
+            if(request.callback != nullptr) {
+                request.callback(request.context);
+            }
+
+            completed_handle = request.handle;
+            xEventGroupSetBits(spi_bits, SPI_BIT_FRAME_IDLE);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // backlight fades run in a little task which the LEDC fade end interrupt wakes up for each segment
+
+    struct backlight_fade
+    {
+        uint8_t brightness;
+        uint32_t duration_ms;
+        lcd_fade_callback callback;
+        void *context;
+    };
+
+    TaskHandle_t backlight_task_handle;
+    QueueHandle_t backlight_queue;
+
+    // where the last completed segment left it
+    uint8_t backlight_brightness = 0;
+
+    //////////////////////////////////////////////////////////////////////
+
+    IRAM_ATTR bool on_backlight_fade_end(ledc_cb_param_t const *param, void *)
+    {
+        BaseType_t woken = pdFALSE;
+        if(param->event == LEDC_FADE_END_EVT) {
+            vTaskNotifyGiveFromISR(backlight_task_handle, &woken);
+        }
+        return woken == pdTRUE;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void backlight_task(void *)
+    {
+        backlight_fade fade;
+
+        while(xQueueReceive(backlight_queue, &fade, portMAX_DELAY) == pdTRUE) {
+
+            uint8_t from = backlight_brightness;
+            uint32_t segment_ms = fade.duration_ms / LCD_BL_FADE_SEGMENTS;
+            bool interrupted = false;
+
+            for(int i = 1; i <= LCD_BL_FADE_SEGMENTS; ++i) {
+
+                uint8_t level = from + ((int)fade.brightness - from) * i / LCD_BL_FADE_SEGMENTS;
+
+                esp_err_t ret = ESP_FAIL;
+
+                if(segment_ms != 0) {
+
+                    // a fade end from a segment which overran its timeout would cut this one short
+                    ulTaskNotifyTake(pdTRUE, 0);
+
+                    ret = ledc_set_fade_with_time(LCD_BL_MODE, LCD_BL_CHANNEL, lcd_backlight_gamma(level), segment_ms);
+                    if(ret == ESP_OK) {
+                        ret = ledc_fade_start(LCD_BL_MODE, LCD_BL_CHANNEL, LEDC_FADE_NO_WAIT);
+                    }
+                    if(ret == ESP_OK) {
+                        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(segment_ms) + 2);
+                    } else {
+                        LOG_E("Backlight fade failed (%d), jumping to %d", ret, level);
+                    }
+                }
+
+                // no time to fade or the fade didn't start, just set it
+                if(ret != ESP_OK && ledc_set_duty_and_update(LCD_BL_MODE, LCD_BL_CHANNEL, lcd_backlight_gamma(level), 0) != ESP_OK) {
+                    LOG_E("Can't set backlight to %d", level);
+                }
+                backlight_brightness = level;
+
+                // a newer fade takes over from wherever this one has got to
+                if(uxQueueMessagesWaiting(backlight_queue) != 0) {
+                    interrupted = true;
+                    break;
+                }
+            }
+
+            if(!interrupted && fade.callback != nullptr) {
+                fade.callback(fade.context);
+            }
         }
     }
 
@@ -272,6 +867,18 @@ namespace
         ledc_channel.hpoint = 0;
         ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
 
+        ESP_ERROR_CHECK(ledc_fade_func_install(0));
+
+        backlight_queue = xQueueCreate(1, sizeof(backlight_fade));
+        ESP_RETURN_IF_NULL(backlight_queue);
+
+        xTaskCreatePinnedToCore(backlight_task, "backlight", 2048, nullptr, 5, &backlight_task_handle, 0);
+        ESP_RETURN_IF_NULL(backlight_task_handle);
+
+        ledc_cbs_t callbacks = {};
+        callbacks.fade_cb = on_backlight_fade_end;
+        ESP_ERROR_CHECK(ledc_cb_register(LCD_BL_MODE, LCD_BL_CHANNEL, &callbacks, nullptr));
+
         return ESP_OK;
     }
 
@@ -292,7 +899,7 @@ esp_err_t lcd_init()
     buscfg.quadwp_io_num = -1;
     buscfg.quadhd_io_num = -1;
     buscfg.flags = SPICOMMON_BUSFLAG_MASTER;
-    buscfg.max_transfer_sz = LCD_BYTES_PER_LINE * LCD_SECTION_HEIGHT;
+    buscfg.max_transfer_sz = LCD_BYTES_PER_LINE * LCD_MAX_SECTION_HEIGHT;
 
     spi_device_interface_config_t devcfg = {};
     devcfg.flags = SPI_DEVICE_NO_RETURN_RESULT;
@@ -300,7 +907,7 @@ esp_err_t lcd_init()
     devcfg.mode = 0;
     devcfg.queue_size = 6;
     devcfg.spics_io_num = LCD_PIN_NUM_CS;
-    devcfg.queue_size = LCD_NUM_SPI_TRANSFERS;
+    devcfg.queue_size = LCD_SPI_QUEUE_SIZE;
     devcfg.pre_cb = lcd_spi_pre_transfer_callback;
     devcfg.post_cb = lcd_spi_post_transfer_complete;
 
@@ -317,32 +924,6 @@ esp_err_t lcd_init()
     io_conf.pull_up_en = GPIO_PULLUP_ENABLE;
     gpio_config(&io_conf);
 
-    // Reset the LCD
-    gpio_set_level(LCD_PIN_NUM_RST, 0);
-    vTaskDelay(pdMS_TO_TICKS(100));
-
-    gpio_set_level(LCD_PIN_NUM_RST, 1);
-    vTaskDelay(pdMS_TO_TICKS(100));
-
-    uint8_t const *i = GC9A01A_initcmds;
-
-    while(*i != 0xff) {
-
-        uint8_t len = *i++;
-        uint8_t cmd = *i++;
-
-        bool delay = (len & 0x80) != 0;
-        uint8_t actual_len = len & 0x1f;
-
-        lcd_cmd(cmd, false);
-        lcd_data(i, actual_len);
-
-        if(delay) {
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-        i += actual_len;
-    }
-
     memset(spi_transactions, 0, sizeof(spi_transactions));
 
     spi_transactions[0].tx_data[0] = 0x2A;    // Column Address Set
@@ -376,59 +957,195 @@ esp_err_t lcd_init()
     spi_transactions[4].user = &spi_callback_cmd_last;
     spi_transactions[4].flags = SPI_TRANS_USE_TXDATA;
 
-    for(int i = 5; i < LCD_NUM_SPI_TRANSFERS; i++) {
+    init_dma_flag();
+
+    update_queue = xQueueCreate(1, sizeof(update_request));
+    ESP_RETURN_IF_NULL(update_queue);
 
-        int x = i - 5;
-        spi_transactions[i].tx_buffer = lcd_buffer[x & 1];
-        spi_transactions[i].length = LCD_WIDTH * LCD_BYTES_PER_PIXEL * 8 * LCD_SECTION_HEIGHT;
-        spi_transactions[i].user = &spi_callback_dma_data;
-        spi_transactions[i].flags = 0;
-    }
+    // the update task waits for this to finish
+    xTaskCreatePinnedToCore(lcd_init_task, "lcd_init", 2048, nullptr, 20, nullptr, 0);
 
-    init_dma_flag();
+    TaskHandle_t update_task_handle = nullptr;
+    xTaskCreatePinnedToCore(lcd_update_task, "lcd_update", LCD_UPDATE_TASK_STACK_SIZE, nullptr, LCD_UPDATE_TASK_PRIORITY, &update_task_handle,
+                            LCD_UPDATE_TASK_CORE);
+    ESP_RETURN_IF_NULL(update_task_handle);
 
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t lcd_update(lcd_buffer_filler filler_callback)
+esp_err_t lcd_update_async(lcd_buffer_filler filler_callback, lcd_update_callback callback, void *context, lcd_update_handle *out_handle)
 {
     if(filler_callback == nullptr) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // send the setup transfers
+    if(update_queue == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // one frame at a time, there is only one ring of section buffers
+    lcd_wait(last_handle, portMAX_DELAY);
+
+    last_handle += 1;
+
+    update_request request = { filler_callback, callback, context, last_handle };
 
-    xEventGroupClearBits(spi_bits, SPI_BIT_SETUP_COMPLETE);
+    xEventGroupClearBits(spi_bits, SPI_BIT_FRAME_IDLE);
+    xQueueSend(update_queue, &request, portMAX_DELAY);
 
-    for(int i = 0; i < 5; ++i) {
-        spi_device_queue_trans(spi, spi_transactions + i, portMAX_DELAY);
+    if(out_handle != nullptr) {
+        *out_handle = last_handle;
     }
+    return ESP_OK;
+}
 
-    // wait for setup to complete and set the dma complete flag
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_wait(lcd_update_handle handle, TickType_t ticks_to_wait)
+{
+    if((int32_t)(completed_handle - handle) >= 0) {
+        return ESP_OK;
+    }
+
+    // at most one frame is in flight so when that's done, so is this one
+    EventBits_t bits = xEventGroupWaitBits(spi_bits, SPI_BIT_FRAME_IDLE, pdFALSE, pdTRUE, ticks_to_wait);
+
+    return (bits & SPI_BIT_FRAME_IDLE) != 0 ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_update(lcd_buffer_filler filler_callback)
+{
+    lcd_update_handle handle;
+    ESP_RETURN_IF_FAILED(lcd_update_async(filler_callback, nullptr, nullptr, &handle));
+    return lcd_wait(handle, portMAX_DELAY);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_set_section_height(int height)
+{
+    if(height < LCD_MIN_SECTION_HEIGHT || height > LCD_MAX_SECTION_HEIGHT || (LCD_HEIGHT % height) != 0 ||
+       LCD_BYTES_PER_LINE * height > LCD_MAX_TRANSFER_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    xEventGroupSync(spi_bits, SPI_BIT_DMA_COMPLETE, SPI_BIT_SETUP_COMPLETE, portMAX_DELAY);
+    // the transfer lengths can't change under the frame being sent
+    lcd_wait(last_handle, portMAX_DELAY);
 
-    for(int i = 0; i < LCD_NUM_SECTIONS; ++i) {
+    section_height = height;
+    num_sections = LCD_HEIGHT / height;
 
-        // draw the pixels into the buffer
-        filler_callback(i, lcd_buffer[i & 1]);
+    LOG_I("Section height %d (%d sections)", section_height, num_sections);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_set_scroll_area(int top, int height)
+{
+    if(top < 0 || height < 0 || top + height > LCD_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(height == 0) {
+        top = 0;
+    }
 
-        // wait for previous dma to complete
-        xEventGroupWaitBits(spi_bits, SPI_BIT_DMA_COMPLETE, pdTRUE, pdTRUE, portMAX_DELAY);
+    lcd_wait(last_handle, portMAX_DELAY);
 
-        // start this buffer dma transfer
-        ESP_ERROR_CHECK(spi_device_queue_trans(spi, spi_transactions + i + 5, portMAX_DELAY));
+    if(top != scroll_top || height != scroll_height) {
+        scroll_top = top;
+        scroll_height = height;
+        scroll_area_changed = true;
+        scroll_area_valid = false;
     }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
+void lcd_set_scroll_offset(int offset)
+{
+    lcd_wait(last_handle, portMAX_DELAY);
+    scroll_offset = offset;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_invalidate_scroll_area()
+{
+    lcd_wait(last_handle, portMAX_DELAY);
+    scroll_area_valid = false;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int lcd_get_section_height()
+{
+    return section_height;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int lcd_get_num_sections()
+{
+    return num_sections;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+size_t lcd_get_section_buffer_bytes()
+{
+    return LCD_SECTION_BUFFERS * LCD_BYTES_PER_LINE * section_height;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_get_stats(lcd_stats_t *out_stats)
+{
+    if(out_stats != nullptr) {
+        *out_stats = stats;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void lcd_reset_stats()
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+//////////////////////////////////////////////////////////////////////
+
 esp_err_t lcd_set_backlight(uint32_t brightness_0_8191)
 {
     ESP_ERROR_CHECK(ledc_set_duty(LCD_BL_MODE, LCD_BL_CHANNEL, brightness_0_8191));
     ESP_ERROR_CHECK(ledc_update_duty(LCD_BL_MODE, LCD_BL_CHANNEL));
     return ESP_OK;
 }
+
+//////////////////////////////////////////////////////////////////////
+
+uint32_t lcd_backlight_gamma(uint8_t brightness)
+{
+    return (uint32_t)lrintf(powf(brightness / 255.0f, LCD_BL_GAMMA) * LCD_BL_MAX_DUTY);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t lcd_fade_backlight(uint8_t brightness, uint32_t duration_ms, lcd_fade_callback callback, void *context)
+{
+    if(backlight_queue == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    backlight_fade fade = { brightness, duration_ms, callback, context };
+
+    // only the latest one matters, it takes over from wherever the current fade has got to
+    xQueueOverwrite(backlight_queue, &fade);
+    return ESP_OK;
+}
@@ -7,13 +7,30 @@
 #include "util.h"
 #include "encoder.h"
 #include "display.h"
+#include "font.h"
 
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 //////////////////////////////////////////////////////////////////////
-// user input (from the encoder)
+// events, from the encoder or posted by other tasks and timers, go to the current input handler
+
+typedef enum ui_event_type
+{
+    ui_event_encoder = 0,    // value is the encoder_message_t
+    ui_event_timer = 1,      // value is whatever the timer posts, e.g. which timer it is
+    ui_event_network = 2,    // value is 1 when connected, 0 when not
+    ui_event_audio = 3,      // value is 1 when playing, 0 when stopped
+
+} ui_event_type_t;
+
+typedef struct ui_event
+{
+    ui_event_type_t type;
+    uint32_t value;
+
+} ui_event_t;
 
 // return ui_input_handler_pop to remove current handler from stack
 
@@ -24,10 +41,23 @@ typedef enum
 
 } ui_input_handler_status;
 
-typedef ui_input_handler_status (*ui_input_handler)(int frame);
+typedef ui_input_handler_status (*ui_input_handler)(ui_event_t const *event);
+
+// call before starting anything which posts ui events, the encoder's messages go to the input handlers
+esp_err_t ui_init(encoder_handle_t encoder);
+
+// from any task, doesn't wait if the queue is full
+esp_err_t ui_post_event(ui_event_type_t type, uint32_t value);
+
+// the ui task's loop, never returns. It sleeps until there's an event, passes it to the current input
+// handler and then, once there are no more waiting, draws a frame if anything needs drawing. Frames
+// are at least 1/max_fps apart, the first after a while with nothing to draw goes straight away
+void ui_run(int max_fps);
 
-esp_err_t ui_init();
+// draw another frame even if nothing has changed, e.g. from an animating draw item
+void ui_request_frame();
 
+// between display_begin_frame and display_end_frame
 void ui_draw(int frame);
 
 esp_err_t ui_push_input_handler(ui_input_handler h);
@@ -39,6 +69,9 @@ ui_input_handler ui_get_current_handler();
 
 // priority is 0 (at the bottom, drawn first) to 7 (at the top, drawn last)
 
+// draw items are drawn from scratch in every frame there is. Adding, removing or changing one asks
+// for a frame, one which animates calls ui_request_frame when it draws to get the next one
+
 typedef enum ui_draw_priority
 {
     ui_draw_priority_min = 0,
@@ -82,6 +115,82 @@ esp_err_t ui_item_set_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags
 esp_err_t ui_item_toggle_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags);
 ui_draw_item_flags ui_item_get_flags(ui_draw_item_handle_t item);
 
+//////////////////////////////////////////////////////////////////////
+// retained widgets. Each keeps its layout and screen bounds, and setting a property only marks it
+// dirty. ui_draw then redraws just the areas which changed (so there has to be an opaque clear color
+// to draw them over and no visible draw items, which are redrawn from scratch every frame). The lists
+// backend redraws and sends the whole sections they're in, the framebuffer just the areas, and
+// nothing needs drawing at all until something changes, see ui_needs_draw
+
+typedef enum ui_widget_type
+{
+    ui_widget_label = 0,          // a line of text in a bitmap font
+    ui_widget_image = 1,
+    ui_widget_arc = 2,            // display_arc, its position is the centre
+    ui_widget_list = 3,           // lays its children out top to bottom, draws nothing itself
+    ui_widget_scroll_list = 4,    // any number of rows of text, see ui_scroll_list_set_items
+
+} ui_widget_type_t;
+
+typedef struct ui_widget *ui_widget_handle_t;
+
+#define UI_LABEL_MAX_TEXT 32
+
+// a widget with no parent is drawn with the draw items of its priority, after them
+ui_widget_handle_t ui_widget_create(ui_widget_type_t type, ui_widget_handle_t parent, ui_draw_priority_t priority);
+
+// and all its children
+esp_err_t ui_widget_destroy(ui_widget_handle_t widget);
+
+// relative to the parent's position, a list ignores it and places its children itself
+esp_err_t ui_widget_set_pos(ui_widget_handle_t widget, vec2i const *pos);
+esp_err_t ui_widget_set_flags(ui_widget_handle_t widget, ui_draw_item_flags flags);
+esp_err_t ui_widget_clear_flags(ui_widget_handle_t widget, ui_draw_item_flags flags);
+
+// as of the last ui_draw
+esp_err_t ui_widget_get_bounds(ui_widget_handle_t widget, vec2i *pos, vec2i *size);
+
+esp_err_t ui_label_set_text(ui_widget_handle_t label, font_handle_t font, char const *text);
+esp_err_t ui_label_set_color(ui_widget_handle_t label, uint32_t color, uint8_t blendmode);
+
+esp_err_t ui_image_set(ui_widget_handle_t image, uint8_t image_id, uint8_t alpha, uint8_t blendmode);
+
+esp_err_t ui_arc_set_radius(ui_widget_handle_t arc, float inner_radius, float outer_radius);
+esp_err_t ui_arc_set_angles(ui_widget_handle_t arc, float start_angle, float end_angle);
+esp_err_t ui_arc_set_color(ui_widget_handle_t arc, uint32_t color, uint8_t blendmode);
+
+esp_err_t ui_list_set_spacing(ui_widget_handle_t list, int spacing);
+
+//////////////////////////////////////////////////////////////////////
+// a scroll list shows a window onto any number of items, one row of text each, with the selected row
+// in the middle. Only the rows in view and one either side exist, made from the widget pool as they
+// scroll in and given back as they leave, and an item's text is only fetched when its row is made,
+// so the items can stay in flash. The view springs along after the selected row
+
+// text_size is UI_LABEL_MAX_TEXT, longer text is cut off
+typedef esp_err_t (*ui_scroll_list_fetch_function)(void *context, int index, char *text, size_t text_size);
+
+// reserves the widgets for every row which can be in view, ESP_ERR_NO_MEM if the pool hasn't got enough
+esp_err_t ui_scroll_list_set_view(ui_widget_handle_t list, vec2i const *size, int row_height, font_handle_t font);
+esp_err_t ui_scroll_list_set_colors(ui_widget_handle_t list, uint32_t color, uint32_t selected_color, uint8_t blendmode);
+
+// fetches every row again, so call it when the items change too
+esp_err_t ui_scroll_list_set_items(ui_widget_handle_t list, int count, ui_scroll_list_fetch_function fetch, void *context);
+
+// by encoder detents, each one goes further while it's turning quickly
+esp_err_t ui_scroll_list_scroll(ui_widget_handle_t list, int detents);
+esp_err_t ui_scroll_list_set_selected(ui_widget_handle_t list, int index, bool animate);
+int ui_scroll_list_get_selected(ui_widget_handle_t list);
+
+// what the changed areas are cleared to before they're redrawn, alpha 0 for nothing
+void ui_set_clear_color(uint32_t color);
+
+// redraw everything in the next ui_draw, e.g. after switching display backend
+void ui_invalidate();
+
+// true if a frame has been requested, anything has changed since the last ui_draw or a scroll list is moving
+bool ui_needs_draw();
+
 //////////////////////////////////////////////////////////////////////
 
 #if defined(__cplusplus)
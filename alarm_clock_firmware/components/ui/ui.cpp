@@ -1,9 +1,13 @@
 //////////////////////////////////////////////////////////////////////
 
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 
 #include <freertos/FreeRTOS.h>
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "esp_log.h"
 #include "esp_timer.h"
@@ -11,6 +15,8 @@
 
 #include "util.h"
 #include "chs_list.h"
+#include "image.h"
+#include "lcd_gc9a01.h"
 #include "ui.h"
 
 LOG_CONTEXT("ui");
@@ -27,158 +33,1283 @@ struct ui_draw_item : chs::list_node<ui_draw_item>
 
 //////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // x1, y1 exclusive
+    struct ui_rect
+    {
+        int x0, y0, x1, y1;
+    };
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+struct ui_widget : chs::list_node<ui_widget>
+{
+    uint32_t type : 3;
+    uint32_t priority : 3;
+    uint32_t flags : 8;      // ui_draw_item_flags
+    uint32_t dirty : 1;      // needs drawing again
+    uint32_t measure : 1;    // size needs working out again
+    uint32_t drawn : 1;      // was drawn at bounds by the last ui_draw
+
+    ui_widget *parent;
+    chs::linked_list<ui_widget> children;
+
+    vec2i pos;       // relative to the parent
+    vec2i offset;    // from pos to the top left of the bounds
+    vec2i size;
+    ui_rect bounds;    // on screen, as of the last ui_draw
+
+    uint32_t color;
+    uint8_t blendmode;
+
+    union
+    {
+        struct
+        {
+            font_handle_t font;
+            char text[UI_LABEL_MAX_TEXT];
+            int row;    // which item it is, in a scroll list
+        } label;
+
+        struct
+        {
+            uint8_t image_id;
+            uint8_t alpha;
+        } image;
+
+        struct
+        {
+            float inner_radius;
+            float outer_radius;
+            float start_angle;
+            float end_angle;
+        } arc;
+
+        struct
+        {
+            int spacing;
+        } list;
+
+        struct
+        {
+            ui_scroll_list_fetch_function fetch;
+            void *context;
+            font_handle_t font;
+            int count;
+            int row_height;
+            int reserved;              // rows set aside in the widget pool by ui_scroll_list_set_view
+            int selected;              // where the view is heading
+            int speed;                 // rows per detent, goes up while the encoder turns quickly
+            float position;            // of the middle of the view, in pixels down the whole list
+            float velocity;            // pixels per second
+            int64_t last_time_us;      // of the last layout
+            int64_t last_input_us;
+            uint32_t selected_color;
+            vec2i view;
+        } scroll;
+    };
+};
+
+//////////////////////////////////////////////////////////////////////
+
 namespace
 {
     ui_input_handler ui_handler_stack[16];
     int ui_handler_stack_length = 0;
 
-    ui_draw_item draw_items_pool[256];
+    int constexpr ui_event_queue_length = 16;
+
+    QueueHandle_t event_queue = nullptr;
+
+    // the ui task sleeps on this, members are the encoder's queue, event_queue and frame_semaphore
+    QueueSetHandle_t event_set = nullptr;
+
+    encoder_handle_t ui_encoder = nullptr;
+    QueueHandle_t encoder_queue = nullptr;
+
+    // given by frame_timer when the next frame is due
+    SemaphoreHandle_t frame_semaphore = nullptr;
+    esp_timer_handle_t frame_timer = nullptr;
+
+    ui_draw_item draw_items_pool[256];
+
+    chs::linked_list<ui_draw_item> free_draw_items;
+
+    chs::linked_list<ui_draw_item> live_draw_items[ui_draw_num_priorities];
+
+    ui_widget widgets_pool[64];
+
+    chs::linked_list<ui_widget> free_widgets;
+    int num_free_widgets = 0;
+
+    // free widgets promised to scroll lists' rows, nothing else can have them
+    int reserved_widgets = 0;
+
+    // top level widgets, the rest are in their parent's children
+    chs::linked_list<ui_widget> live_widgets[ui_draw_num_priorities];
+
+    // screen areas to draw again, none overlap so nothing is blended twice
+    int constexpr max_damage_rects = 8;
+
+    ui_rect damage[max_damage_rects];
+    int num_damage = 0;
+
+    uint32_t clear_color = 0;
+    bool redraw_all = true;
+    bool widgets_changed = false;
+    bool frame_requested = true;
+
+    // a scroll list is still moving so there's another frame to draw
+    bool animating = false;
+
+    // detents closer together than this speed a scroll list up
+    int constexpr scroll_fast_us = 60000;
+    int constexpr scroll_max_speed = 8;
+
+    // how quickly the view catches up with the selected row, per second
+    float constexpr scroll_spring = 18.0f;
+
+    //////////////////////////////////////////////////////////////////////
+
+    void init_draw_items_pool()
+    {
+        free_draw_items.clear();
+        for(ui_draw_item &p : draw_items_pool) {
+            free_draw_items.push_back(p);
+        }
+        for(auto &l : live_draw_items) {
+            l.clear();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    ui_draw_item *allocate_draw_item(ui_draw_priority priority)
+    {
+        if(free_draw_items.empty()) {
+            return nullptr;
+        }
+        ui_draw_item *new_item = free_draw_items.pop_back();
+        new_item->priority = priority;
+        new_item->flags = 0;
+        live_draw_items[priority].push_back(new_item);
+        frame_requested = true;
+        return new_item;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void free_draw_item(ui_draw_item *i)
+    {
+        live_draw_items[i->priority].remove(i);
+        free_draw_items.push_back(i);
+        frame_requested = true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool any_visible_draw_items()
+    {
+        for(auto &l : live_draw_items) {
+            for(auto *d = l.head(); d != l.done(); d = l.next(d)) {
+                if((d->flags & uif_hidden) == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool rect_empty(ui_rect const &r)
+    {
+        return r.x0 >= r.x1 || r.y0 >= r.y1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool rects_overlap(ui_rect const &a, ui_rect const &b)
+    {
+        return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool rects_equal(ui_rect const &a, ui_rect const &b)
+    {
+        return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    ui_rect rect_union(ui_rect const &a, ui_rect const &b)
+    {
+        return ui_rect{ min(a.x0, b.x0), min(a.y0, b.y0), max(a.x1, b.x1), max(a.y1, b.y1) };
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    ui_rect rect_intersect(ui_rect const &a, ui_rect const &b)
+    {
+        return ui_rect{ max(a.x0, b.x0), max(a.y0, b.y0), min(a.x1, b.x1), min(a.y1, b.y1) };
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    int rect_area(ui_rect const &r)
+    {
+        return (r.x1 - r.x0) * (r.y1 - r.y0);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // merge it with any it overlaps, if there are too many fold it into whichever grows least
+
+    void add_damage(ui_rect r)
+    {
+        r.x0 = max(r.x0, 0);
+        r.y0 = max(r.y0, 0);
+        r.x1 = min(r.x1, (int)LCD_WIDTH);
+        r.y1 = min(r.y1, (int)LCD_HEIGHT);
+
+        if(rect_empty(r)) {
+            return;
+        }
+
+        int i = 0;
+        while(i < num_damage) {
+            if(rects_overlap(r, damage[i])) {
+                r = rect_union(r, damage[i]);
+                num_damage -= 1;
+                damage[i] = damage[num_damage];
+                i = 0;
+            } else {
+                i += 1;
+            }
+        }
+
+        if(num_damage == max_damage_rects) {
+
+            int best = 0;
+            int best_growth = INT_MAX;
+
+            for(int j = 0; j < num_damage; ++j) {
+                int growth = rect_area(rect_union(r, damage[j])) - rect_area(damage[j]);
+                if(growth < best_growth) {
+                    best = j;
+                    best_growth = growth;
+                }
+            }
+            r = rect_union(r, damage[best]);
+            num_damage -= 1;
+            damage[best] = damage[num_damage];
+            add_damage(r);
+            return;
+        }
+
+        damage[num_damage] = r;
+        num_damage += 1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void init_widgets_pool()
+    {
+        free_widgets.clear();
+        for(ui_widget &w : widgets_pool) {
+            free_widgets.push_back(w);
+        }
+        num_free_widgets = countof(widgets_pool);
+        reserved_widgets = 0;
+        for(auto &l : live_widgets) {
+            l.clear();
+        }
+        num_damage = 0;
+        redraw_all = true;
+        widgets_changed = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    chs::linked_list<ui_widget> &siblings(ui_widget *w)
+    {
+        return w->parent != nullptr ? w->parent->children : live_widgets[w->priority];
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void mark_dirty(ui_widget *w, bool measure)
+    {
+        w->dirty = 1;
+        if(measure) {
+            w->measure = 1;
+        }
+        widgets_changed = true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    ui_widget *allocate_widget(ui_widget_type_t type, ui_widget *parent, ui_draw_priority_t priority)
+    {
+        // a scroll list's rows come out of what it reserved
+        bool row = parent != nullptr && parent->type == ui_widget_scroll_list;
+
+        if(row ? reserved_widgets == 0 : num_free_widgets == reserved_widgets) {
+            return nullptr;
+        }
+
+        ui_widget *w = free_widgets.pop_back();
+        num_free_widgets -= 1;
+        if(row) {
+            reserved_widgets -= 1;
+        }
+
+        w->type = type;
+        w->priority = parent != nullptr ? parent->priority : priority;
+        w->flags = 0;
+        w->dirty = 1;
+        w->measure = 1;
+        w->drawn = 0;
+        w->parent = parent;
+        w->children.clear();
+        w->pos = vec2i{ 0, 0 };
+        w->offset = vec2i{ 0, 0 };
+        w->size = vec2i{ 0, 0 };
+        w->bounds = ui_rect{ 0, 0, 0, 0 };
+        w->color = COLOR_WHITE;
+        w->blendmode = blend_multiply;
+
+        switch(type) {
+
+        case ui_widget_label:
+            w->label.font = nullptr;
+            w->label.text[0] = 0;
+            w->label.row = 0;
+            break;
+
+        case ui_widget_image:
+            w->image.image_id = 0;
+            w->image.alpha = 255;
+            break;
+
+        case ui_widget_arc:
+            w->arc.inner_radius = 0;
+            w->arc.outer_radius = 0;
+            w->arc.start_angle = 0;
+            w->arc.end_angle = (float)M_TWOPI;
+            break;
+
+        case ui_widget_list:
+            w->list.spacing = 0;
+            break;
+
+        case ui_widget_scroll_list:
+            w->scroll.fetch = nullptr;
+            w->scroll.context = nullptr;
+            w->scroll.font = nullptr;
+            w->scroll.count = 0;
+            w->scroll.row_height = 1;
+            w->scroll.reserved = 0;
+            w->scroll.selected = 0;
+            w->scroll.speed = 1;
+            w->scroll.position = 0;
+            w->scroll.velocity = 0;
+            w->scroll.last_time_us = 0;
+            w->scroll.last_input_us = 0;
+            w->scroll.selected_color = COLOR_WHITE;
+            w->scroll.view = vec2i{ 0, 0 };
+            break;
+        }
+
+        siblings(w).push_back(w);
+        widgets_changed = true;
+        return w;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void destroy_widget(ui_widget *w)
+    {
+        while(!w->children.empty()) {
+            destroy_widget(w->children.head());
+        }
+        if(w->drawn) {
+            add_damage(w->bounds);
+        }
+        if(w->parent != nullptr && w->parent->type == ui_widget_scroll_list) {
+            reserved_widgets += 1;
+        }
+        if(w->type == ui_widget_scroll_list) {
+            reserved_widgets -= w->scroll.reserved;
+        }
+        siblings(w).remove(w);
+        free_widgets.push_back(w);
+        num_free_widgets += 1;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // as display_arc works them out, relative to the centre, so changing the angles
+    // of a progress arc only redraws the part it sweeps through
+
+    void measure_arc(ui_widget *w)
+    {
+        float inner = w->arc.inner_radius;
+        float outer = w->arc.outer_radius;
+        float start = w->arc.start_angle;
+        float end = w->arc.end_angle;
+
+        if(outer <= 0 || inner >= outer || end <= start) {
+            w->size = vec2i{ 0, 0 };
+            return;
+        }
+
+        float x0 = -outer;
+        float y0 = -outer;
+        float x1 = outer;
+        float y1 = outer;
+
+        if(end - start < (float)M_TWOPI) {
+
+            float sx = sinf(start);
+            float sy = -cosf(start);
+            float ex = sinf(end);
+            float ey = -cosf(end);
+
+            x0 = min(min(sx, ex) * outer, min(sx, ex) * inner);
+            x1 = max(max(sx, ex) * outer, max(sx, ex) * inner);
+            y0 = min(min(sy, ey) * outer, min(sy, ey) * inner);
+            y1 = max(max(sy, ey) * outer, max(sy, ey) * inner);
+
+            int first = (int)ceilf(start / (float)M_PI_2);
+            int last = (int)floorf(end / (float)M_PI_2);
+
+            for(int i = first; i <= last; ++i) {
+                switch(i & 3) {
+                case 0:
+                    y0 = -outer;
+                    break;
+                case 1:
+                    x1 = outer;
+                    break;
+                case 2:
+                    y1 = outer;
+                    break;
+                case 3:
+                    x0 = -outer;
+                    break;
+                }
+            }
+        }
+
+        // a pixel more all round for the soft edge
+        int left = (int)floorf(x0 - 1);
+        int top = (int)floorf(y0 - 1);
+        w->offset = vec2i{ left, top };
+        w->size = vec2i{ (int)ceilf(x1 + 1) - left, (int)ceilf(y1 + 1) - top };
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the size and where the bounds are relative to the position, lists are sized by layout_widget
+
+    void measure_widget(ui_widget *w)
+    {
+        w->measure = 0;
+        w->offset = vec2i{ 0, 0 };
+
+        switch(w->type) {
+
+        case ui_widget_label:
+            w->size = vec2i{ 0, 0 };
+            if(w->label.font != nullptr && w->label.text[0] != 0) {
+                font_measure_string(w->label.font, (uint8_t const *)w->label.text, &w->size);
+            }
+            break;
+
+        case ui_widget_image: {
+            image_t const *image = image_get(w->image.image_id);
+            w->size = image != nullptr ? vec2i{ image->width, image->height } : vec2i{ 0, 0 };
+        } break;
+
+        case ui_widget_arc:
+            measure_arc(w);
+            break;
+
+        case ui_widget_scroll_list:
+            w->size = w->scroll.view;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // only the part of it which was in view needs redrawing
+
+    void destroy_scroll_list_row(ui_widget *list, ui_widget *row)
+    {
+        if(row->drawn) {
+            add_damage(rect_intersect(row->bounds, list->bounds));
+            row->drawn = 0;
+        }
+        destroy_widget(row);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void destroy_scroll_list_rows(ui_widget *list)
+    {
+        while(!list->children.empty()) {
+            destroy_scroll_list_row(list, list->children.head());
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // most rows update_scroll_list_rows can want at once, the ones in view, part rows at
+    // either end and one beyond each of those
+
+    int scroll_list_max_rows(vec2i const &view, int row_height)
+    {
+        return view.y / row_height + 4;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // a critically damped spring pulls the view along after the selected row
+
+    void animate_scroll_list(ui_widget *w)
+    {
+        int64_t now = esp_timer_get_time();
+        float dt = min((float)(now - w->scroll.last_time_us) * 1e-6f, 0.05f);
+        w->scroll.last_time_us = now;
+
+        float target = (float)(w->scroll.selected * w->scroll.row_height);
+        float x = w->scroll.position;
+        float v = w->scroll.velocity;
+
+        if(x == target && v == 0) {
+            return;
+        }
+
+        v += (scroll_spring * scroll_spring * (target - x) - 2 * scroll_spring * v) * dt;
+        x += v * dt;
+
+        if(fabsf(target - x) < 0.25f && fabsf(v) < 4.0f) {
+            x = target;
+            v = 0;
+        } else {
+            animating = true;
+        }
+
+        w->scroll.position = x;
+        w->scroll.velocity = v;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // make rows for the items in view and one either side, give back the ones which scrolled out
+
+    void update_scroll_list_rows(ui_widget *w)
+    {
+        // no view yet
+        if(w->scroll.reserved == 0) {
+            return;
+        }
+
+        int row_height = w->scroll.row_height;
+
+        // where row 0 is relative to the top of the view
+        int top = (int)floorf((float)(w->scroll.view.y - row_height) * 0.5f - w->scroll.position);
+
+        int first = max(0, (int)floorf((float)-top / row_height) - 1);
+        int last = min(w->scroll.count - 1, (int)floorf((float)(w->scroll.view.y - top) / row_height) + 1);
+
+        ui_widget *c = w->children.head();
+        while(c != w->children.done()) {
+            ui_widget *next = w->children.next(c);
+            if(c->label.row < first || c->label.row > last) {
+                destroy_scroll_list_row(w, c);
+            }
+            c = next;
+        }
+
+        int text_y = 0;
+        if(w->scroll.font != nullptr) {
+            text_y = (row_height - w->scroll.font->font_struct->height) / 2;
+        }
+
+        for(int row = first; row <= last; ++row) {
+
+            ui_widget *r = w->children.head();
+            while(r != w->children.done() && r->label.row != row) {
+                r = w->children.next(r);
+            }
+
+            if(r == w->children.done()) {
+
+                // can't happen, set_view reserved enough
+                r = allocate_widget(ui_widget_label, w, ui_draw_priority_0);
+                if(r == nullptr) {
+                    LOG_E("Scroll list out of rows");
+                    break;
+                }
+                r->label.row = row;
+                r->label.font = w->scroll.font;
+                r->blendmode = w->blendmode;
+
+                if(w->scroll.fetch == nullptr || w->scroll.fetch(w->scroll.context, row, r->label.text, UI_LABEL_MAX_TEXT) != ESP_OK) {
+                    r->label.text[0] = 0;
+                }
+                r->label.text[UI_LABEL_MAX_TEXT - 1] = 0;
+            }
+
+            r->pos = vec2i{ 0, top + row * row_height + text_y };
+
+            uint32_t color = row == w->scroll.selected ? w->scroll.selected_color : w->color;
+            if(color != r->color) {
+                r->color = color;
+                r->dirty = 1;
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // position everything from the (already positioned) anchor down and note what has to be redrawn,
+    // the old bounds of anything which moved, changed or went away and the new bounds of it
+
+    void layout_widget(ui_widget *w, vec2i anchor, bool visible, ui_rect const &clip)
+    {
+        visible = visible && (w->flags & uif_hidden) == 0;
+
+        if(w->measure) {
+            measure_widget(w);
+        }
+
+        if(w->type == ui_widget_list) {
+
+            // hidden children take up no space
+            int y = anchor.y;
+            int width = 0;
+            int height = 0;
+
+            for(ui_widget *c = w->children.head(); c != w->children.done(); c = w->children.next(c)) {
+
+                if(c->measure) {
+                    measure_widget(c);
+                }
+
+                bool shown = (c->flags & uif_hidden) == 0;
+
+                layout_widget(c, vec2i{ anchor.x - c->offset.x, y - c->offset.y }, visible, clip);
+
+                if(shown) {
+                    width = max(width, c->size.x);
+                    height = y + c->size.y - anchor.y;
+                    y += c->size.y + w->list.spacing;
+                }
+            }
+            w->size = vec2i{ width, height };
+
+        } else if(w->type == ui_widget_scroll_list) {
+
+            animate_scroll_list(w);
+            update_scroll_list_rows(w);
+
+            // the rows are only seen through the view
+            ui_rect view = rect_intersect(clip, ui_rect{ anchor.x, anchor.y, anchor.x + w->size.x, anchor.y + w->size.y });
+
+            for(ui_widget *c = w->children.head(); c != w->children.done(); c = w->children.next(c)) {
+                layout_widget(c, vec2i{ anchor.x + c->pos.x, anchor.y + c->pos.y }, visible, view);
+            }
+
+        } else {
+
+            for(ui_widget *c = w->children.head(); c != w->children.done(); c = w->children.next(c)) {
+                layout_widget(c, vec2i{ anchor.x + c->pos.x, anchor.y + c->pos.y }, visible, clip);
+            }
+        }
+
+        int x0 = anchor.x + w->offset.x;
+        int y0 = anchor.y + w->offset.y;
+        ui_rect bounds = { x0, y0, x0 + w->size.x, y0 + w->size.y };
+
+        bool container = w->type == ui_widget_list || w->type == ui_widget_scroll_list;
+        bool draws = visible && !container && !rect_empty(bounds);
+
+        if(w->dirty || draws != (bool)w->drawn || (draws && !rects_equal(bounds, w->bounds))) {
+            if(w->drawn) {
+                add_damage(rect_intersect(w->bounds, clip));
+            }
+            if(draws) {
+                add_damage(rect_intersect(bounds, clip));
+            }
+        }
+
+        w->bounds = bounds;
+        w->drawn = draws;
+        w->dirty = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void layout_widgets()
+    {
+        ui_rect screen = { 0, 0, LCD_WIDTH, LCD_HEIGHT };
+
+        animating = false;
+
+        for(auto &l : live_widgets) {
+            for(ui_widget *w = l.head(); w != l.done(); w = l.next(w)) {
+                layout_widget(w, w->pos, true, screen);
+            }
+        }
+        widgets_changed = animating;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // area is nullptr to draw all of it
+
+    void draw_widget(ui_widget *w, ui_rect const *area)
+    {
+        if((w->flags & uif_hidden) != 0) {
+            return;
+        }
+
+        // a list's bounds hold all its children
+        bool container = w->type == ui_widget_list || w->type == ui_widget_scroll_list;
+        if(area != nullptr && !rects_overlap(w->bounds, *area) && container) {
+            return;
+        }
+
+        if(w->drawn && (area == nullptr || rects_overlap(w->bounds, *area))) {
+
+            vec2i pos = { w->bounds.x0, w->bounds.y0 };
+
+            switch(w->type) {
+
+            case ui_widget_label:
+                font_drawtext(w->label.font, &pos, (uint8_t const *)w->label.text, w->color, w->blendmode);
+                break;
+
+            case ui_widget_image: {
+                vec2i src_pos = { 0, 0 };
+                display_imagerect(&pos, &src_pos, &w->size, w->image.image_id, w->image.alpha, w->blendmode);
+            } break;
+
+            case ui_widget_arc: {
+                vec2f centre = { (float)(pos.x - w->offset.x), (float)(pos.y - w->offset.y) };
+                display_arc(&centre, w->arc.inner_radius, w->arc.outer_radius, w->arc.start_angle, w->arc.end_angle, w->color, w->blendmode);
+            } break;
+
+            default:
+                break;
+            }
+        }
+
+        if(w->type == ui_widget_scroll_list) {
+            vec2i pos = { w->bounds.x0, w->bounds.y0 };
+            display_push_clip(&pos, &w->size);
+        }
+
+        for(ui_widget *c = w->children.head(); c != w->children.done(); c = w->children.next(c)) {
+            draw_widget(c, area);
+        }
+
+        if(w->type == ui_widget_scroll_list) {
+            display_pop_clip();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void clear_rect(ui_rect const &r)
+    {
+        if((clear_color >> 24) == 0) {
+            return;
+        }
+        vec2i pos = { r.x0, r.y0 };
+        vec2i size = { r.x1 - r.x0, r.y1 - r.y0 };
+        display_fillrect(&pos, &size, clear_color, (clear_color >> 24) == 0xff ? blend_opaque : blend_multiply);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool widget_is(ui_widget_handle_t w, ui_widget_type_t type)
+    {
+        return w != nullptr && w->type == type;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    void IRAM_ATTR on_frame_timer(void *)
+    {
+        xSemaphoreGive(frame_semaphore);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void dispatch_event(ui_event_t const *event)
+    {
+        ui_input_handler handler = ui_get_current_handler();
+
+        if(handler != nullptr && handler(event) == ui_input_handler_pop) {
+            ui_pop_current_handler();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void draw_frame(int frame)
+    {
+        display_begin_frame();
+        ui_draw(frame);
+        display_end_frame();
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_init(encoder_handle_t encoder)
+{
+    if(event_set != nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    init_draw_items_pool();
+    init_widgets_pool();
+
+    ui_encoder = encoder;
+    ESP_RETURN_IF_FAILED(encoder_get_queue(encoder, &encoder_queue));
+
+    QueueHandle_t queue = xQueueCreate(ui_event_queue_length, sizeof(ui_event_t));
+    ESP_RETURN_IF_NULL(queue);
+
+    frame_semaphore = xSemaphoreCreateBinary();
+    ESP_RETURN_IF_NULL(frame_semaphore);
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = on_frame_timer;
+    timer_args.dispatch_method = ESP_TIMER_TASK;
+    timer_args.name = "ui_frame";
+    ESP_RETURN_IF_FAILED(esp_timer_create(&timer_args, &frame_timer));
+
+    // room for everything the members can hold
+    event_set = xQueueCreateSet(ENCODER_QUEUE_LENGTH + ui_event_queue_length + 1);
+    ESP_RETURN_IF_NULL(event_set);
+
+    // a member has to be empty when it's added. Nothing can post to the event queue
+    // until it's published below and nothing gives frame_semaphore until ui_run, but
+    // the encoder is already live so drop anything it sent before now
+    encoder_message_t msg;
+    do {
+        while(encoder_get_message(ui_encoder, &msg) == ESP_OK) {
+        }
+    } while(xQueueAddToSet(encoder_queue, event_set) != pdPASS);
+
+    if(xQueueAddToSet(queue, event_set) != pdPASS || xQueueAddToSet(frame_semaphore, event_set) != pdPASS) {
+        return ESP_FAIL;
+    }
+
+    // ui_post_event works from here on
+    event_queue = queue;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+ui_draw_item_handle_t ui_add_item(ui_draw_priority_t priority, ui_draw_function_t draw_function)
+{
+    assert(priority >= ui_draw_priority_0 && priority < ui_draw_num_priorities);
+    assert(draw_function != nullptr);
+
+    ui_draw_item_handle_t new_item = allocate_draw_item(priority);
+    if(new_item != nullptr) {
+        new_item->draw_function = draw_function;
+    }
+    return new_item;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_remove_item(ui_draw_item_handle_t item)
+{
+    if(item == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    free_draw_item(item);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_item_change_priority(ui_draw_item_handle_t item, ui_draw_priority new_priority)
+{
+    if(item == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(new_priority == item->priority) {
+        return ESP_OK;
+    }
+    live_draw_items[item->priority].remove(item);
+    item->priority = new_priority;
+    live_draw_items[new_priority].push_back(item);
+    frame_requested = true;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_item_get_flags(ui_draw_item_handle_t item, ui_draw_item_flags *flags)
+{
+    if(item == nullptr || flags == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *flags = static_cast<ui_draw_item_flags>(item->flags);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_item_set_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+{
+    if(item == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    item->flags |= flags;
+    frame_requested = true;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_item_clear_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+{
+    if(item == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    item->flags &= ~flags;
+    frame_requested = true;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
 
-    chs::linked_list<ui_draw_item> free_draw_items;
+esp_err_t ui_item_toggle_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+{
+    if(item == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    item->flags ^= flags;
+    frame_requested = true;
+    return ESP_OK;
+}
 
-    chs::linked_list<ui_draw_item> live_draw_items[ui_draw_num_priorities];
+//////////////////////////////////////////////////////////////////////
 
-    //////////////////////////////////////////////////////////////////////
+void ui_draw(int frame)
+{
+    // cleared first so draw items can ask for the next frame
+    frame_requested = false;
 
-    void init_draw_items_pool()
-    {
-        free_draw_items.clear();
-        for(ui_draw_item &p : draw_items_pool) {
-            free_draw_items.push_back(p);
-        }
-        for(auto &l : live_draw_items) {
-            l.clear();
+    layout_widgets();
+
+    // redraw just the damage if the display has the rest and nothing else needs drawing
+    bool partial = !redraw_all && (clear_color >> 24) == 0xff && !any_visible_draw_items();
+
+    if(partial) {
+
+        // the display might need more drawing than that (whole sections with the lists backend),
+        // grown rects can overlap now so they go through add_damage again. An empty one just
+        // asks whether it can keep the rest, which it can't before it's shown anything
+
+        ui_rect changed[max_damage_rects];
+        int num_changed = num_damage;
+        memcpy(changed, damage, sizeof(ui_rect) * num_changed);
+        num_damage = 0;
+
+        vec2i none = { 0, 0 };
+        vec2i none_size = { 0, 0 };
+        partial = display_add_damage(&none, &none_size);
+
+        for(int i = 0; i < num_changed && partial; ++i) {
+            ui_rect const &r = changed[i];
+            vec2i pos = { r.x0, r.y0 };
+            vec2i size = { r.x1 - r.x0, r.y1 - r.y0 };
+            partial = display_add_damage(&pos, &size);
+            add_damage(ui_rect{ pos.x, pos.y, pos.x + size.x, pos.y + size.y });
         }
     }
 
-    //////////////////////////////////////////////////////////////////////
+    if(partial) {
 
-    ui_draw_item *allocate_draw_item(ui_draw_priority priority)
-    {
-        if(free_draw_items.empty()) {
-            return nullptr;
+        for(int i = 0; i < num_damage; ++i) {
+
+            ui_rect const &r = damage[i];
+
+            vec2i pos = { r.x0, r.y0 };
+            vec2i size = { r.x1 - r.x0, r.y1 - r.y0 };
+            display_push_clip(&pos, &size);
+
+            clear_rect(r);
+
+            for(auto &l : live_widgets) {
+                for(ui_widget *w = l.head(); w != l.done(); w = l.next(w)) {
+                    draw_widget(w, &r);
+                }
+            }
+
+            display_pop_clip();
+        }
+
+    } else {
+
+        clear_rect(ui_rect{ 0, 0, LCD_WIDTH, LCD_HEIGHT });
+
+        for(int p = 0; p < ui_draw_num_priorities; ++p) {
+
+            chs::linked_list<ui_draw_item> &items = live_draw_items[p];
+            for(auto *d = items.head(); d != items.done(); d = items.next(d)) {
+                if((d->flags & uif_hidden) == 0) {
+                    d->draw_function(frame);
+                }
+            }
+
+            chs::linked_list<ui_widget> &widgets = live_widgets[p];
+            for(ui_widget *w = widgets.head(); w != widgets.done(); w = widgets.next(w)) {
+                draw_widget(w, nullptr);
+            }
         }
-        ui_draw_item *new_item = free_draw_items.pop_back();
-        new_item->priority = priority;
-        new_item->flags = 0;
-        live_draw_items[priority].push_back(new_item);
-        return new_item;
     }
 
-    //////////////////////////////////////////////////////////////////////
+    num_damage = 0;
+    redraw_all = false;
+}
 
-    void free_draw_item(ui_draw_item *i)
-    {
-        live_draw_items[i->priority].remove(i);
-        free_draw_items.push_back(i);
+//////////////////////////////////////////////////////////////////////
+
+void ui_request_frame()
+{
+    frame_requested = true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+bool ui_needs_draw()
+{
+    return frame_requested || redraw_all || widgets_changed || num_damage != 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ui_invalidate()
+{
+    redraw_all = true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ui_set_clear_color(uint32_t color)
+{
+    if(color != clear_color) {
+        clear_color = color;
+        redraw_all = true;
     }
+}
 
-}    // namespace
+//////////////////////////////////////////////////////////////////////
+
+ui_widget_handle_t ui_widget_create(ui_widget_type_t type, ui_widget_handle_t parent, ui_draw_priority_t priority)
+{
+    assert(priority >= ui_draw_priority_0 && priority < ui_draw_num_priorities);
+
+    ui_widget *w = allocate_widget(type, parent, priority);
+    if(w == nullptr) {
+        LOG_E("Out of widgets");
+    }
+    return w;
+}
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_init()
+esp_err_t ui_widget_destroy(ui_widget_handle_t widget)
 {
-    init_draw_items_pool();
+    if(widget == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    destroy_widget(widget);
+
+    // anything in the same list moves up
+    widgets_changed = true;
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-ui_draw_item_handle_t ui_add_item(ui_draw_priority_t priority, ui_draw_function_t draw_function)
+esp_err_t ui_widget_set_pos(ui_widget_handle_t widget, vec2i const *pos)
 {
-    assert(priority >= ui_draw_priority_0 && priority < ui_draw_num_priorities);
-    assert(draw_function != nullptr);
+    if(widget == nullptr || pos == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(widget->pos.x != pos->x || widget->pos.y != pos->y) {
+        widget->pos = *pos;
+        mark_dirty(widget, false);
+    }
+    return ESP_OK;
+}
 
-    ui_draw_item_handle_t new_item = allocate_draw_item(priority);
-    if(new_item != nullptr) {
-        new_item->draw_function = draw_function;
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_widget_set_flags(ui_widget_handle_t widget, ui_draw_item_flags flags)
+{
+    if(widget == nullptr) {
+        return ESP_ERR_INVALID_ARG;
     }
-    return new_item;
+    if((widget->flags | flags) != widget->flags) {
+        widget->flags |= flags;
+        mark_dirty(widget, false);
+    }
+    return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_remove_item(ui_draw_item_handle_t item)
+esp_err_t ui_widget_clear_flags(ui_widget_handle_t widget, ui_draw_item_flags flags)
 {
-    if(item == nullptr) {
+    if(widget == nullptr) {
         return ESP_ERR_INVALID_ARG;
     }
-    free_draw_item(item);
+    if((widget->flags & flags) != 0) {
+        widget->flags &= ~flags;
+        mark_dirty(widget, false);
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_item_change_priority(ui_draw_item_handle_t item, ui_draw_priority new_priority)
+esp_err_t ui_widget_get_bounds(ui_widget_handle_t widget, vec2i *pos, vec2i *size)
 {
-    if(item == nullptr) {
+    if(widget == nullptr || pos == nullptr || size == nullptr) {
         return ESP_ERR_INVALID_ARG;
     }
-    if(new_priority == item->priority) {
+    *pos = vec2i{ widget->bounds.x0, widget->bounds.y0 };
+    *size = vec2i{ widget->bounds.x1 - widget->bounds.x0, widget->bounds.y1 - widget->bounds.y0 };
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+// setting it to what it already is doesn't redraw anything, so it can be set every frame
+
+esp_err_t ui_label_set_text(ui_widget_handle_t label, font_handle_t font, char const *text)
+{
+    if(!widget_is(label, ui_widget_label) || text == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(font == label->label.font && strncmp(text, label->label.text, UI_LABEL_MAX_TEXT - 1) == 0) {
         return ESP_OK;
     }
-    live_draw_items[item->priority].remove(item);
-    item->priority = new_priority;
-    live_draw_items[new_priority].push_back(item);
+    label->label.font = font;
+    strncpy(label->label.text, text, UI_LABEL_MAX_TEXT - 1);
+    label->label.text[UI_LABEL_MAX_TEXT - 1] = 0;
+    mark_dirty(label, true);
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_item_get_flags(ui_draw_item_handle_t item, ui_draw_item_flags *flags)
+esp_err_t ui_label_set_color(ui_widget_handle_t label, uint32_t color, uint8_t blendmode)
 {
-    if(item == nullptr || flags == nullptr) {
+    if(!widget_is(label, ui_widget_label)) {
         return ESP_ERR_INVALID_ARG;
     }
-    *flags = static_cast<ui_draw_item_flags>(item->flags);
+    if(color != label->color || blendmode != label->blendmode) {
+        label->color = color;
+        label->blendmode = blendmode;
+        mark_dirty(label, false);
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_item_set_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+esp_err_t ui_image_set(ui_widget_handle_t image, uint8_t image_id, uint8_t alpha, uint8_t blendmode)
 {
-    if(item == nullptr) {
+    if(!widget_is(image, ui_widget_image)) {
         return ESP_ERR_INVALID_ARG;
     }
-    item->flags |= flags;
+    if(image_id != image->image.image_id || alpha != image->image.alpha || blendmode != image->blendmode) {
+        bool measure = image_id != image->image.image_id;
+        image->image.image_id = image_id;
+        image->image.alpha = alpha;
+        image->blendmode = blendmode;
+        mark_dirty(image, measure);
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_item_clear_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+esp_err_t ui_arc_set_radius(ui_widget_handle_t arc, float inner_radius, float outer_radius)
 {
-    if(item == nullptr) {
+    if(!widget_is(arc, ui_widget_arc)) {
         return ESP_ERR_INVALID_ARG;
     }
-    item->flags &= ~flags;
+    if(inner_radius != arc->arc.inner_radius || outer_radius != arc->arc.outer_radius) {
+        arc->arc.inner_radius = inner_radius;
+        arc->arc.outer_radius = outer_radius;
+        mark_dirty(arc, true);
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-esp_err_t ui_item_toggle_flags(ui_draw_item_handle_t item, ui_draw_item_flags flags)
+esp_err_t ui_arc_set_angles(ui_widget_handle_t arc, float start_angle, float end_angle)
 {
-    if(item == nullptr) {
+    if(!widget_is(arc, ui_widget_arc)) {
         return ESP_ERR_INVALID_ARG;
     }
-    item->flags ^= flags;
+    if(start_angle != arc->arc.start_angle || end_angle != arc->arc.end_angle) {
+        arc->arc.start_angle = start_angle;
+        arc->arc.end_angle = end_angle;
+        mark_dirty(arc, true);
+    }
     return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
 
-void ui_draw(int frame)
+esp_err_t ui_arc_set_color(ui_widget_handle_t arc, uint32_t color, uint8_t blendmode)
 {
-    for(auto &l : live_draw_items) {
-        for(auto *d = l.head(); d != l.done(); d = l.next(d)) {
-            if((d->flags & uif_hidden) == 0) {
-                d->draw_function(frame);
-            }
-        }
+    if(!widget_is(arc, ui_widget_arc)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(color != arc->color || blendmode != arc->blendmode) {
+        arc->color = color;
+        arc->blendmode = blendmode;
+        mark_dirty(arc, false);
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_list_set_spacing(ui_widget_handle_t list, int spacing)
+{
+    if(!widget_is(list, ui_widget_list)) {
+        return ESP_ERR_INVALID_ARG;
     }
+    if(spacing != list->list.spacing) {
+        list->list.spacing = spacing;
+        mark_dirty(list, false);
+    }
+    return ESP_OK;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -216,3 +1347,201 @@ ui_input_handler ui_get_current_handler()
     }
     return h;
 }
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_scroll_list_set_view(ui_widget_handle_t list, vec2i const *size, int row_height, font_handle_t font)
+{
+    if(!widget_is(list, ui_widget_scroll_list) || size == nullptr || row_height <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    destroy_scroll_list_rows(list);
+
+    // all the rows it can need are put aside now, so they can't run out while it scrolls
+    int rows = scroll_list_max_rows(*size, row_height);
+    int available = num_free_widgets - reserved_widgets + list->scroll.reserved;
+
+    if(rows > available) {
+        LOG_E("Not enough widgets for %d scroll list rows (%d free)", rows, available);
+        return ESP_ERR_NO_MEM;
+    }
+    reserved_widgets += rows - list->scroll.reserved;
+    list->scroll.reserved = rows;
+
+    list->scroll.view = *size;
+    list->scroll.row_height = row_height;
+    list->scroll.font = font;
+    list->scroll.position = (float)(list->scroll.selected * row_height);
+    list->scroll.velocity = 0;
+    mark_dirty(list, true);
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_scroll_list_set_colors(ui_widget_handle_t list, uint32_t color, uint32_t selected_color, uint8_t blendmode)
+{
+    if(!widget_is(list, ui_widget_scroll_list)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    list->color = color;
+    list->scroll.selected_color = selected_color;
+    list->blendmode = blendmode;
+
+    for(ui_widget *r = list->children.head(); r != list->children.done(); r = list->children.next(r)) {
+        r->blendmode = blendmode;
+        mark_dirty(r, false);
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_scroll_list_set_items(ui_widget_handle_t list, int count, ui_scroll_list_fetch_function fetch, void *context)
+{
+    if(!widget_is(list, ui_widget_scroll_list) || count < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    destroy_scroll_list_rows(list);
+    list->scroll.count = count;
+    list->scroll.fetch = fetch;
+    list->scroll.context = context;
+    return ui_scroll_list_set_selected(list, min(list->scroll.selected, max(0, count - 1)), false);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_scroll_list_scroll(ui_widget_handle_t list, int detents)
+{
+    if(!widget_is(list, ui_widget_scroll_list)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    if(now - list->scroll.last_input_us < scroll_fast_us) {
+        list->scroll.speed = min(list->scroll.speed + 1, scroll_max_speed);
+    } else {
+        list->scroll.speed = 1;
+    }
+    list->scroll.last_input_us = now;
+
+    int selected = max(0, min(list->scroll.selected + detents * list->scroll.speed, list->scroll.count - 1));
+
+    if(selected != list->scroll.selected) {
+
+        // it may have been still for a while
+        if(list->scroll.position == (float)(list->scroll.selected * list->scroll.row_height) && list->scroll.velocity == 0) {
+            list->scroll.last_time_us = now;
+        }
+        list->scroll.selected = selected;
+        widgets_changed = true;
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_scroll_list_set_selected(ui_widget_handle_t list, int index, bool animate)
+{
+    if(!widget_is(list, ui_widget_scroll_list) || index < 0 || (index >= list->scroll.count && index != 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if(!animate) {
+        list->scroll.position = (float)(index * list->scroll.row_height);
+        list->scroll.velocity = 0;
+    } else if(index != list->scroll.selected) {
+        list->scroll.last_time_us = esp_timer_get_time();
+    }
+    list->scroll.selected = index;
+    widgets_changed = true;
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+int ui_scroll_list_get_selected(ui_widget_handle_t list)
+{
+    if(!widget_is(list, ui_widget_scroll_list)) {
+        return -1;
+    }
+    return list->scroll.selected;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+esp_err_t ui_post_event(ui_event_type_t type, uint32_t value)
+{
+    if(event_queue == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ui_event_t event = { type, value };
+    if(xQueueSend(event_queue, &event, 0) != pdTRUE) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void ui_run(int max_fps)
+{
+    assert(event_set != nullptr);
+    assert(max_fps > 0);
+
+    int64_t frame_interval_us = 1000000 / max_fps;
+    int64_t last_frame_us = esp_timer_get_time() - frame_interval_us;
+    bool frame_pending = false;
+    int frame = 0;
+
+    while(true) {
+
+        QueueSetMemberHandle_t member = xQueueSelectFromSet(event_set, portMAX_DELAY);
+
+        ui_event_t event;
+
+        if(member == encoder_queue) {
+
+            encoder_message_t msg;
+            if(encoder_get_message(ui_encoder, &msg) == ESP_OK) {
+                event.type = ui_event_encoder;
+                event.value = msg;
+                dispatch_event(&event);
+            }
+
+        } else if(member == event_queue) {
+
+            if(xQueueReceive(event_queue, &event, 0) == pdTRUE) {
+                dispatch_event(&event);
+            }
+
+        } else if(member == frame_semaphore) {
+
+            xSemaphoreTake(frame_semaphore, 0);
+            frame_pending = false;
+        }
+
+        // handle everything which has come in before drawing any of it
+        if(frame_pending || uxQueueMessagesWaiting(event_set) != 0 || !ui_needs_draw()) {
+            continue;
+        }
+
+        int64_t wait_us = last_frame_us + frame_interval_us - esp_timer_get_time();
+
+        if(wait_us > 0) {
+            esp_timer_start_once(frame_timer, wait_us);
+            frame_pending = true;
+            continue;
+        }
+
+        last_frame_us = esp_timer_get_time();
+        draw_frame(frame);
+        frame += 1;
+
+        // animating, so wake up for the next one
+        if(ui_needs_draw()) {
+            esp_timer_start_once(frame_timer, frame_interval_us);
+            frame_pending = true;
+        }
+    }
+}
@@ -4,6 +4,9 @@
 static_assert(false && "list.h is c++ only");
 #endif
 
+#include <stddef.h>
+#include <type_traits>
+
 #define NULL_NODE (list_node<T> T::*)nullptr != NODE
 
 namespace chs
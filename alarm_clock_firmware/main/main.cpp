@@ -11,6 +11,8 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
 
 #include <driver/gpio.h>
 #include <driver/spi_master.h>
@@ -44,16 +46,26 @@ namespace
 {
     int constexpr UI_FPS = 30;
 
+    // ui_event_timer values
+    uint32_t constexpr CLOCK_TIMER = 0;
+
     TaskHandle_t main_ui_task_handle;
-    EventGroupHandle_t frame_timer_event_group_handle;
     encoder_handle_t encoder_handle;
-    int frame = 0;
 
     float rotation = 0;
     float rotation_vel = 0;
 
     int volume = 0x40;
 
+    // the clock face, pressing the encoder swaps between it and the globe
+
+    ui_draw_item_handle_t globe_item;
+
+    ui_widget_handle_t clock_ticks[12];
+    ui_widget_handle_t clock_seconds;
+    ui_widget_handle_t clock_time;
+    bool clock_showing = false;
+
 }    // namespace
 
 //////////////////////////////////////////////////////////////////////
@@ -69,6 +81,7 @@ void play_file(void *)
     LOG_I("Play song %u bytes", boing_mp3_size);
 
     if(audio_play() == ESP_OK) {
+        ui_post_event(ui_event_audio, 1);
         while(remain != 0) {
             uint8_t *buffer;
             size_t fragment = min(2048u, remain);
@@ -87,6 +100,7 @@ void play_file(void *)
         LOG_I("Play song complete");
         audio_stop();
         audio_wait_for_sound_complete(portMAX_DELAY);
+        ui_post_event(ui_event_audio, 0);
     }
 
     vTaskDelete(nullptr);
@@ -148,22 +162,100 @@ ui_draw_item_handle_t ui_item_time;
 unsigned seconds = 0;
 int alpha = 255;
 
-ui_input_handler_status ui_handler(int frame)
+//////////////////////////////////////////////////////////////////////
+// just the seconds arc and the time change, so with nothing else showing a tick only redraws those
+
+void update_clock()
+{
+    char time[7];
+    snprintf(time, sizeof(time), "23:%02u", seconds);
+
+    ui_label_set_text(clock_time, digits_font, time);
+
+    vec2i size;
+    if(font_measure_string(digits_font, (uint8_t const *)time, &size) == ESP_OK) {
+        vec2i pos = { (LCD_WIDTH - size.x) / 2, (LCD_HEIGHT - size.y) / 2 };
+        ui_widget_set_pos(clock_time, &pos);
+    }
+
+    ui_arc_set_angles(clock_seconds, 0, (float)(seconds + 1) * M_TWOPI / 60.0f);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void create_clock()
 {
-    encoder_message_t msg;
+    vec2i centre = { LCD_WIDTH / 2, LCD_HEIGHT / 2 };
+
+    for(size_t i = 0; i < countof(clock_ticks); ++i) {
+        float t = (float)i * M_TWOPI / countof(clock_ticks);
+        ui_widget_handle_t tick = ui_widget_create(ui_widget_arc, nullptr, ui_draw_priority_0);
+        ui_widget_set_pos(tick, &centre);
+        ui_arc_set_radius(tick, 100, 108);
+        ui_arc_set_angles(tick, t - 0.03f, t + 0.03f);
+        ui_arc_set_color(tick, 0xc0ffffff, blend_add);
+        clock_ticks[i] = tick;
+    }
+
+    clock_seconds = ui_widget_create(ui_widget_arc, nullptr, ui_draw_priority_0);
+    ui_widget_set_pos(clock_seconds, &centre);
+    ui_arc_set_radius(clock_seconds, 110, 118);
+    ui_arc_set_color(clock_seconds, 0xff40a0ff, blend_add);
+
+    clock_time = ui_widget_create(ui_widget_label, nullptr, ui_draw_priority_0);
+    ui_label_set_color(clock_time, COLOR_WHITE, blend_opaque);
+
+    for(ui_widget_handle_t w : clock_ticks) {
+        ui_widget_set_flags(w, uif_hidden);
+    }
+    ui_widget_set_flags(clock_seconds, uif_hidden);
+    ui_widget_set_flags(clock_time, uif_hidden);
+}
+
+//////////////////////////////////////////////////////////////////////
+// the globe is a draw item, so everything's drawn every frame while it's showing
 
-    if((frame & 7) == 0) {
-        seconds = (seconds + 1) % 60;
+void show_clock(bool show)
+{
+    clock_showing = show;
+
+    auto set_hidden = [](ui_widget_handle_t w, bool hidden) {
+        if(hidden) {
+            ui_widget_set_flags(w, uif_hidden);
+        } else {
+            ui_widget_clear_flags(w, uif_hidden);
+        }
+    };
+
+    for(ui_widget_handle_t w : clock_ticks) {
+        set_hidden(w, !show);
     }
+    set_hidden(clock_seconds, !show);
+    set_hidden(clock_time, !show);
+
+    if(show) {
+        update_clock();
+        ui_item_set_flags(globe_item, uif_hidden);
+    } else {
+        ui_item_clear_flags(globe_item, uif_hidden);
+    }
+
+    // the widgets only redraw what changed over an opaque clear color, the globe covers it all anyway
+    ui_set_clear_color(show ? COLOR_BLACK : 0);
+}
+
+ui_input_handler_status ui_handler(ui_event_t const *event)
+{
+    switch(event->type) {
 
-    while(encoder_get_message(encoder_handle, &msg) == ESP_OK) {
+    case ui_event_encoder:
 
-        switch(msg) {
+        switch(event->value) {
 
         case ENCODER_MSG_PRESS: {
             size_t free_space = heap_caps_get_free_size(MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
             LOG_I("Free space: %u (%uKB)", free_space, free_space / 1024);
-            ui_item_toggle_flags(ui_item_time, uif_hidden);
+            show_clock(!clock_showing);
         } break;
 
         case ENCODER_MSG_RELEASE:
@@ -174,6 +266,7 @@ ui_input_handler_status ui_handler(int frame)
             rotation_vel += 2;
             volume = max(1, volume - 1);
             audio_set_volume((uint8_t)volume);
+            ui_request_frame();
             break;
 
         case ENCODER_MSG_ROTATE_CCW:
@@ -181,11 +274,34 @@ ui_input_handler_status ui_handler(int frame)
             rotation_vel -= 2;
             volume = min(255, volume + 1);
             audio_set_volume((uint8_t)volume);
+            ui_request_frame();
             break;
 
         default:
             break;
         }
+        break;
+
+    // only worth a frame if the time is showing
+    case ui_event_timer:
+        if(event->value == CLOCK_TIMER) {
+            seconds = (seconds + 1) % 60;
+            if(ui_item_time != nullptr) {
+                ui_request_frame();
+            }
+            if(clock_showing) {
+                update_clock();
+            }
+        }
+        break;
+
+    case ui_event_network:
+        LOG_I("Network %s", event->value ? "connected" : "disconnected");
+        break;
+
+    case ui_event_audio:
+        LOG_I("Audio %s", event->value ? "playing" : "stopped");
+        break;
     }
     return ui_input_handler_keep;
 }
@@ -212,27 +328,50 @@ void draw_face(int frame)
     vec2i dst_pos = { x, y };
     vec2f pivot = { 0.5f, 0.5f };
     display_image(&dst_pos, image_id_face, alpha, blend_multiply, &pivot);
+
+    ui_request_frame();
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void draw_time(int frame)
 {
-    font_handle_t f = digits_font;
+    static unsigned last_seconds = 60;
+    static int tick_frame = 0;
+
+    if(seconds != last_seconds) {
+        last_seconds = seconds;
+        tick_frame = frame;
+    }
 
     char time[7];
     snprintf(time, 7, "23:%02d", seconds);
 
     uint8_t const *text = (uint8_t const *)time;
-    vec2i text_size;
 
-    font_measure_string(f, text, &text_size);
+    // the distance field font scales smoothly so pop it a little on each tick
+    float pulse = max(0.0f, 1.0f - (frame - tick_frame) / 8.0f);
+    float size = 56.0f + pulse * pulse * 8.0f;
 
-    int x = LCD_WIDTH / 2;
-    int y = LCD_HEIGHT / 2;
+    if(pulse > 0) {
+        ui_request_frame();
+    }
 
-    vec2i text_pos = { x - text_size.x / 2, y - text_size.y / 2 };
-    font_drawtext(f, &text_pos, text, 255, blend_multiply);
+    vec2f text_size;
+
+    if(font_measure_string_sdf(digits_sdf_font, text, size, &text_size) != ESP_OK) {
+        return;
+    }
+
+    display_sdf_style style = {};
+    style.color = 0xffffffff;
+    style.outline_color = 0xff000000;
+    style.glow_color = 0x8000c0ff;
+    style.outline_width = 1.5f;
+    style.glow_width = 3.0f;
+
+    vec2f text_pos = { (LCD_WIDTH - text_size.x) / 2, (LCD_HEIGHT - text_size.y) / 2 };
+    font_drawtext_sdf(digits_sdf_font, &text_pos, text, size, &style);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -245,7 +384,9 @@ void draw_text(int frame)
 
     vec2i text_size;
 
-    font_measure_string(f, text, &text_size);
+    if(font_measure_string(f, text, &text_size) != ESP_OK) {
+        return;
+    }
 
     float speed = 0.05f;
     float t = frame * speed;
@@ -254,118 +395,199 @@ void draw_text(int frame)
     int y = (int)(cosf(t) * 100) + 120;
 
     vec2i text_pos = { x - text_size.x / 2, y - text_size.y / 2 };
-    font_drawtext(f, &text_pos, text, 255, blend_multiply);
+    font_drawtext(f, &text_pos, text, COLOR_WHITE, blend_multiply);
+
+    ui_request_frame();
 }
 
 //////////////////////////////////////////////////////////////////////
 
 void draw_seconds(int frame)
 {
-    image_t const *src_img = image_get(image_id_blip);
-    for(int i = 0; i <= seconds; ++i) {
-        float t = (float)i * M_TWOPI / 60.0f;
-        float x = sinf(t) * 114 + 120;
-        float y = 120 - cosf(t) * 114;
-        vec2i src_pos = { 0, 0 };
-        vec2i size = { src_img->width, src_img->height };
-        vec2i dst_pos = { (int)x, (int)y };
-        dst_pos.x -= size.x / 2;
-        dst_pos.y -= size.y / 2;
-        display_imagerect(&dst_pos, &src_pos, &size, image_id_blip, 0xff, blend_add);
-    }
+    vec2f centre = { 120, 120 };
+
+    display_circle(&centre, 118, 1.5f, 0x60ffffff, blend_add);
+    display_arc(&centre, 110, 118, 0, (float)(seconds + 1) * M_TWOPI / 60.0f, 0xff40a0ff, blend_add);
 
-    src_img = image_get(image_id_small_blip);
     for(int i = 0; i < 60; i += 5) {
         float t = (float)i * M_TWOPI / 60.0f;
-        float x = sinf(t) * 104 + 120;
-        float y = 120 - cosf(t) * 104;
-        vec2i src_pos = { 0, 0 };
-        vec2i size = { src_img->width, src_img->height };
-        vec2i dst_pos = { (int)x, (int)y };
-        dst_pos.x -= size.x / 2;
-        dst_pos.y -= size.y / 2;
-        display_imagerect(&dst_pos, &src_pos, &size, image_id_small_blip, 0xff, blend_add);
+        vec2f pos = { sinf(t) * 104 + 120, 120 - cosf(t) * 104 };
+        display_circle(&pos, 2.5f, 0, 0xc0ffffff, blend_add);
     }
 }
 
 //////////////////////////////////////////////////////////////////////
 
-void IRAM_ATTR frame_on_timer(void *)
+void draw_hands(int frame)
 {
-    xEventGroupSetBits(frame_timer_event_group_handle, 1);
+    // 23:ss like draw_time, the second hand sweeps round once a second
+    float minutes = (float)seconds;
+    float hours = 11.0f + minutes / 60.0f;
+    float sweep = (float)(esp_timer_get_time() % 1000000) / 1000000.0f;
+
+    vec2f centre = { 120, 120 };
+
+    auto hand = [&](float turns, float length, float width, uint32_t color) {
+        float t = turns * M_TWOPI;
+        vec2f end = { centre.x + sinf(t) * length, centre.y - cosf(t) * length };
+        display_line(&centre, &end, width, color, blend_opaque);
+    };
+
+    hand(hours / 12.0f, 60, 7, COLOR_WHITE);
+    hand(minutes / 60.0f, 95, 4, COLOR_WHITE);
+    hand(sweep, 105, 1.5f, 0xffff4040);
+
+    display_circle(&centre, 5, 0, 0xffff4040, blend_opaque);
+
+    ui_request_frame();
 }
 
 //////////////////////////////////////////////////////////////////////
+// spins while the encoder has it going and stops asking for frames once it stops
 
-void main_ui_task(void *)
+void draw_globe(int frame)
 {
-    // encoder setup
-    encoder_config_t encoder_config = {};
-    encoder_config.gpio_a = GPIO_NUM_1;
-    encoder_config.gpio_b = GPIO_NUM_2;
-    encoder_config.gpio_button = GPIO_NUM_42;
-    ESP_ERROR_CHECK(encoder_init(&encoder_config, &encoder_handle));
+    rotation += rotation_vel;
+
+    while(rotation < 0) {
+        rotation += 480.0f;
+    }
+
+    while(rotation >= 480.0f) {
+        rotation -= 480.0f;
+    }
+
+    rotation_vel *= 0.9f;
+
+    if(fabsf(rotation_vel) > 0.05f) {
+        ui_request_frame();
+    } else {
+        rotation_vel = 0;
+    }
+
+    display_sphere((int)rotation, image_id_world, 255, blend_opaque);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+#if CONFIG_DISPLAY_SECTION_BENCHMARK || CONFIG_DISPLAY_BACKEND_BENCHMARK
 
-    ui_init();
+void draw_globe_scene(int frame)
+{
+    display_sphere(frame * 2 % 480, image_id_world, 255, blend_opaque);
+    draw_time(frame);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void draw_text_scene(int frame)
+{
+    vec2i pos = { 0, 0 };
+    vec2i size = { LCD_WIDTH, LCD_HEIGHT };
+    display_fillrect(&pos, &size, COLOR_BLACK, blend_opaque);
+    draw_time(frame);
+    draw_text(frame);
+}
 
-    frame_timer_event_group_handle = xEventGroupCreate();
+//////////////////////////////////////////////////////////////////////
+// just the clock changes, the framebuffer only needs that band redrawing
+
+void draw_clock_scene(int frame)
+{
+    vec2i pos = { 0, 80 };
+    vec2i size = { LCD_WIDTH, 80 };
+    display_fillrect(&pos, &size, COLOR_BLACK, blend_opaque);
+    draw_time(frame);
+}
 
-    // setup the screen redraw timer
+#endif
 
-    esp_timer_handle_t ui_timer_handle;
+//////////////////////////////////////////////////////////////////////
+
+void clock_on_timer(void *)
+{
+    ui_post_event(ui_event_timer, CLOCK_TIMER);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void on_network_event(void *, esp_event_base_t event_base, int32_t event_id, void *)
+{
+    if(event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ui_post_event(ui_event_network, 1);
+    } else if(event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        ui_post_event(ui_event_network, 0);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void main_ui_task(void *)
+{
+    // the clock ticks by event, nothing wakes the ui up otherwise
+
+    esp_timer_handle_t clock_timer_handle;
     {
-        esp_timer_create_args_t ui_timer_args = {};
-        ui_timer_args.callback = frame_on_timer;
-        ui_timer_args.dispatch_method = ESP_TIMER_TASK;
-        ui_timer_args.skip_unhandled_events = false;
-        ESP_ERROR_CHECK(esp_timer_create(&ui_timer_args, &ui_timer_handle));
-        esp_timer_start_periodic(ui_timer_handle, 1000000 / UI_FPS);
+        esp_timer_create_args_t clock_timer_args = {};
+        clock_timer_args.callback = clock_on_timer;
+        clock_timer_args.dispatch_method = ESP_TIMER_TASK;
+        clock_timer_args.skip_unhandled_events = true;
+        ESP_ERROR_CHECK(esp_timer_create(&clock_timer_args, &clock_timer_handle));
+        esp_timer_start_periodic(clock_timer_handle, 1000000);
     }
 
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, on_network_event, nullptr));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, on_network_event, nullptr));
+
     // ui_add_item(ui_draw_priority_0, draw_cls);
     // ui_add_item(ui_draw_priority_0, draw_seconds);
+    // ui_add_item(ui_draw_priority_0, draw_hands);
     // ui_add_item(ui_draw_priority_0, draw_text);
 
     // ui_item_time = ui_add_item(ui_draw_priority_7, draw_time);
 
-    // ui_add_item(ui_draw_priority_6, draw_face);
+    // ui_add_item(ui_draw_priority_6, draw_face);    // and image_acquire(image_id_face) once it's loaded
+
+    globe_item = ui_add_item(ui_draw_priority_0, draw_globe);
 
     ui_push_input_handler(ui_handler);
 
-    // main UI loop - handle encoder messages and draw all the things
+    // everything else carries on loading in the background
 
-    while(true) {
+    ESP_ERROR_CHECK(assets_wait_for_first_frame(portMAX_DELAY));
 
-        xEventGroupWaitBits(frame_timer_event_group_handle, 1, pdTRUE, pdFALSE, portMAX_DELAY);
+    // the globe is drawn every frame, hold a reference so the image cache can't evict it
 
-        ui_input_handler current_handler = ui_get_current_handler();
+    ESP_ERROR_CHECK(image_acquire(image_id_world, nullptr));
 
-        if(current_handler != nullptr && current_handler(frame) == ui_input_handler_pop) {
-            ui_pop_current_handler();
-        }
+    create_clock();
 
-        display_begin_frame();
+#if CONFIG_DISPLAY_SECTION_BENCHMARK
+    ESP_ERROR_CHECK(assets_wait(asset_id_forte_font, portMAX_DELAY));
 
-        // ui_draw(frame);
+    LOG_I("Globe scene");
+    display_benchmark_sections(draw_globe_scene, CONFIG_DISPLAY_SECTION_BENCHMARK_FRAMES);
 
-        rotation += rotation_vel;
+    LOG_I("Text scene");
+    display_benchmark_sections(draw_text_scene, CONFIG_DISPLAY_SECTION_BENCHMARK_FRAMES);
+#endif
 
-        while(rotation < 0) {
-            rotation += 480.0f;
-        }
+#if CONFIG_DISPLAY_BACKEND_BENCHMARK
+    ESP_ERROR_CHECK(assets_wait(asset_id_forte_font, portMAX_DELAY));
 
-        while(rotation >= 480.0f) {
-            rotation -= 480.0f;
-        }
+    LOG_I("Globe scene");
+    display_benchmark_backends(draw_globe_scene, CONFIG_DISPLAY_BACKEND_BENCHMARK_FRAMES);
 
-        rotation_vel *= 0.9f;
+    LOG_I("Text scene");
+    display_benchmark_backends(draw_text_scene, CONFIG_DISPLAY_BACKEND_BENCHMARK_FRAMES);
 
-        display_sphere((int)rotation, image_id_world, 255, blend_opaque);
+    LOG_I("Clock scene");
+    display_benchmark_backends(draw_clock_scene, CONFIG_DISPLAY_BACKEND_BENCHMARK_FRAMES);
+#endif
 
-        display_end_frame();
+    // main UI loop - handle events as they come and draw a frame when anything changed
 
-        frame += 1;
-    }
+    ui_run(UI_FPS);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -379,6 +601,9 @@ extern "C" void app_main(void)
     led_init();
     led_set_off();
 
+    // the panel resets and inits in the background, first so that overlaps everything else
+    display_init();
+
     esp_err_t err = nvs_flash_init();
     if(err == ESP_ERR_NVS_NO_FREE_PAGES || ERASE_FLASH) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -389,26 +614,28 @@ extern "C" void app_main(void)
     image_init();
     audio_init();
     assets_init();
-    display_init();
     wifi_init();
 
     LOG_I("Audio init complete");
 
     audio_wait_for_initialization_complete(portMAX_DELAY);
 
+    // encoder setup
+    encoder_config_t encoder_config = {};
+    encoder_config.gpio_a = GPIO_NUM_1;
+    encoder_config.gpio_b = GPIO_NUM_2;
+    encoder_config.gpio_button = GPIO_NUM_42;
+    ESP_ERROR_CHECK(encoder_init(&encoder_config, &encoder_handle));
+
+    // the ui's event queue has to exist before anything posts to it
+    ESP_ERROR_CHECK(ui_init(encoder_handle));
+
     xTaskCreatePinnedToCore(play_file, "play_file", 3072, nullptr, 15, nullptr, 1);
 
     xTaskCreatePinnedToCore(main_ui_task, "main_ui", 4096, NULL, 15, &main_ui_task_handle, 1);
 
-    int64_t t = esp_timer_get_time();
-    int64_t now;
-    int64_t fade_time_uS = 2000000ll;
-
-    while((now = esp_timer_get_time() - t) <= fade_time_uS) {
-        uint32_t b = min(8191lu, (uint32_t)(now * 9500 / fade_time_uS));
-        lcd_set_backlight(b);
-        vTaskDelay(1);
-    }
+    // the LEDC hardware does the fade, carry on with wifi meanwhile
+    lcd_fade_backlight(255, 2000, nullptr, nullptr);
 
     xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_EVENT, pdFALSE, pdTRUE, portMAX_DELAY);
 
@@ -0,0 +1,969 @@
+//////////////////////////////////////////////////////////////////////
+// Pack PNGs and .bitmapfont files into an asset pack (see asset_pack_format.h)
+// Pixels are stored close to display ready (RGB565 with or without an alpha byte, or A4/A8 for
+// tinted fonts) so the firmware only has to decompress them, no PNG decode at boot.
+//
+// asset_compiler [-c auto|none|rle|lz4] [-alpha a4|a8|off] [-color rgb565|off] [-sdf-scale n] [-sdf-spread n] -o output.pack [-sdf] inputs...
+//
+// The asset name is the file name without the extension, a font's atlas
+// is the <name>0.png next to its .bitmapfont. -sdf before a .bitmapfont
+// packs it as an A8 signed distance field font called <name>_sdf instead,
+// the atlas is shrunk by -sdf-scale and distances go out to -sdf-spread pixels.
+//
+// Fonts with a plain grey atlas only need coverage, they're packed as -alpha
+// (A4 by default) and tinted when drawn. Coloured or outlined ones stay ARGB32.
+//
+// Everything else which is ARGB32 gets -color (RGB565 by default): opaque images
+// drop the alpha channel and the rest keep it as a byte after each pixel. The panel
+// is only 18 bits per pixel so there's not much to lose, and the pack ends up
+// smaller than the PNGs it came from. -color off keeps them ARGB32.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "pngle.h"
+#include "asset_pack_format.h"
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct image
+    {
+        std::vector<uint32_t> pixels;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct vec2
+    {
+        int x;
+        int y;
+    };
+
+    struct font_tables
+    {
+        int height = 0;
+        int sdf_spread = 0;
+        std::vector<font_glyph> glyphs;
+        std::vector<font_graphic> graphics;
+        std::vector<font_kerning> kerning;
+    };
+
+    struct asset
+    {
+        std::string name;
+        asset_pack_type_t type;
+        asset_pack_pixel_format_t pixel_format = asset_pack_pixel_format_argb32;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;    // in pixel_format
+        size_t source_size;             // png bytes, for the report
+        std::vector<uint8_t> font;      // asset_pack_font and its tables
+        std::vector<uint8_t> packed;
+        asset_pack_compression_t compression;
+    };
+
+    int sdf_scale = 2;
+    int sdf_spread = 4;
+
+    // what plain grey font atlases are packed as, argb32 to leave them alone
+    asset_pack_pixel_format_t alpha_format = asset_pack_pixel_format_a4;
+
+    // whether colour images and atlases are squashed to RGB565 / ARGB8565
+    bool rgb565 = true;
+
+    // how far apart r, g and b can be for a pixel to count as grey
+    int const grey_tolerance = 8;
+
+    // atlases with more dark pixels than this have outlines or shadows which tinting would lose
+    int const max_dark_percent = 5;
+
+    char const *compression_names[] = { "none", "rle", "lz4" };
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool load_file(std::string const &filename, std::vector<uint8_t> &data)
+    {
+        FILE *f = fopen(filename.c_str(), "rb");
+        if(f == nullptr) {
+            return false;
+        }
+        fseek(f, 0, SEEK_END);
+        data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+        fclose(f);
+        return ok;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_init(pngle_t *pngle, uint32_t w, uint32_t h)
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        img->width = w;
+        img->height = h;
+        img->pixels.assign(w * h, 0);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void setpixel(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t, uint32_t, uint8_t rgba[4])
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        img->pixels[x + y * img->width] = (rgba[3] << 24) | (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_row(pngle_t *pngle, uint32_t y, uint32_t w, uint8_t const *rgba)
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        uint32_t *dst = img->pixels.data() + y * w;
+        for(uint32_t x = w; x != 0; --x) {
+            *dst++ = (rgba[3] << 24) | (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+            rgba += 4;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool decode_png(std::string const &filename, image &img, size_t &source_size)
+    {
+        std::vector<uint8_t> png;
+        if(!load_file(filename, png)) {
+            fprintf(stderr, "Can't load %s\n", filename.c_str());
+            return false;
+        }
+        source_size = png.size();
+
+        pngle_t *pngle = pngle_new();
+        pngle_set_user_data(pngle, &img);
+        pngle_set_init_callback(pngle, on_init);
+        pngle_set_draw_callback(pngle, setpixel);
+        pngle_set_row_callback(pngle, on_row);
+        int err = pngle_feed(pngle, png.data(), png.size());
+        if(err < 0) {
+            fprintf(stderr, "%s: %s\n", filename.c_str(), pngle_error(pngle));
+        }
+        pngle_destroy(pngle);
+
+        if(err >= 0 && (img.width > UINT16_MAX || img.height > UINT16_MAX)) {
+            fprintf(stderr, "%s: too big\n", filename.c_str());
+            return false;
+        }
+        return err >= 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // attributes are floats, rounded like FontParser does
+
+    bool get_attr(std::string const &element, char const *name, int &value)
+    {
+        std::regex re(std::string("\\b") + name + "=\"([^\"]*)\"");
+        std::smatch m;
+        if(!std::regex_search(element, m, re)) {
+            fprintf(stderr, "Missing attribute %s in %s\n", name, element.c_str());
+            return false;
+        }
+        value = (int)(strtof(m[1].str().c_str(), nullptr) + 0.5f);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // open addressed, at least twice as many slots as items so probes stay short
+
+    // the table size is stored in a uint16_t so it can be 32768 at most, which holds this many
+    size_t constexpr MAX_HASHED_ITEMS = 16384;
+
+    template <typename F> std::vector<uint16_t> make_hash_table(size_t count, F hash_of)
+    {
+        if(count == 0) {
+            return {};
+        }
+        size_t size = 1;
+        while(size < count * 2) {
+            size <<= 1;
+        }
+        std::vector<uint16_t> table(size, FONT_HASH_EMPTY);
+        for(size_t i = 0; i < count; ++i) {
+            size_t slot = hash_of(i) & (size - 1);
+            while(table[slot] != FONT_HASH_EMPTY) {
+                slot = (slot + 1) & (size - 1);
+            }
+            table[slot] = (uint16_t)i;
+        }
+        return table;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool parse_font(std::string const &filename, font_tables &font)
+    {
+        std::vector<uint8_t> data;
+        if(!load_file(filename, data)) {
+            fprintf(stderr, "Can't load %s\n", filename.c_str());
+            return false;
+        }
+        std::string xml(data.begin(), data.end());
+
+        std::smatch m;
+
+        if(!std::regex_search(xml, m, std::regex("<BitmapFont[^>]*>"))) {
+            fprintf(stderr, "%s: no BitmapFont element\n", filename.c_str());
+            return false;
+        }
+
+        if(!get_attr(m[0].str(), "Height", font.height)) {
+            return false;
+        }
+
+        std::vector<font_glyph> &glyphs = font.glyphs;
+        std::vector<font_graphic> &graphics = font.graphics;
+        std::vector<font_kerning> &kerning = font.kerning;
+
+        // <Glyph ...> <Graphic ... /> ... </Glyph> or <Glyph ... /> if it has no graphics
+
+        std::regex glyph_re("<Glyph\\b([^>]*?)(/>|>([\\s\\S]*?)</Glyph>)");
+        std::regex graphic_re("<Graphic\\b[^>]*>");
+
+        for(auto g = std::sregex_iterator(xml.begin(), xml.end(), glyph_re); g != std::sregex_iterator(); ++g) {
+
+            std::string glyph = (*g)[1].str();
+            std::string body = (*g)[3].str();
+
+            int c, images, advance;
+            if(!get_attr(glyph, "char", c) || !get_attr(glyph, "images", images) || !get_attr(glyph, "advance", advance)) {
+                return false;
+            }
+
+            if(c < 0 || c > 0x10ffff) {
+                fprintf(stderr, "%s: skipping char %d\n", filename.c_str(), c);
+                continue;
+            }
+
+            int graphic_base = (int)graphics.size();
+            int count = 0;
+
+            for(auto e = std::sregex_iterator(body.begin(), body.end(), graphic_re); e != std::sregex_iterator(); ++e) {
+
+                std::string element = (*e)[0].str();
+
+                int offset_x, offset_y, x, y, w, h, page;
+                if(!get_attr(element, "offsetX", offset_x) || !get_attr(element, "offsetY", offset_y) || !get_attr(element, "x", x) ||
+                   !get_attr(element, "y", y) || !get_attr(element, "w", w) || !get_attr(element, "h", h) || !get_attr(element, "page", page)) {
+                    return false;
+                }
+                if(page != 0) {
+                    fprintf(stderr, "%s: only single page fonts are supported\n", filename.c_str());
+                    return false;
+                }
+                graphics.push_back({ (int8_t)offset_x, (int8_t)offset_y, (uint8_t)x, (uint8_t)y, (uint8_t)w, (uint8_t)h });
+                count += 1;
+            }
+
+            if(count != images) {
+                fprintf(stderr, "%s: wrong number of graphics for glyph %d, expected %d, got %d\n", filename.c_str(), c, images, count);
+                return false;
+            }
+
+            glyphs.push_back({ (uint32_t)c, (int16_t)(count != 0 ? graphic_base : -1), (uint8_t)advance, 0 });
+        }
+
+        // optional <Kerning first="65" second="86" amount="-2" />
+
+        std::regex kerning_re("<Kerning\\b[^>]*>");
+
+        for(auto k = std::sregex_iterator(xml.begin(), xml.end(), kerning_re); k != std::sregex_iterator(); ++k) {
+            std::string element = (*k)[0].str();
+            int first, second, amount;
+            if(!get_attr(element, "first", first) || !get_attr(element, "second", second) || !get_attr(element, "amount", amount)) {
+                return false;
+            }
+            kerning.push_back({ (uint32_t)first, (uint32_t)second, (int16_t)amount, 0 });
+        }
+
+        auto glyph_less = [](font_glyph const &a, font_glyph const &b) { return a.codepoint < b.codepoint; };
+        auto kerning_less = [](font_kerning const &a, font_kerning const &b) {
+            return a.first < b.first || (a.first == b.first && a.second < b.second);
+        };
+
+        std::sort(glyphs.begin(), glyphs.end(), glyph_less);
+        std::sort(kerning.begin(), kerning.end(), kerning_less);
+
+        for(size_t i = 1; i < glyphs.size(); ++i) {
+            if(glyphs[i].codepoint == glyphs[i - 1].codepoint) {
+                fprintf(stderr, "%s: duplicate glyph %u\n", filename.c_str(), glyphs[i].codepoint);
+                return false;
+            }
+        }
+
+        if(glyphs.size() > MAX_HASHED_ITEMS || graphics.size() > INT16_MAX) {
+            fprintf(stderr, "%s: too many glyphs (%zu, max %zu)\n", filename.c_str(), glyphs.size(), MAX_HASHED_ITEMS);
+            return false;
+        }
+        if(kerning.size() > MAX_HASHED_ITEMS) {
+            fprintf(stderr, "%s: too many kerning pairs (%zu, max %zu)\n", filename.c_str(), kerning.size(), MAX_HASHED_ITEMS);
+            return false;
+        }
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void serialize_font(font_tables const &tables, std::vector<uint8_t> &out)
+    {
+        std::vector<font_glyph> const &glyphs = tables.glyphs;
+        std::vector<font_kerning> const &kerning = tables.kerning;
+        std::vector<font_graphic> const &graphics = tables.graphics;
+
+        std::vector<uint16_t> glyph_hash = make_hash_table(glyphs.size(), [&](size_t i) { return font_glyph_hash(glyphs[i].codepoint); });
+        std::vector<uint16_t> kerning_hash =
+            make_hash_table(kerning.size(), [&](size_t i) { return font_kerning_hash(kerning[i].first, kerning[i].second); });
+
+        asset_pack_font_t font = {};
+        font.height = (int16_t)tables.height;
+        font.num_graphics = (uint16_t)graphics.size();
+        font.num_glyphs = (uint16_t)glyphs.size();
+        font.num_kerning = (uint16_t)kerning.size();
+        font.glyph_hash_size = (uint16_t)glyph_hash.size();
+        font.kerning_hash_size = (uint16_t)kerning_hash.size();
+        font.sdf_spread = (uint16_t)tables.sdf_spread;
+
+        asset_pack_font_layout_t layout;
+        asset_pack_get_font_layout(&font, &layout);
+
+        out.assign(layout.size, 0);
+        memcpy(out.data(), &font, sizeof(font));
+        memcpy(out.data() + layout.glyphs, glyphs.data(), glyphs.size() * sizeof(font_glyph));
+        memcpy(out.data() + layout.kerning, kerning.data(), kerning.size() * sizeof(font_kerning));
+        memcpy(out.data() + layout.glyph_hash, glyph_hash.data(), glyph_hash.size() * sizeof(uint16_t));
+        memcpy(out.data() + layout.kerning_hash, kerning_hash.data(), kerning_hash.size() * sizeof(uint16_t));
+        memcpy(out.data() + layout.graphics, graphics.data(), graphics.size() * sizeof(font_graphic));
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // signed distance (in source pixels, positive inside) from the centre of each
+    // pixel of a coverage mask to the nearest pixel on the other side of the edge.
+    // Brute force out to max_distance, glyphs are small
+
+    std::vector<float> distance_field(std::vector<bool> const &inside, int w, int h, int max_distance)
+    {
+        std::vector<float> field(w * h);
+
+        for(int y = 0; y < h; ++y) {
+            for(int x = 0; x < w; ++x) {
+
+                bool in = inside[x + y * w];
+                int best = max_distance * max_distance * 2;
+
+                for(int dy = -max_distance; dy <= max_distance; ++dy) {
+                    int sy = y + dy;
+                    for(int dx = -max_distance; dx <= max_distance; ++dx) {
+                        int sx = x + dx;
+                        bool other = (sx < 0 || sy < 0 || sx >= w || sy >= h) ? false : inside[sx + sy * w];
+                        if(other != in) {
+                            best = std::min(best, dx * dx + dy * dy);
+                        }
+                    }
+                }
+
+                // the edge is half way between the two pixel centres
+                float d = std::min(sqrtf((float)best), (float)max_distance) - 0.5f;
+                field[x + y * w] = in ? d : -d;
+            }
+        }
+        return field;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // replace a coverage font with an A8 distance field font, each glyph gets
+    // `spread` pixels of padding and is shrunk by `scale`, then they're shelf packed
+    // into a new atlas (<= 256x256 because font_graphic coordinates are bytes)
+
+    bool make_sdf_font(std::string const &name, font_tables &font, image const &atlas, asset &a, int scale, int spread)
+    {
+        int pad = spread * scale;    // in source pixels
+
+        struct sdf_glyph
+        {
+            int index;
+            int width;
+            int height;
+            std::vector<uint8_t> pixels;
+        };
+
+        std::vector<sdf_glyph> glyphs;
+
+        for(size_t i = 0; i < font.graphics.size(); ++i) {
+
+            font_graphic const &g = font.graphics[i];
+
+            int sw = g.width + pad * 2;
+            int sh = g.height + pad * 2;
+
+            // only pixels inside the glyph's own rectangle count, the neighbours in the atlas mustn't bleed in
+
+            std::vector<bool> inside(sw * sh, false);
+            for(int y = 0; y < g.height; ++y) {
+                for(int x = 0; x < g.width; ++x) {
+                    uint32_t ax = g.x + x;
+                    uint32_t ay = g.y + y;
+                    if(ax < atlas.width && ay < atlas.height) {
+                        inside[(x + pad) + (y + pad) * sw] = (atlas.pixels[ax + ay * atlas.width] >> 24) >= 128;
+                    }
+                }
+            }
+
+            std::vector<float> field = distance_field(inside, sw, sh, pad + scale);
+
+            sdf_glyph out;
+            out.index = (int)i;
+            out.width = (sw + scale - 1) / scale;
+            out.height = (sh + scale - 1) / scale;
+            out.pixels.resize(out.width * out.height);
+
+            // average each scale x scale block then convert to output pixels
+
+            for(int y = 0; y < out.height; ++y) {
+                for(int x = 0; x < out.width; ++x) {
+                    float total = 0;
+                    int count = 0;
+                    for(int by = 0; by < scale; ++by) {
+                        for(int bx = 0; bx < scale; ++bx) {
+                            int sx = x * scale + bx;
+                            int sy = y * scale + by;
+                            if(sx < sw && sy < sh) {
+                                total += field[sx + sy * sw];
+                                count += 1;
+                            }
+                        }
+                    }
+                    float d = total / count / scale;
+                    int v = (int)lrintf(128 + d * 127 / spread);
+                    out.pixels[x + y * out.width] = (uint8_t)std::clamp(v, 0, 255);
+                }
+            }
+            glyphs.push_back(std::move(out));
+        }
+
+        // shelf pack, tallest first
+
+        std::vector<sdf_glyph *> order;
+        for(sdf_glyph &g : glyphs) {
+            order.push_back(&g);
+        }
+        std::sort(order.begin(), order.end(), [](sdf_glyph const *l, sdf_glyph const *r) { return l->height > r->height; });
+
+        int const atlas_width = 256;
+        int x = 0;
+        int y = 0;
+        int shelf_height = 0;
+
+        std::vector<vec2> positions(glyphs.size());
+
+        for(sdf_glyph *g : order) {
+            if(x + g->width > atlas_width) {
+                x = 0;
+                y += shelf_height;
+                shelf_height = 0;
+            }
+            positions[g->index] = { x, y };
+            x += g->width;
+            shelf_height = std::max(shelf_height, g->height);
+        }
+
+        int atlas_height = y + shelf_height;
+
+        if(atlas_height > 256) {
+            fprintf(stderr, "%s: SDF glyphs don't fit in 256x256, try a bigger -sdf-scale\n", name.c_str());
+            return false;
+        }
+
+        a.pixel_format = asset_pack_pixel_format_a8;
+        a.width = atlas_width;
+        a.height = atlas_height;
+        a.pixels.assign(atlas_width * atlas_height, 0);
+
+        for(sdf_glyph const &g : glyphs) {
+            vec2 p = positions[g.index];
+            for(int gy = 0; gy < g.height; ++gy) {
+                memcpy(a.pixels.data() + p.x + (p.y + gy) * atlas_width, g.pixels.data() + gy * g.width, g.width);
+            }
+            font_graphic &graphic = font.graphics[g.index];
+            graphic.offset_x = (int8_t)lrintf((float)(graphic.offset_x - pad) / scale);
+            graphic.offset_y = (int8_t)lrintf((float)(graphic.offset_y - pad) / scale);
+            graphic.x = (uint8_t)p.x;
+            graphic.y = (uint8_t)p.y;
+            graphic.width = (uint8_t)g.width;
+            graphic.height = (uint8_t)g.height;
+        }
+
+        // metrics are in atlas pixels
+
+        for(font_glyph &g : font.glyphs) {
+            g.advance = (uint8_t)lrintf((float)g.advance / scale);
+        }
+        for(font_kerning &k : font.kerning) {
+            k.amount = (int16_t)lrintf((float)k.amount / scale);
+        }
+        font.height = (int)lrintf((float)font.height / scale);
+        font.sdf_spread = spread;
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool compress(asset_pack_compression_t compression, std::vector<uint8_t> const &raw, std::vector<uint8_t> &out)
+    {
+        size_t raw_size = raw.size();
+        size_t num_pixels = raw_size / sizeof(uint32_t);
+
+        // worst cases are a little over raw_size for both codecs
+        out.resize(raw_size + raw_size / 64 + 64);
+
+        int size = -1;
+        switch(compression) {
+        case asset_pack_compression_none:
+            memcpy(out.data(), raw.data(), raw_size);
+            size = (int)raw_size;
+            break;
+        case asset_pack_compression_rle:
+            size = asset_rle_compress(reinterpret_cast<uint32_t const *>(raw.data()), num_pixels, out.data(), out.size());
+            break;
+        case asset_pack_compression_lz4:
+            size = asset_lz4_compress(raw.data(), raw_size, out.data(), out.size());
+            break;
+        }
+        if(size < 0) {
+            return false;
+        }
+        out.resize(size);
+
+        // make sure the firmware will get back exactly what went in
+
+        std::vector<uint8_t> check(raw_size);
+        int got = (int)raw_size;
+        switch(compression) {
+        case asset_pack_compression_none:
+            memcpy(check.data(), out.data(), raw_size);
+            break;
+        case asset_pack_compression_rle:
+            got = asset_rle_decompress(out.data(), out.size(), reinterpret_cast<uint32_t *>(check.data()), num_pixels);
+            break;
+        case asset_pack_compression_lz4:
+            got = asset_lz4_decompress(out.data(), out.size(), check.data(), raw_size);
+            break;
+        }
+        if(got != (int)raw_size || check != raw) {
+            fprintf(stderr, "%s round trip failed!\n", compression_names[compression]);
+            return false;
+        }
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool is_tintable(image const &img)
+    {
+        size_t visible = 0;
+        size_t dark = 0;
+
+        for(uint32_t p : img.pixels) {
+            uint32_t a = p >> 24;
+            if(a == 0) {
+                continue;
+            }
+            int r = (p >> 16) & 0xff;
+            int g = (p >> 8) & 0xff;
+            int b = p & 0xff;
+            if(std::max({ r, g, b }) - std::min({ r, g, b }) > grey_tolerance) {
+                return false;
+            }
+            visible += 1;
+            if(a > 32 && g < 128) {
+                dark += 1;
+            }
+        }
+        return dark * 100 <= visible * max_dark_percent;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // coverage is alpha * grey, what the atlas looks like over black. A4 rounds to the nearest of 16 levels
+
+    uint32_t coverage(uint32_t pixel)
+    {
+        return ((pixel >> 24) * ((pixel >> 8) & 0xff) + 127) / 255;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    void make_coverage(image const &img, asset &a, asset_pack_pixel_format_t format)
+    {
+        a.pixel_format = format;
+        a.width = img.width;
+        a.height = img.height;
+
+        if(format == asset_pack_pixel_format_a8) {
+            a.pixels.resize(img.pixels.size());
+            for(size_t i = 0; i < img.pixels.size(); ++i) {
+                a.pixels[i] = (uint8_t)coverage(img.pixels[i]);
+            }
+            return;
+        }
+
+        uint32_t stride = (img.width + 1) / 2;
+        a.pixels.assign(stride * img.height, 0);
+
+        for(uint32_t y = 0; y < img.height; ++y) {
+            for(uint32_t x = 0; x < img.width; ++x) {
+                uint32_t nibble = (coverage(img.pixels[x + y * img.width]) + 8) / 17;
+                a.pixels[x / 2 + y * stride] |= nibble << ((x & 1) ? 0 : 4);
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // 5:6:5 little endian, followed by the alpha byte unless the whole image is opaque
+
+    void make_rgb565(image const &img, asset &a)
+    {
+        bool opaque = std::all_of(img.pixels.begin(), img.pixels.end(), [](uint32_t p) { return (p >> 24) == 0xff; });
+
+        a.pixel_format = opaque ? asset_pack_pixel_format_rgb565 : asset_pack_pixel_format_argb8565;
+        a.width = img.width;
+        a.height = img.height;
+        a.pixels.clear();
+        a.pixels.reserve(img.pixels.size() * (opaque ? 2 : 3));
+
+        for(uint32_t p : img.pixels) {
+            uint32_t c = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+            a.pixels.push_back((uint8_t)c);
+            a.pixels.push_back((uint8_t)(c >> 8));
+            if(!opaque) {
+                a.pixels.push_back((uint8_t)(p >> 24));
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    char const *pixel_format_name(asset_pack_pixel_format_t format)
+    {
+        switch(format) {
+        case asset_pack_pixel_format_a8:
+            return "a8";
+        case asset_pack_pixel_format_a4:
+            return "a4";
+        case asset_pack_pixel_format_rgb565:
+            return "rgb565";
+        case asset_pack_pixel_format_argb8565:
+            return "argb8565";
+        default:
+            return "argb32";
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool pack_pixels(asset &a, int forced_compression)
+    {
+        std::vector<uint8_t> best;
+
+        for(int c = asset_pack_compression_none; c <= asset_pack_compression_lz4; ++c) {
+            if(forced_compression >= 0 && c != forced_compression) {
+                continue;
+            }
+            // RLE works on 32 bit pixels
+            if(c == asset_pack_compression_rle && a.pixel_format != asset_pack_pixel_format_argb32) {
+                continue;
+            }
+            std::vector<uint8_t> out;
+            if(!compress((asset_pack_compression_t)c, a.pixels, out)) {
+                fprintf(stderr, "Can't compress %s\n", a.name.c_str());
+                return false;
+            }
+            if(best.empty() || out.size() < best.size()) {
+                best.swap(out);
+                a.compression = (asset_pack_compression_t)c;
+            }
+        }
+        if(best.empty()) {
+            fprintf(stderr, "%s: can't use that compression for this pixel format\n", a.name.c_str());
+            return false;
+        }
+        a.packed.swap(best);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    std::string base_name(std::string const &filename)
+    {
+        size_t slash = filename.find_last_of("/\\");
+        std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+        return name.substr(0, name.find_last_of('.'));
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool ends_with(std::string const &s, char const *suffix)
+    {
+        size_t n = strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void align(std::vector<uint8_t> &data)
+    {
+        data.resize((data.size() + 3) & ~3);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool write_pack(std::string const &filename, std::vector<asset> const &assets)
+    {
+        if(assets.size() >= ASSET_PACK_HASH_EMPTY) {
+            fprintf(stderr, "Too many assets\n");
+            return false;
+        }
+
+        uint16_t hash_table_size = 1;
+        while(hash_table_size < assets.size() * 2) {
+            hash_table_size <<= 1;
+        }
+
+        asset_pack_header_t header = {};
+        header.magic = ASSET_PACK_MAGIC;
+        header.version = ASSET_PACK_VERSION;
+        header.num_assets = (uint16_t)assets.size();
+        header.hash_table_size = hash_table_size;
+        header.entries_offset = sizeof(header);
+        header.hash_table_offset = header.entries_offset + assets.size() * sizeof(asset_pack_entry_t);
+
+        std::vector<asset_pack_entry_t> entries(assets.size());
+        std::vector<uint16_t> hash_table(hash_table_size, ASSET_PACK_HASH_EMPTY);
+
+        std::vector<uint8_t> payload(header.hash_table_offset + hash_table_size * sizeof(uint16_t));
+        align(payload);
+
+        for(size_t i = 0; i < assets.size(); ++i) {
+
+            asset const &a = assets[i];
+            asset_pack_entry_t &e = entries[i];
+
+            strcpy(e.name, a.name.c_str());
+            e.name_hash = asset_pack_hash(e.name);
+            e.type = a.type;
+            e.pixel_format = a.pixel_format;
+            e.compression = a.compression;
+            e.width = (uint16_t)a.width;
+            e.height = (uint16_t)a.height;
+
+            e.data_offset = (uint32_t)payload.size();
+            e.data_size = (uint32_t)a.packed.size();
+            payload.insert(payload.end(), a.packed.begin(), a.packed.end());
+            align(payload);
+
+            if(!a.font.empty()) {
+                e.font_offset = (uint32_t)payload.size();
+                e.font_size = (uint32_t)a.font.size();
+                payload.insert(payload.end(), a.font.begin(), a.font.end());
+                align(payload);
+            }
+
+            uint32_t slot = e.name_hash & (hash_table_size - 1);
+            while(hash_table[slot] != ASSET_PACK_HASH_EMPTY) {
+                if(strcmp(entries[hash_table[slot]].name, e.name) == 0) {
+                    fprintf(stderr, "Duplicate asset name %s\n", e.name);
+                    return false;
+                }
+                slot = (slot + 1) & (hash_table_size - 1);
+            }
+            hash_table[slot] = (uint16_t)i;
+        }
+
+        header.total_size = (uint32_t)payload.size();
+
+        memcpy(payload.data(), &header, sizeof(header));
+        memcpy(payload.data() + header.entries_offset, entries.data(), entries.size() * sizeof(asset_pack_entry_t));
+        memcpy(payload.data() + header.hash_table_offset, hash_table.data(), hash_table.size() * sizeof(uint16_t));
+
+        FILE *f = fopen(filename.c_str(), "wb");
+        if(f == nullptr) {
+            fprintf(stderr, "Can't create %s\n", filename.c_str());
+            return false;
+        }
+        bool ok = fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+        ok = fclose(f) == 0 && ok;
+        if(!ok) {
+            fprintf(stderr, "Error writing %s\n", filename.c_str());
+            return false;
+        }
+        printf("Wrote %s, %zu assets, %u bytes\n", filename.c_str(), assets.size(), header.total_size);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void usage()
+    {
+        fprintf(stderr, "Usage: asset_compiler [-c auto|none|rle|lz4] [-alpha a4|a8|off] [-color rgb565|off] [-sdf-scale n] [-sdf-spread n] -o output.pack [-sdf] inputs(.png/.bitmapfont)...\n");
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    std::string output;
+    std::vector<std::string> inputs;
+    std::vector<bool> sdf_inputs;
+    int forced_compression = -1;
+    bool next_is_sdf = false;
+
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            char const *c = argv[++i];
+            forced_compression = -2;
+            if(strcmp(c, "auto") == 0) {
+                forced_compression = -1;
+            }
+            for(int n = 0; n < 3; ++n) {
+                if(strcmp(c, compression_names[n]) == 0) {
+                    forced_compression = n;
+                }
+            }
+            if(forced_compression == -2) {
+                usage();
+                return 1;
+            }
+        } else if(strcmp(argv[i], "-alpha") == 0 && i + 1 < argc) {
+            char const *f = argv[++i];
+            if(strcmp(f, "a4") == 0) {
+                alpha_format = asset_pack_pixel_format_a4;
+            } else if(strcmp(f, "a8") == 0) {
+                alpha_format = asset_pack_pixel_format_a8;
+            } else if(strcmp(f, "off") == 0) {
+                alpha_format = asset_pack_pixel_format_argb32;
+            } else {
+                usage();
+                return 1;
+            }
+        } else if(strcmp(argv[i], "-color") == 0 && i + 1 < argc) {
+            char const *f = argv[++i];
+            if(strcmp(f, "rgb565") == 0) {
+                rgb565 = true;
+            } else if(strcmp(f, "off") == 0) {
+                rgb565 = false;
+            } else {
+                usage();
+                return 1;
+            }
+        } else if(strcmp(argv[i], "-sdf-scale") == 0 && i + 1 < argc) {
+            sdf_scale = std::max(1, atoi(argv[++i]));
+        } else if(strcmp(argv[i], "-sdf-spread") == 0 && i + 1 < argc) {
+            sdf_spread = std::clamp(atoi(argv[++i]), 1, 32);
+        } else if(strcmp(argv[i], "-sdf") == 0) {
+            next_is_sdf = true;
+        } else {
+            inputs.push_back(argv[i]);
+            sdf_inputs.push_back(next_is_sdf);
+            next_is_sdf = false;
+        }
+    }
+
+    if(output.empty() || inputs.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::vector<asset> assets;
+
+    printf("%-24s %5s %9s %8s %9s %9s %9s %5s\n", "name", "type", "size", "format", "png", "raw", "packed", "codec");
+
+    for(size_t n = 0; n < inputs.size(); ++n) {
+
+        std::string const &filename = inputs[n];
+        bool sdf = sdf_inputs[n];
+
+        asset a;
+        a.name = base_name(filename);
+
+        std::string png_filename = filename;
+        font_tables font;
+
+        if(ends_with(filename, ".bitmapfont")) {
+            a.type = asset_pack_type_font;
+            if(!parse_font(filename, font)) {
+                return 1;
+            }
+            png_filename = filename.substr(0, filename.size() - strlen(".bitmapfont")) + "0.png";
+            if(sdf) {
+                a.name += "_sdf";
+            }
+        } else if(ends_with(filename, ".png") && !sdf) {
+            a.type = asset_pack_type_image;
+        } else {
+            fprintf(stderr, "Don't know what to do with %s\n", filename.c_str());
+            return 1;
+        }
+
+        if(a.name.size() >= ASSET_PACK_NAME_LEN) {
+            fprintf(stderr, "Asset name %s is too long\n", a.name.c_str());
+            return 1;
+        }
+
+        image img;
+        if(!decode_png(png_filename, img, a.source_size)) {
+            return 1;
+        }
+
+        if(sdf) {
+            if(!make_sdf_font(a.name, font, img, a, sdf_scale, sdf_spread)) {
+                return 1;
+            }
+        } else if(a.type == asset_pack_type_font && alpha_format != asset_pack_pixel_format_argb32 && is_tintable(img)) {
+            make_coverage(img, a, alpha_format);
+        } else if(rgb565) {
+            make_rgb565(img, a);
+        } else {
+            a.width = img.width;
+            a.height = img.height;
+            a.pixels.resize(img.pixels.size() * sizeof(uint32_t));
+            memcpy(a.pixels.data(), img.pixels.data(), a.pixels.size());
+        }
+
+        if(a.type == asset_pack_type_font) {
+            serialize_font(font, a.font);
+        }
+
+        if(!pack_pixels(a, forced_compression)) {
+            return 1;
+        }
+
+        char size[32];
+        snprintf(size, sizeof(size), "%ux%u", a.width, a.height);
+
+        printf("%-24s %5s %9s %8s %9zu %9zu %9zu %5s\n", a.name.c_str(), a.type == asset_pack_type_font ? "font" : "image", size,
+               pixel_format_name(a.pixel_format), a.source_size, a.pixels.size(), a.packed.size(),
+               compression_names[a.compression]);
+
+        assets.push_back(std::move(a));
+    }
+
+    return write_pack(output, assets) ? 0 : 1;
+}
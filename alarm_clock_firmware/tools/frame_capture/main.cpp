@@ -0,0 +1,450 @@
+//////////////////////////////////////////////////////////////////////
+// Decode a frame capture stream (see lcd_capture_format.h) saved from the capture port,
+// e.g. with `cat /dev/ttyACM0 > capture.bin` with the port in raw mode. Writes a PNG for
+// each frame which has all its pixels and a CSV of the section timings
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "lcd_capture_format.h"
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct frame_state
+    {
+        uint16_t width = 0;
+        uint16_t height = 0;
+        uint8_t bits_per_pixel = 0;
+
+        // what the panel memory holds, which with hardware scrolling isn't where it's shown
+        std::vector<uint8_t> rgb;           // 3 bytes per pixel
+        std::vector<bool> line_valid;       // has been drawn in this frame or an earlier one
+        bool active = false;
+        int scroll_top = 0;
+        int scroll_height = 0;
+        int scroll_offset = 0;
+        bool complete = true;
+        uint32_t frame = 0;
+    };
+
+    struct totals
+    {
+        uint32_t packets = 0;
+        uint32_t bad_packets = 0;
+        uint32_t frames = 0;
+        uint32_t frames_saved = 0;
+        uint32_t sections_skipped = 0;
+        uint32_t sections_dropped = 0;
+        uint64_t wait_us = 0;
+        uint64_t fill_us = 0;
+        uint64_t frame_us = 0;
+        uint32_t frame_intervals = 0;
+        uint32_t last_end_us = 0;
+        uint32_t last_end_frame = 0;
+        bool have_last_end = false;
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool load_file(char const *filename, std::vector<uint8_t> &data)
+    {
+        FILE *f = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "rb");
+        if(f == nullptr) {
+            return false;
+        }
+        uint8_t buffer[65536];
+        size_t got;
+        while((got = fread(buffer, 1, sizeof(buffer), f)) != 0) {
+            data.insert(data.end(), buffer, buffer + got);
+        }
+        if(f != stdin) {
+            fclose(f);
+        }
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    int pixel_size(int bits_per_pixel)
+    {
+        return bits_per_pixel == 16 ? 2 : 3;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // a header which could be real, the crc is checked once the data is there
+
+    bool header_ok(lcd_capture_header_t const &h)
+    {
+        if(h.magic != LCD_CAPTURE_MAGIC || h.version != LCD_CAPTURE_VERSION) {
+            return false;
+        }
+        if(h.type != lcd_capture_type_section && h.type != lcd_capture_type_frame_end) {
+            return false;
+        }
+        if((h.bits_per_pixel != 16 && h.bits_per_pixel != 18) || h.width == 0 || h.height == 0 || h.section_height == 0) {
+            return false;
+        }
+        if(h.section >= h.num_sections || h.num_sections * h.section_height < h.height) {
+            return false;
+        }
+        if(h.scroll_top + h.scroll_height > h.height || (h.scroll_height != 0 && h.scroll_offset >= h.scroll_height)) {
+            return false;
+        }
+        size_t num_pixels = (size_t)h.width * h.section_height;
+        return h.data_size <= LCD_CAPTURE_RLE_BOUND(num_pixels, (size_t)pixel_size(h.bits_per_pixel));
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    uint32_t packet_crc(lcd_capture_header_t h, uint8_t const *data)
+    {
+        h.crc = 0;
+        uLong crc = crc32(0, (Bytef const *)&h, sizeof(h));
+        return (uint32_t)crc32(crc, data, h.data_size);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // as sent to the panel, to 8 bits per channel
+
+    void to_rgb(uint8_t const *src, int bits_per_pixel, uint8_t *dst)
+    {
+        if(bits_per_pixel == 16) {
+            uint32_t p = (src[0] << 8) | src[1];
+            uint32_t r = (p >> 11) & 0x1f;
+            uint32_t g = (p >> 5) & 0x3f;
+            uint32_t b = p & 0x1f;
+            dst[0] = (uint8_t)((r << 3) | (r >> 2));
+            dst[1] = (uint8_t)((g << 2) | (g >> 4));
+            dst[2] = (uint8_t)((b << 3) | (b >> 2));
+        } else {
+            for(int i = 0; i < 3; ++i) {
+                dst[i] = (src[i] & 0xfc) | (src[i] >> 6);
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // see lcd_capture_format.h, false if it doesn't come out at exactly num_pixels
+
+    bool rle_decode(uint8_t const *src, size_t size, int bits_per_pixel, size_t num_pixels, uint8_t *rgb)
+    {
+        size_t const psize = pixel_size(bits_per_pixel);
+        uint8_t const *end = src + size;
+        size_t n = 0;
+
+        while(src < end) {
+
+            int count = *src++;
+
+            if(count < 128) {
+                size_t literal = count + 1;
+                if(n + literal > num_pixels || (size_t)(end - src) < literal * psize) {
+                    return false;
+                }
+                for(size_t i = 0; i < literal; ++i) {
+                    to_rgb(src, bits_per_pixel, rgb + n * 3);
+                    src += psize;
+                    n += 1;
+                }
+            } else {
+                size_t repeat = count - 126;
+                if(n + repeat > num_pixels || (size_t)(end - src) < psize) {
+                    return false;
+                }
+                uint8_t pixel[3];
+                to_rgb(src, bits_per_pixel, pixel);
+                src += psize;
+                for(size_t i = 0; i < repeat; ++i) {
+                    memcpy(rgb + n * 3, pixel, 3);
+                    n += 1;
+                }
+            }
+        }
+        return n == num_pixels;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void put_u32_be(std::vector<uint8_t> &v, uint32_t x)
+    {
+        v.push_back((uint8_t)(x >> 24));
+        v.push_back((uint8_t)(x >> 16));
+        v.push_back((uint8_t)(x >> 8));
+        v.push_back((uint8_t)x);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void put_chunk(std::vector<uint8_t> &png, char const *type, std::vector<uint8_t> const &data)
+    {
+        put_u32_be(png, (uint32_t)data.size());
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        put_u32_be(png, (uint32_t)crc32(0, png.data() + start, (uInt)(png.size() - start)));
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // 8 bit RGB, no filtering
+
+    bool write_png(char const *filename, uint8_t const *rgb, int width, int height)
+    {
+        std::vector<uint8_t> raw;
+        raw.reserve((size_t)(width * 3 + 1) * height);
+        for(int y = 0; y < height; ++y) {
+            raw.push_back(0);
+            raw.insert(raw.end(), rgb + (size_t)y * width * 3, rgb + (size_t)(y + 1) * width * 3);
+        }
+
+        std::vector<uint8_t> idat(compressBound((uLong)raw.size()));
+        uLongf idat_size = (uLongf)idat.size();
+        if(compress2(idat.data(), &idat_size, raw.data(), (uLong)raw.size(), 6) != Z_OK) {
+            return false;
+        }
+        idat.resize(idat_size);
+
+        std::vector<uint8_t> ihdr;
+        put_u32_be(ihdr, width);
+        put_u32_be(ihdr, height);
+        ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });
+
+        static uint8_t const signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+        std::vector<uint8_t> png(signature, signature + sizeof(signature));
+        put_chunk(png, "IHDR", ihdr);
+        put_chunk(png, "IDAT", idat);
+        put_chunk(png, "IEND", {});
+
+        FILE *f = fopen(filename, "wb");
+        if(f == nullptr) {
+            return false;
+        }
+        bool ok = fwrite(png.data(), 1, png.size(), f) == png.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // the panel memory line a screen line shows, see lcd_capture_format.h
+
+    int memory_line(frame_state const &state, int y)
+    {
+        int i = y - state.scroll_top;
+        if(state.scroll_height == 0 || i < 0 || i >= state.scroll_height) {
+            return y;
+        }
+        return state.scroll_top + (state.scroll_offset + i) % state.scroll_height;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // a new frame (or a change of format) starts over, sections which weren't sent keep
+    // what the panel memory held before
+
+    void begin_frame(frame_state &state, lcd_capture_header_t const &h)
+    {
+        if(h.width != state.width || h.height != state.height || h.bits_per_pixel != state.bits_per_pixel) {
+            state.width = h.width;
+            state.height = h.height;
+            state.bits_per_pixel = h.bits_per_pixel;
+            state.rgb.assign((size_t)h.width * h.height * 3, 0);
+            state.line_valid.assign(h.height, false);
+        }
+
+        // the capture restarted, nothing from before can be trusted
+        if(h.frame == 0 || (state.active && h.frame < state.frame)) {
+            state.line_valid.assign(h.height, false);
+        }
+        state.active = true;
+        state.complete = true;
+        state.frame = h.frame;
+        state.scroll_top = h.scroll_top;
+        state.scroll_height = h.scroll_height;
+        state.scroll_offset = h.scroll_offset;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_section(frame_state &state, totals &t, lcd_capture_header_t const &h, uint8_t const *data, FILE *csv)
+    {
+        if(!state.active || h.frame != state.frame || h.width != state.width || h.height != state.height) {
+            begin_frame(state, h);
+        }
+
+        fprintf(csv, "%u,%u,%u,%u,%u,%u\n", h.frame, h.section, h.time_us, h.wait_us, h.fill_us, h.flags);
+
+        t.wait_us += h.wait_us;
+        t.fill_us += h.fill_us;
+
+        int y0 = h.section * h.section_height;
+        int lines = std::min((int)h.section_height, (int)h.height - y0);
+
+        if(h.flags & lcd_capture_flag_skipped) {
+            t.sections_skipped += 1;
+            for(int y = y0; y < y0 + lines; ++y) {
+                state.complete &= state.line_valid[memory_line(state, y)];
+            }
+            return;
+        }
+
+        if((h.flags & lcd_capture_flag_dropped) || h.data_size == 0) {
+            t.sections_dropped += 1;
+            state.complete = false;
+            for(int y = y0; y < y0 + lines; ++y) {
+                state.line_valid[memory_line(state, y)] = false;
+            }
+            return;
+        }
+
+        // the last section can hang off the bottom of the panel
+        size_t num_pixels = (size_t)h.width * h.section_height;
+        std::vector<uint8_t> section_rgb(num_pixels * 3);
+
+        if(!rle_decode(data, h.data_size, h.bits_per_pixel, num_pixels, section_rgb.data())) {
+            fprintf(stderr, "Frame %u section %u: bad pixel data\n", h.frame, h.section);
+            t.bad_packets += 1;
+            state.complete = false;
+            return;
+        }
+
+        // the filler draws every line, including any the panel already had, so they're all
+        // what the screen shows
+        size_t line_bytes = (size_t)h.width * 3;
+
+        for(int y = y0; y < y0 + lines; ++y) {
+            int m = memory_line(state, y);
+            memcpy(state.rgb.data() + m * line_bytes, section_rgb.data() + (y - y0) * line_bytes, line_bytes);
+            state.line_valid[m] = true;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_frame_end(frame_state &state, totals &t, lcd_capture_header_t const &h, std::string const &out_dir, FILE *csv)
+    {
+        fprintf(csv, "%u,end,%u,%u,%u,%u\n", h.frame, h.time_us, h.wait_us, h.fill_us, h.flags);
+
+        t.frames += 1;
+
+        if(t.have_last_end && h.frame == t.last_end_frame + 1) {
+            t.frame_us += (uint32_t)(h.time_us - t.last_end_us);
+            t.frame_intervals += 1;
+        }
+        t.have_last_end = true;
+        t.last_end_us = h.time_us;
+        t.last_end_frame = h.frame;
+
+        // every section has to have been seen
+        if(!state.active || h.frame != state.frame) {
+            state.active = false;
+            return;
+        }
+        state.active = false;
+
+        if(!state.complete) {
+            return;
+        }
+
+        // as the screen shows it
+        size_t line_bytes = (size_t)state.width * 3;
+        std::vector<uint8_t> screen(state.rgb.size());
+
+        for(int y = 0; y < state.height; ++y) {
+            memcpy(screen.data() + y * line_bytes, state.rgb.data() + memory_line(state, y) * line_bytes, line_bytes);
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "frame_%06u.png", h.frame);
+        std::string filename = out_dir + "/" + name;
+
+        if(!write_png(filename.c_str(), screen.data(), state.width, state.height)) {
+            fprintf(stderr, "Can't write %s\n", filename.c_str());
+            return;
+        }
+        t.frames_saved += 1;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    if(argc != 3) {
+        fprintf(stderr, "usage: frame_capture <capture file or -> <output folder>\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> data;
+
+    if(!load_file(argv[1], data)) {
+        fprintf(stderr, "Can't load %s\n", argv[1]);
+        return 1;
+    }
+
+    std::string out_dir = argv[2];
+
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+
+    std::string csv_name = out_dir + "/timings.csv";
+    FILE *csv = fopen(csv_name.c_str(), "w");
+    if(csv == nullptr) {
+        fprintf(stderr, "Can't create %s\n", csv_name.c_str());
+        return 1;
+    }
+    fprintf(csv, "frame,section,time_us,wait_us,fill_us,flags\n");
+
+    frame_state state;
+    totals t;
+    size_t other_bytes = 0;
+
+    // the console shares the port so anything which isn't a good packet is skipped a byte at a time
+    size_t pos = 0;
+
+    while(pos + sizeof(lcd_capture_header_t) <= data.size()) {
+
+        lcd_capture_header_t h;
+        memcpy(&h, data.data() + pos, sizeof(h));
+
+        uint8_t const *payload = data.data() + pos + sizeof(h);
+
+        if(!header_ok(h) || h.data_size > data.size() - pos - sizeof(h) || packet_crc(h, payload) != h.crc) {
+            pos += 1;
+            other_bytes += 1;
+            continue;
+        }
+
+        pos += sizeof(h) + h.data_size;
+        t.packets += 1;
+
+        if(h.type == lcd_capture_type_section) {
+            on_section(state, t, h, payload, csv);
+        } else {
+            on_frame_end(state, t, h, out_dir, csv);
+        }
+    }
+
+    fclose(csv);
+
+    printf("%u packets, %zu other bytes, %u bad packets\n", t.packets, other_bytes + (data.size() - pos), t.bad_packets);
+    printf("%u frames, %u saved as PNG, %u sections skipped, %u dropped\n", t.frames, t.frames_saved, t.sections_skipped, t.sections_dropped);
+
+    if(t.frames != 0) {
+        printf("per frame: wait %.1f us, fill %.1f us\n", (double)t.wait_us / t.frames, (double)t.fill_us / t.frames);
+    }
+    if(t.frame_intervals != 0) {
+        double frame_us = (double)t.frame_us / t.frame_intervals;
+        printf("frame interval %.1f us (%.1f fps)\n", frame_us, 1e6 / frame_us);
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////
+// Host stand-in for the subset of ROM miniz which pngle uses, on top of zlib
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef unsigned long mz_ulong;
+typedef uint8_t mz_uint8;
+
+#define MZ_CRC32_INIT 0
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+#define TINFL_FLAG_PARSE_ZLIB_HEADER 1
+#define TINFL_FLAG_HAS_MORE_INPUT 2
+
+typedef enum
+{
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+typedef struct tinfl_decompressor
+{
+    z_stream stream;
+    int initialized;
+} tinfl_decompressor;
+
+//////////////////////////////////////////////////////////////////////
+
+static inline mz_ulong mz_crc32(mz_ulong crc, const mz_uint8 *ptr, size_t len)
+{
+    return crc32(crc, ptr, (uInt)len);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static inline void tinfl_init(tinfl_decompressor *r)
+{
+    if(r->initialized) {
+        inflateEnd(&r->stream);
+    }
+    r->initialized = 0;
+}
+
+//////////////////////////////////////////////////////////////////////
+// zlib keeps its own window so the output only has to be contiguous from next_out
+
+static inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const mz_uint8 *in, size_t *in_bytes, mz_uint8 *out_start, mz_uint8 *out_next,
+                                            size_t *out_bytes, uint32_t flags)
+{
+    (void)out_start;
+    (void)flags;
+
+    if(!r->initialized) {
+        r->stream.zalloc = Z_NULL;
+        r->stream.zfree = Z_NULL;
+        r->stream.opaque = Z_NULL;
+        r->stream.next_in = Z_NULL;
+        r->stream.avail_in = 0;
+        if(inflateInit(&r->stream) != Z_OK) {
+            return TINFL_STATUS_FAILED;
+        }
+        r->initialized = 1;
+    }
+
+    r->stream.next_in = (Bytef *)in;
+    r->stream.avail_in = (uInt)*in_bytes;
+    r->stream.next_out = out_next;
+    r->stream.avail_out = (uInt)*out_bytes;
+
+    int ret = inflate(&r->stream, Z_SYNC_FLUSH);
+
+    *in_bytes -= r->stream.avail_in;
+    *out_bytes -= r->stream.avail_out;
+
+    switch(ret) {
+    case Z_STREAM_END:
+        return TINFL_STATUS_DONE;
+    case Z_OK:
+    case Z_BUF_ERROR:
+        return r->stream.avail_out == 0 ? TINFL_STATUS_HAS_MORE_OUTPUT : TINFL_STATUS_NEEDS_MORE_INPUT;
+    default:
+        return TINFL_STATUS_FAILED;
+    }
+}
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,171 @@
+//////////////////////////////////////////////////////////////////////
+// Compare the per-pixel pngle draw callback (what image_decode_png used to do)
+// with the row callback fast path, decoding to ARGB32 like image.cpp does
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "pngle.h"
+
+//////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct image
+    {
+        std::vector<uint32_t> pixels;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_init(pngle_t *pngle, uint32_t w, uint32_t h)
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        img->width = w;
+        img->height = h;
+        img->pixels.assign(w * h, 0);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void setpixel(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t, uint32_t, uint8_t rgba[4])
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        uint32_t r = rgba[0] << 16;
+        uint32_t g = rgba[1] << 8;
+        uint32_t b = rgba[2] << 0;
+        uint32_t a = rgba[3] << 24;
+        img->pixels[x + y * img->width] = a | r | g | b;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    void on_row(pngle_t *pngle, uint32_t y, uint32_t w, uint8_t const *rgba)
+    {
+        image *img = (image *)pngle_get_user_data(pngle);
+        uint32_t *dst = img->pixels.data() + y * w;
+        for(uint32_t x = w; x != 0; --x) {
+            *dst++ = (rgba[3] << 24) | (rgba[0] << 16) | (rgba[1] << 8) | rgba[2];
+            rgba += 4;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool decode(std::vector<uint8_t> const &png, bool use_rows, image &img)
+    {
+        pngle_t *pngle = pngle_new();
+        pngle_set_user_data(pngle, &img);
+        pngle_set_init_callback(pngle, on_init);
+        pngle_set_draw_callback(pngle, setpixel);
+        if(use_rows) {
+            pngle_set_row_callback(pngle, on_row);
+        }
+        int err = pngle_feed(pngle, png.data(), png.size());
+        if(err < 0) {
+            fprintf(stderr, "pngle error: %s\n", pngle_error(pngle));
+        }
+        pngle_destroy(pngle);
+        return err >= 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    double time_decode(std::vector<uint8_t> const &png, bool use_rows, int iterations, image &img)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < iterations; ++i) {
+            if(!decode(png, use_rows, img)) {
+                return -1;
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / iterations;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+
+    bool load_file(char const *filename, std::vector<uint8_t> &data)
+    {
+        FILE *f = fopen(filename, "rb");
+        if(f == nullptr) {
+            return false;
+        }
+        fseek(f, 0, SEEK_END);
+        data.resize(ftell(f));
+        fseek(f, 0, SEEK_SET);
+        bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+        fclose(f);
+        return ok;
+    }
+
+}    // namespace
+
+//////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> files;
+
+    int iterations = 20;
+
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+
+    if(files.empty()) {
+        for(char const *name : { "image/world.png", "image/face.png", "image/blip.png", "font/Digits0.png", "font/Big0.png", "font/Segoe0.png",
+                                 "font/Cascadia0.png", "font/Forte0.png" }) {
+            files.push_back(std::string(ASSET_DIR) + "/" + name);
+        }
+    }
+
+    printf("%-24s %9s %12s %12s %8s\n", "file", "size", "pixel (ms)", "row (ms)", "speedup");
+
+    int result = 0;
+
+    for(std::string const &filename : files) {
+
+        std::vector<uint8_t> png;
+
+        if(!load_file(filename.c_str(), png)) {
+            fprintf(stderr, "Can't load %s\n", filename.c_str());
+            result = 1;
+            continue;
+        }
+
+        image pixel_image;
+        image row_image;
+
+        double pixel_ms = time_decode(png, false, iterations, pixel_image);
+        double row_ms = time_decode(png, true, iterations, row_image);
+
+        if(pixel_ms < 0 || row_ms < 0) {
+            result = 1;
+            continue;
+        }
+
+        if(pixel_image.pixels != row_image.pixels) {
+            fprintf(stderr, "%s: row output doesn't match per-pixel output!\n", filename.c_str());
+            result = 1;
+        }
+
+        std::string name = filename.substr(filename.find_last_of("/\\") + 1);
+        char size[32];
+        snprintf(size, sizeof(size), "%ux%u", pixel_image.width, pixel_image.height);
+
+        printf("%-24s %9s %12.3f %12.3f %7.2fx\n", name.c_str(), size, pixel_ms, row_ms, pixel_ms / row_ms);
+    }
+    return result;
+}